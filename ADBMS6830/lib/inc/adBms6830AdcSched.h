@@ -0,0 +1,56 @@
+/*******************************************************************************
+* @file:    adBms6830AdcSched.h
+* @brief:   Adc conversion scheduler header file
+*****************************************************************************/
+/** @addtogroup BMS_DRIVER
+*  @{
+*
+*/
+
+/** @addtogroup ADC_SCHED ADC CONVERSION SCHEDULER
+*  @{
+*
+*/
+#ifndef __ADBMSADCSCHED_H
+#define __ADBMSADCSCHED_H
+
+#include "common.h"
+
+/* Adc conversion, one per converter that can be polled on its own */
+typedef enum
+{
+  ADC_CONV_C = 0,   /* ADCV  : C-ADC cell voltages      */
+  ADC_CONV_S,       /* ADSV  : S-ADC cell voltages      */
+  ADC_CONV_AUX,     /* ADAX  : aux (GPIO, VMV, V+)      */
+  ADC_CONV_AUX2,    /* ADAX2 : redundant aux            */
+  ADC_CONV_NB
+} ADC_CONV;
+
+/* Conversion state, ADC_DONE is only returned by the poll that saw the
+   conversion finish */
+typedef enum
+{
+  ADC_IDLE = 0,     /* No conversion started / result consumed */
+  ADC_BUSY,         /* Conversion running                      */
+  ADC_DONE          /* Conversion finished, read the result    */
+} ADC_STATE;
+
+/* Measured conversion time statistics (us) */
+typedef struct
+{
+  uint32_t count;       /* Completed conversions         */
+  uint32_t probe_count; /* Poll probes sent on spi       */
+  uint32_t last_us;     /* Last conversion time          */
+  uint32_t min_us;      /* Shortest conversion time      */
+  uint32_t max_us;      /* Longest conversion time       */
+} adc_conv_stats_;
+
+void adBmsAdcSchedStart(ADC_CONV conv, bool ow);
+ADC_STATE adBmsAdcPoll(ADC_CONV conv);
+uint32_t adBmsAdcWait(ADC_CONV conv);
+const adc_conv_stats_ *adBmsAdcStats(ADC_CONV conv);
+void adBmsAdcClearStats(void);
+
+#endif
+/** @}*/
+/** @}*/
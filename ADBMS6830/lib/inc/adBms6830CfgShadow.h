@@ -0,0 +1,42 @@
+/*******************************************************************************
+* @file:    adBms6830CfgShadow.h
+* @brief:   Configuration register shadow header file
+*****************************************************************************/
+/** @addtogroup BMS_DRIVER
+*  @{
+*
+*/
+
+/** @addtogroup CFG_SHADOW CONFIGURATION SHADOW
+*  @{
+*
+*/
+#ifndef __ADBMSCFGSHADOW_H
+#define __ADBMSCFGSHADOW_H
+
+#include "common.h"
+#include "adBms6830Data.h"
+
+/* Configuration register bits */
+#define CFG_REG_A 0x01
+#define CFG_REG_B 0x02
+
+/* Shadow counters */
+typedef struct
+{
+  uint32_t write_count;     /* WRCFGA/WRCFGB sent                       */
+  uint32_t skip_count;      /* Register writes skipped, nothing changed */
+  uint32_t verify_count;    /* RDCFGA/RDCFGB verify passes              */
+  uint32_t mismatch_count;  /* Ics read back different from shadow      */
+} cfg_shadow_stats_;
+
+void adBmsCfgShadowNote(uint8_t tIC, const cmd_desc_ *cmd, const uint8_t *data);
+uint8_t adBmsCfgDirty(uint8_t tIC, cell_asic *ic, uint8_t *dirty);
+uint8_t adBmsCfgWrite(uint8_t tIC, cell_asic *ic);
+uint8_t adBmsCfgVerify(uint8_t tIC, cell_asic *ic);
+void adBmsCfgInvalidate(void);
+const cfg_shadow_stats_ *adBmsCfgStats(void);
+
+#endif
+/** @}*/
+/** @}*/
@@ -0,0 +1,36 @@
+/*******************************************************************************
+* @file:    adBms6830CmdCntr.h
+* @brief:   Command counter accounting header file
+*****************************************************************************/
+/** @addtogroup BMS_DRIVER
+*  @{
+*
+*/
+
+/** @addtogroup CMD_CNTR COMMAND COUNTER
+*  @{
+*
+*/
+#ifndef __ADBMSCMDCNTR_H
+#define __ADBMSCMDCNTR_H
+
+#include "common.h"
+#include "adBms6830Data.h"
+
+/* Command counter accounting counters */
+typedef struct
+{
+  uint32_t check_count;     /* Counters compared on a read back         */
+  uint32_t mismatch_count;  /* Read back counter different from expected */
+} cc_stats_;
+
+void adBmsCcSent(const cmd_desc_ *cmd);
+void adBmsCcCheck(uint8_t cic, uint8_t cmd_cntr);
+uint8_t adBmsCcMismatch(void);
+void adBmsCcClearMismatch(void);
+void adBmsCcReset(void);
+const cc_stats_ *adBmsCcStats(void);
+
+#endif
+/** @}*/
+/** @}*/
@@ -23,118 +23,121 @@ and its licensor.
 #define __ADBMSCOMMAND_H
 
 #include "common.h"
+#include "adBms6830Data.h"
+
+/* Command descriptors live in flash (adBms6830CmdList.c), command pec is precomputed */
 
 /* configuration registers commands */
-uint8_t WRCFGA[2]        = { 0x00, 0x01 };
-uint8_t WRCFGB[2]        = { 0x00, 0x24 };
-uint8_t RDCFGA[2]        = { 0x00, 0x02 };
-uint8_t RDCFGB[2]        = { 0x00, 0x26 };
+extern const cmd_desc_ WRCFGA;
+extern const cmd_desc_ WRCFGB;
+extern const cmd_desc_ RDCFGA;
+extern const cmd_desc_ RDCFGB;
 
 /* Read cell voltage result registers commands */
-uint8_t RDCVA[2]         = { 0x00, 0x04 };
-uint8_t RDCVB[2]         = { 0x00, 0x06 };
-uint8_t RDCVC[2]         = { 0x00, 0x08 };
-uint8_t RDCVD[2]         = { 0x00, 0x0A };
-uint8_t RDCVE[2]         = { 0x00, 0x09 };
-uint8_t RDCVF[2]         = { 0x00, 0x0B };
-uint8_t RDCVALL[2]       = { 0x00, 0x0C };
+extern const cmd_desc_ RDCVA;
+extern const cmd_desc_ RDCVB;
+extern const cmd_desc_ RDCVC;
+extern const cmd_desc_ RDCVD;
+extern const cmd_desc_ RDCVE;
+extern const cmd_desc_ RDCVF;
+extern const cmd_desc_ RDCVALL;
 
 /* Read average cell voltage result registers commands commands */
-uint8_t RDACA[2]         = { 0x00, 0x44 };
-uint8_t RDACB[2]         = { 0x00, 0x46 };
-uint8_t RDACC[2]         = { 0x00, 0x48 };
-uint8_t RDACD[2]         = { 0x00, 0x4A };
-uint8_t RDACE[2]         = { 0x00, 0x49 };
-uint8_t RDACF[2]         = { 0x00, 0x4B };
-uint8_t RDACALL[2]       = { 0x00, 0x4C };
+extern const cmd_desc_ RDACA;
+extern const cmd_desc_ RDACB;
+extern const cmd_desc_ RDACC;
+extern const cmd_desc_ RDACD;
+extern const cmd_desc_ RDACE;
+extern const cmd_desc_ RDACF;
+extern const cmd_desc_ RDACALL;
 
 /* Read s voltage result registers commands */
-uint8_t RDSVA[2]         = { 0x00, 0x03 };
-uint8_t RDSVB[2]         = { 0x00, 0x05 };
-uint8_t RDSVC[2]         = { 0x00, 0x07 };
-uint8_t RDSVD[2]         = { 0x00, 0x0D };
-uint8_t RDSVE[2]         = { 0x00, 0x0E };
-uint8_t RDSVF[2]         = { 0x00, 0x0F };
-uint8_t RDSALL[2]        = { 0x00, 0x10 };
+extern const cmd_desc_ RDSVA;
+extern const cmd_desc_ RDSVB;
+extern const cmd_desc_ RDSVC;
+extern const cmd_desc_ RDSVD;
+extern const cmd_desc_ RDSVE;
+extern const cmd_desc_ RDSVF;
+extern const cmd_desc_ RDSALL;
 
 /* Read c and s results */
-uint8_t RDCSALL[2]       = { 0x00, 0x11 };
-uint8_t RDACSALL[2]      = { 0x00, 0x51 };
+extern const cmd_desc_ RDCSALL;
+extern const cmd_desc_ RDACSALL;
 
 /* Read all AUX and all Status Registers */
-uint8_t RDASALL[2]       = { 0x00, 0x35 };
+extern const cmd_desc_ RDASALL;
 
 /* Read filtered cell voltage result registers*/
-uint8_t RDFCA[2]         = { 0x00, 0x12 };
-uint8_t RDFCB[2]         = { 0x00, 0x13 };
-uint8_t RDFCC[2]         = { 0x00, 0x14 };
-uint8_t RDFCD[2]         = { 0x00, 0x15 };
-uint8_t RDFCE[2]         = { 0x00, 0x16 };
-uint8_t RDFCF[2]         = { 0x00, 0x17 };
-uint8_t RDFCALL[2]       = { 0x00, 0x18 };
+extern const cmd_desc_ RDFCA;
+extern const cmd_desc_ RDFCB;
+extern const cmd_desc_ RDFCC;
+extern const cmd_desc_ RDFCD;
+extern const cmd_desc_ RDFCE;
+extern const cmd_desc_ RDFCF;
+extern const cmd_desc_ RDFCALL;
 
 /* Read aux results */
-uint8_t RDAUXA[2]        = { 0x00, 0x19 };
-uint8_t RDAUXB[2]        = { 0x00, 0x1A };
-uint8_t RDAUXC[2]        = { 0x00, 0x1B };
-uint8_t RDAUXD[2]        = { 0x00, 0x1F };
+extern const cmd_desc_ RDAUXA;
+extern const cmd_desc_ RDAUXB;
+extern const cmd_desc_ RDAUXC;
+extern const cmd_desc_ RDAUXD;
 
 /* Read redundant aux results */
-uint8_t RDRAXA[2]        = { 0x00, 0x1C };
-uint8_t RDRAXB[2]        = { 0x00, 0x1D };
-uint8_t RDRAXC[2]        = { 0x00, 0x1E };
-uint8_t RDRAXD[2]        = { 0x00, 0x25 };
+extern const cmd_desc_ RDRAXA;
+extern const cmd_desc_ RDRAXB;
+extern const cmd_desc_ RDRAXC;
+extern const cmd_desc_ RDRAXD;
 
 /* Read status registers */
-uint8_t RDSTATA[2]       = { 0x00, 0x30 };
-uint8_t RDSTATB[2]       = { 0x00, 0x31 };
-uint8_t RDSTATC[2]       = { 0x00, 0x32 };
-uint8_t RDSTATCERR[2]    = { 0x00, 0x72 };              /* ERR */
-uint8_t RDSTATD[2]       = { 0x00, 0x33 };
-uint8_t RDSTATE[2]       = { 0x00, 0x34 };
+extern const cmd_desc_ RDSTATA;
+extern const cmd_desc_ RDSTATB;
+extern const cmd_desc_ RDSTATC;
+extern const cmd_desc_ RDSTATCERR;  /* ERR */
+extern const cmd_desc_ RDSTATD;
+extern const cmd_desc_ RDSTATE;
 
 /* Pwm registers commands */
-uint8_t WRPWM1[2]        = { 0x00, 0x20 };
-uint8_t RDPWM1[2]        = { 0x00, 0x22 };
+extern const cmd_desc_ WRPWM1;
+extern const cmd_desc_ RDPWM1;
 
-uint8_t WRPWM2[2]        = { 0x00, 0x21 };
-uint8_t RDPWM2[2]        = { 0x00, 0x23 };
+extern const cmd_desc_ WRPWM2;
+extern const cmd_desc_ RDPWM2;
 
 /* Clear commands */
-uint8_t CLRCELL[2]       = { 0x07, 0x11 };
-uint8_t CLRAUX [2]       = { 0x07, 0x12 };
-uint8_t CLRSPIN[2]       = { 0x07, 0x16 };
-uint8_t CLRFLAG[2]       = { 0x07, 0x17 };
-uint8_t CLRFC[2]         = { 0x07, 0x14 };
-uint8_t CLOVUV[2]        = { 0x07, 0x15 };
+extern const cmd_desc_ CLRCELL;
+extern const cmd_desc_ CLRAUX;
+extern const cmd_desc_ CLRSPIN;
+extern const cmd_desc_ CLRFLAG;
+extern const cmd_desc_ CLRFC;
+extern const cmd_desc_ CLOVUV;
 
 /* Poll adc command */
-uint8_t PLADC[2]         = { 0x07, 0x18 };
-uint8_t PLAUT[2]         = { 0x07, 0x19 };
-uint8_t PLCADC[2]        = { 0x07, 0x1C };
-uint8_t PLSADC[2]        = { 0x07, 0x1D };
-uint8_t PLAUX1[2]        = { 0x07, 0x1E };
-uint8_t PLAUX2[2]        = { 0x07, 0x1F };
+extern const cmd_desc_ PLADC;
+extern const cmd_desc_ PLAUT;
+extern const cmd_desc_ PLCADC;
+extern const cmd_desc_ PLSADC;
+extern const cmd_desc_ PLAUX1;
+extern const cmd_desc_ PLAUX2;
 
 /* Diagn command */
-uint8_t DIAGN[2]         = {0x07 , 0x15};
+extern const cmd_desc_ DIAGN;
 
 /* GPIOs Comm commands */
-uint8_t WRCOMM[2]        = { 0x07, 0x21 };
-uint8_t RDCOMM[2]        = { 0x07, 0x22 };
-uint8_t STCOMM[13]       = { 0x07, 0x23, 0xB9, 0xE4 ,0x00 ,0x00 ,0x00 ,0x00 ,0x00 ,0x00 ,0x00 ,0x00 ,0x00};
+extern const cmd_desc_ WRCOMM;
+extern const cmd_desc_ RDCOMM;
+extern const uint8_t STCOMM[13];
 
 /* Mute and Unmute commands */
-uint8_t MUTE[2] 	       = { 0x00, 0x28 };
-uint8_t UNMUTE[2]        = { 0x00, 0x29 };
+extern const cmd_desc_ MUTE;
+extern const cmd_desc_ UNMUTE;
 
-uint8_t RSTCC[2]         = { 0x00, 0x2E };
-uint8_t SNAP[2]          = { 0x00, 0x2D };
-uint8_t UNSNAP[2]        = { 0x00, 0x2F };
-uint8_t SRST[2]          = { 0x00, 0x27 };
+extern const cmd_desc_ RSTCC;
+extern const cmd_desc_ SNAP;
+extern const cmd_desc_ UNSNAP;
+extern const cmd_desc_ SRST;
 
 /* Read SID command */
-uint8_t RDSID[2]         = { 0x00, 0x2C };
+extern const cmd_desc_ RDSID;
 
 #endif /* __BMS_COMMAND_H */
 /** @}*/
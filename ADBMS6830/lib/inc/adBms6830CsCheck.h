@@ -0,0 +1,47 @@
+/*******************************************************************************
+* @file:    adBms6830CsCheck.h
+* @brief:   C-ADC vs S-ADC cross check header file
+*****************************************************************************/
+/** @addtogroup BMS_DRIVER
+*  @{
+*
+*/
+
+/** @addtogroup CS_CHECK C VS S CROSS CHECK
+*  @{
+*
+*/
+#ifndef __ADBMSCSCHECK_H
+#define __ADBMSCSCHECK_H
+
+#include "common.h"
+#include "adBms6830Data.h"
+
+#define CS_TOL_DEFAULT_UV     10000   /* C/S difference of a bad cell, above CTH 8.1 mV */
+#define CS_DEBOUNCE_DEFAULT   3       /* Consecutive compares to change a cell state    */
+
+/* Cross check settings */
+typedef struct
+{
+  int32_t tol_uv;       /* C/S difference above which a cell disagrees     */
+  uint8_t debounce;     /* Consecutive compares to set or clear a cell     */
+} cs_cfg_;
+
+/* Cross check counters */
+typedef struct
+{
+  uint32_t check_count;     /* Ic compares                                */
+  uint32_t disagree_count;  /* Cell compares above tolerance              */
+  uint32_t fault_count;     /* Cells that went to disagree after debounce */
+} cs_stats_;
+
+void adBmsCsConfig(const cs_cfg_ *cfg);
+uint32_t adBmsCsCheck(uint8_t tIC, cell_asic *ic, uint32_t ic_mask);
+uint32_t adBmsCsFaultMask(void);
+uint16_t adBmsCsCellMask(uint8_t cic);
+void adBmsCsReset(void);
+const cs_stats_ *adBmsCsStats(void);
+
+#endif
+/** @}*/
+/** @}*/
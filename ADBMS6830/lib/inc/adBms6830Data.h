@@ -42,6 +42,11 @@ and its licensor.
 #define RDASALL_SIZE 70  /* RDASALL data byte size             */
 #define RDACSALL_SIZE 66 /* RDACSALL data byte size            */
 
+#ifndef MAX_IC
+#define MAX_IC 16        /* Max bms ic in daisy chain, sizes the static driver buffers */
+#endif
+#define MAX_RX_SIZE RDASALL_SIZE /* Largest per ic read response (RDASALL) */
+
 /* For ADBMS6830 config register structure */
 typedef struct
 {
@@ -240,6 +245,7 @@ typedef struct
   uint8_t fuse_ed;
   uint8_t fuse_med;
   uint8_t tmodchk;
+  uint8_t cs_flt;
   uint8_t cell_ow[CELL];
   uint8_t cellred_ow[CELL];
   uint8_t aux_ow[(AUX - 2)];
@@ -296,6 +302,56 @@ typedef struct
   diag_test_ diag_result;
 } cell_asic;
 
+/* Adc code scaling, fixed point: 150 uV per lsb around a 1.5 V offset */
+#define CODE_LSB_UV       150
+#define CODE_OFFSET_UV    1500000
+#define CODE_TO_UV(code)  (((int32_t)(code) * CODE_LSB_UV) + CODE_OFFSET_UV)
+
+/* Die temperature (status A itmp) in 0.01 degC: T = V / 7.5 mV - 273 */
+#define ITMP_TO_CDEG(code) ((int16_t)((CODE_TO_UV(code) / 75) - 27300))
+
+/* Pack store data type bits (pec error and dirty) */
+#define PACK_PEC_CELL  0x01
+#define PACK_PEC_SCELL 0x02
+#define PACK_PEC_AUX   0x04
+#define PACK_PEC_STAT  0x08
+
+/* Pack level measurement store, struct of arrays over the whole chain.
+   Code arrays are ic major: ic n cell m is cell[(n * CELL) + m]. Only reads
+   with a good pec are stored, a failed read keeps the last good codes and
+   sets their stale bits. */
+typedef struct
+{
+  uint8_t tIC;                  /* ICs written by the last read       */
+  int16_t cell[MAX_IC * CELL];  /* C-ADC cell voltage codes           */
+  int16_t scell[MAX_IC * CELL]; /* S-ADC cell voltage codes           */
+  int16_t aux[MAX_IC * AUX];    /* GPIO1-10, VMV, V+ codes            */
+  uint16_t vref2[MAX_IC];       /* Status A second reference          */
+  uint16_t itmp[MAX_IC];        /* Status A die temperature           */
+  uint16_t c_ov[MAX_IC];        /* Status D cell over voltage, bit/cell  */
+  uint16_t c_uv[MAX_IC];        /* Status D cell under voltage, bit/cell */
+  uint16_t cell_stale[MAX_IC];  /* Cell codes kept over a failed read, bit/cell  */
+  uint16_t scell_stale[MAX_IC]; /* S-ADC codes kept over a failed read, bit/cell */
+  uint16_t aux_stale[MAX_IC];   /* Aux codes kept over a failed read, bit/code  */
+  uint8_t cmd_cntr[MAX_IC];     /* Command counter of the last read   */
+  uint8_t pec_err[MAX_IC];      /* PACK_PEC_x bits of the last reads  */
+  uint8_t dirty[MAX_IC];        /* PACK_PEC_x bits written since the
+                                   consumer last cleared them         */
+} pack_store_;
+
+/* Driver transaction counters (static buffers, no heap) */
+typedef struct
+{
+  uint32_t cmd_count;   /* Command only frames        */
+  uint32_t read_count;  /* Read transactions          */
+  uint32_t write_count; /* Write transactions         */
+  uint32_t poll_count;  /* Poll adc transactions      */
+  uint32_t tx_bytes;    /* Bytes clocked out on mosi  */
+  uint32_t rx_bytes;    /* Bytes clocked in on miso   */
+  uint32_t reject_count;/* Rejected, tIC > MAX_IC     */
+  uint32_t busy_count;  /* Refused, dma read pending  */
+} xfer_stats_;
+
 /*!
  *  \enum Loop Measurement ENABLED or DISABLED.
  */
@@ -305,6 +361,12 @@ typedef enum
   ENABLED = 0X1
 } LOOP_MEASURMENT;
 
+typedef enum
+{
+  READ_GROUP = 0X0, /* One read per register group (RDCVA..RDCVF) */
+  READ_ALL = 0X1    /* One *ALL bulk read (RDCVALL, RDCSALL, RDASALL) */
+} LOOP_READ_MODE;
+
 /**************************************** CMDEnums *************************************************/
 /*!
  *  \enum GPIO CHANNEL
@@ -735,8 +797,28 @@ typedef enum
   Rdcsall,
   Rdacsall,
   Rdfcall,
-  Rdasall
+  Rdasall,
+  Cmd
 } TYPE;
+
+/* Command kind */
+typedef enum
+{
+  CMD_ONLY = 0x0,  /* Command only                  */
+  CMD_WRITE,       /* Command + register write data */
+  CMD_READ,        /* Command + register read back  */
+  CMD_POLL         /* Command + sdo polling         */
+} CMD_KIND;
+
+/* Command descriptor, frame holds the precomputed command pec */
+typedef struct
+{
+  uint8_t frame[4]; /* Cmd0, Cmd1, Pec15 msb, Pec15 lsb         */
+  uint8_t kind;     /* CMD_KIND                                 */
+  uint8_t rx_size;  /* Read back bytes per ic incl. pec         */
+  uint8_t type;     /* TYPE of the register data                */
+  uint8_t grp;      /* GRP of the register data                 */
+} cmd_desc_;
 typedef enum
 {
   PASS,
@@ -749,7 +831,8 @@ typedef enum
   THSD,
   FUSE_ED,
   FUSE_MED,
-  TMODCHK
+  TMODCHK,
+  CS_FLT
 } DIAGNOSTIC_TYPE;
 #endif /* __BMS_DATA_H */
 
@@ -23,6 +23,9 @@ and its licensor.
 
 #include "adbms_main.h"
 
+/* Ic mask of adBmsReadDataMask, bit n = ic n in the chain */
+#define READ_IC_ALL 0xFFFFFFFFu
+
 /* Calculates and returns the CRC15Table */
 uint16_t Pec15_Calc
 ( 
@@ -30,25 +33,34 @@ uint16_t Pec15_Calc
   uint8_t *data /* Array of data that will be used to calculate  a PEC */								 
 );									 
 uint16_t pec10_calc(bool rx_cmd, int len, uint8_t *data);
-void spiSendCmd(uint8_t tx_cmd[2]);
+uint16_t pec10_calc_slice4(bool rx_cmd, int len, uint8_t *data);
+void adBmsMakeCmd(cmd_desc_ *cmd, uint8_t cmd0, uint8_t cmd1);
+void spiSendCmd(const cmd_desc_ *cmd);
 void spiReadData
 ( 
 uint8_t tIC, 
-uint8_t tx_cmd[2], 
+const cmd_desc_ *cmd,
 uint8_t *rx_data,
 uint8_t *pec_error,
-uint8_t *cmd_cntr,
-uint8_t regData_size
+uint8_t *cmd_cntr
 );
 void spiWriteData
 (
   uint8_t tIC, 
-  uint8_t tx_cmd[2], 
+  const cmd_desc_ *cmd,
   uint8_t *data
 );
-void adBmsReadData(uint8_t tIC, cell_asic *ic, uint8_t cmd_arg[2], TYPE type, GRP group);
-void adBmsWriteData(uint8_t tIC, cell_asic *ic, uint8_t cmd_arg[2], TYPE type, GRP group);
-uint32_t adBmsPollAdc(uint8_t tx_cmd[2]);
+void adBmsReadData(uint8_t tIC, cell_asic *ic, const cmd_desc_ *cmd);
+void adBmsReadDataMask(uint8_t tIC, cell_asic *ic, const cmd_desc_ *cmd, uint32_t ic_mask);
+uint32_t adBmsReadPecMask(uint8_t tIC, cell_asic *ic, const cmd_desc_ *cmd);
+bool adBmsReadDataStart(uint8_t tIC, cell_asic *ic, const cmd_desc_ *cmd, void (*done_cb)(void));
+bool adBmsReadDataFinish(void);
+void adBmsWriteData(uint8_t tIC, cell_asic *ic, const cmd_desc_ *cmd);
+bool adBmsProbeAdc(const cmd_desc_ *cmd);
+void adBmsSetPackStore(pack_store_ *pack);
+pack_store_ *adBmsGetPackStore(void);
+const xfer_stats_ *adBmsGetXferStats(void);
+void adBmsClearXferStats(void);
 void adBms6830_Adcv
 (
   RD rd,
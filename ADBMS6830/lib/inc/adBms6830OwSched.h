@@ -0,0 +1,65 @@
+/*******************************************************************************
+* @file:    adBms6830OwSched.h
+* @brief:   Open wire detection header file
+*****************************************************************************/
+/** @addtogroup BMS_DRIVER
+*  @{
+*
+*/
+
+/** @addtogroup OW_SCHED OPEN WIRE DETECTION
+*  @{
+*
+*/
+#ifndef __ADBMSOWSCHED_H
+#define __ADBMSOWSCHED_H
+
+#include "common.h"
+#include "adBms6830Data.h"
+
+#define OW_PERIOD_DEFAULT_MS    1000      /* Idle time between two sequences       */
+#define OW_CELL_TH_DEFAULT_UV   2000000   /* Even/odd difference of an open cell    */
+#define OW_AUX_TH_DEFAULT_UV    50000     /* Pull-up/down difference of an open gpio */
+
+/* Background open wire sequence, one step per adc conversion */
+typedef enum
+{
+  OW_STEP_IDLE = 0,   /* Normal acquisition owns the adcs        */
+  OW_STEP_CELL_EVEN,  /* ADSV, current on even channels          */
+  OW_STEP_CELL_ODD,   /* ADSV, current on odd channels           */
+  OW_STEP_AUX_UP,     /* ADAX, gpio pull-up current              */
+  OW_STEP_AUX_DOWN,   /* ADAX, gpio pull-down current            */
+  OW_STEP_SETTLE,     /* ADSV + ADAX without current, discarded  */
+  OW_STEP_NB
+} OW_STEP;
+
+/* Open wire detection settings */
+typedef struct
+{
+  uint32_t period_ms;   /* Idle time between two sequences             */
+  int32_t cell_th_uv;   /* Even/odd difference to flag a cell wire     */
+  int32_t aux_th_uv;    /* Pull-up/down difference to flag a gpio wire */
+} ow_cfg_;
+
+/* Open wire detection counters */
+typedef struct
+{
+  uint32_t run_count;   /* Completed sequences                          */
+  uint32_t cell_open;   /* Cell wires flagged by the last sequence      */
+  uint32_t aux_open;    /* Gpio wires flagged by the last sequence      */
+  uint32_t skip_count;  /* Ic results dropped on a read pec error       */
+} ow_stats_;
+
+void adBmsOwCellStore(uint8_t tIC, cell_asic *ic, TYPE type, OW_C_S owcs);
+void adBmsOwAuxStore(uint8_t tIC, cell_asic *ic, PUP pup);
+uint32_t adBmsOwCellCheck(uint8_t tIC, cell_asic *ic, TYPE type, int32_t th_uv, uint32_t ic_mask);
+uint32_t adBmsOwAuxCheck(uint8_t tIC, cell_asic *ic, int32_t th_uv, uint32_t ic_mask);
+void adBmsOwConfig(const ow_cfg_ *cfg);
+bool adBmsOwStep(uint8_t tIC, cell_asic *ic);
+uint32_t adBmsOwOpenMask(void);
+void adBmsOwReset(void);
+const ow_stats_ *adBmsOwStats(void);
+
+#endif
+/** @}*/
+/** @}*/
@@ -24,8 +24,8 @@ and its licensor.
 #include "common.h"
 #include "adBms6830Data.h"
 
-uint16_t SetOverVoltageThreshold(float volt);
-uint16_t SetUnderVoltageThreshold(float voltage);
+uint16_t SetOverVoltageThreshold(int32_t volt);
+uint16_t SetUnderVoltageThreshold(int32_t voltage);
 uint8_t ConfigA_Flag(FLAG_D flag_d, CFGA_FLAG flag);
 uint16_t ConfigA_Gpo(GPO gpo, CFGA_GPO stat);
 uint16_t ConfigB_DccBit(DCC dcc, DCC_BIT dccbit);
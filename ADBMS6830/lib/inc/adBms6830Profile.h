@@ -0,0 +1,68 @@
+/*******************************************************************************
+* @file:    adBms6830Profile.h
+* @brief:   Cycle counter profiling header file
+*****************************************************************************/
+/** @addtogroup BMS_DRIVER
+*  @{
+*
+*/
+
+/** @addtogroup PROFILE CYCLE PROFILING
+*  @{
+*
+*/
+#ifndef __ADBMSPROFILE_H
+#define __ADBMSPROFILE_H
+
+#include "common.h"
+
+/* Build with -DPROFILE_ENABLE=1 to instrument; otherwise the scope macros,
+   the scope table and the dump code compile to nothing */
+#ifndef PROFILE_ENABLE
+#define PROFILE_ENABLE 0
+#endif
+
+#define PROF_HIST_BINS 32     /* Bin n counts durations of 2^n to 2^(n+1)-1 cycles */
+
+/* Profiled scopes */
+typedef enum
+{
+  PROF_UPDATE_VALUES = 0,     /* Acquisition tick                       */
+  PROF_CALC_VALUES,           /* Pack values from the codes             */
+  PROF_CHECK_FAULTS,          /* Fault checks                           */
+  PROF_FSM_RUN,               /* State machine step                     */
+  PROF_SPI,                   /* One isoSpi frame, wake pulses excluded */
+  PROF_PARSE,                 /* Pec check and parse of one read frame  */
+  PROF_CAN_PACK,              /* One can frame packed                   */
+  PROF_NB
+} PROF_SCOPE;
+
+/* Durations of one scope, in core cycles */
+typedef struct
+{
+  uint32_t count;                   /* Completed scopes              */
+  uint32_t min;
+  uint32_t max;
+  uint64_t sum;                     /* Mean = sum / count            */
+  uint32_t hist[PROF_HIST_BINS];    /* log2 histogram                */
+  uint32_t start;                   /* Cycle count of the open scope */
+} prof_scope_;
+
+#if PROFILE_ENABLE
+#define PROF_BEGIN(scope)   adBmsProfBegin(scope)
+#define PROF_END(scope)     adBmsProfEnd(scope)
+
+void adBmsProfBegin(PROF_SCOPE scope);
+void adBmsProfEnd(PROF_SCOPE scope);
+const prof_scope_ *adBmsProfScope(PROF_SCOPE scope);
+const char *adBmsProfName(PROF_SCOPE scope);
+uint32_t adBmsProfMean(PROF_SCOPE scope);
+void adBmsProfReset(void);
+#else
+#define PROF_BEGIN(scope)   do { } while(0)
+#define PROF_END(scope)     do { } while(0)
+#endif
+
+#endif
+/** @}*/
+/** @}*/
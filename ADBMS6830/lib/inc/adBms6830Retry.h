@@ -0,0 +1,53 @@
+/*******************************************************************************
+* @file:    adBms6830Retry.h
+* @brief:   Read retry policy header file
+*****************************************************************************/
+/** @addtogroup BMS_DRIVER
+*  @{
+*
+*/
+
+/** @addtogroup READ_RETRY READ RETRY
+*  @{
+*
+*/
+#ifndef __ADBMSRETRY_H
+#define __ADBMSRETRY_H
+
+#include "common.h"
+#include "adBms6830Data.h"
+
+#define RETRY_MAX_DEFAULT     2   /* Retries of one read                     */
+#define RETRY_BUDGET_DEFAULT  4   /* Retries of all reads between two ticks  */
+#define RETRY_FAULT_DEFAULT   3   /* Consecutive failed reads to a fault     */
+
+/* Read retry policy */
+typedef struct
+{
+  uint8_t max_retry;    /* Retries of one read, 0 = no retry              */
+  uint8_t tick_budget;  /* Retries allowed between two adBmsRetryTick     */
+  uint8_t fault_after;  /* Consecutive failed reads of a register to fault */
+} retry_cfg_;
+
+/* Read retry counters */
+typedef struct
+{
+  uint32_t read_count;      /* Reads checked for retry                  */
+  uint32_t fail_count;      /* Reads with at least one ic pec error     */
+  uint32_t retry_count;     /* Retry reads sent                         */
+  uint32_t recovered_count; /* Ic reads made good by a retry            */
+  uint32_t budget_count;    /* Retries skipped, tick budget used up     */
+  uint32_t fault_count;     /* Ic registers that reached fault_after    */
+} retry_stats_;
+
+void adBmsRetryConfig(const retry_cfg_ *cfg);
+void adBmsRetryTick(void);
+uint32_t adBmsReadRetry(uint8_t tIC, cell_asic *ic, const cmd_desc_ *cmd);
+uint32_t adBmsRetryFailing(uint8_t tIC, cell_asic *ic, const cmd_desc_ *cmd);
+uint32_t adBmsRetryFaults(void);
+void adBmsRetryReset(void);
+const retry_stats_ *adBmsRetryStats(void);
+
+#endif
+/** @}*/
+/** @}*/
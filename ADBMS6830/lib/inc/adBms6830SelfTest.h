@@ -0,0 +1,64 @@
+/*******************************************************************************
+* @file:    adBms6830SelfTest.h
+* @brief:   Rotating self test scheduler header file
+*****************************************************************************/
+/** @addtogroup BMS_DRIVER
+*  @{
+*
+*/
+
+/** @addtogroup SELF_TEST SELF TEST
+*  @{
+*
+*/
+#ifndef __ADBMSSELFTEST_H
+#define __ADBMSSELFTEST_H
+
+#include "common.h"
+#include "adBms6830Data.h"
+
+#define ST_PERIOD_DEFAULT_MS  10000   /* Each test once per 10 s           */
+#define ST_SETTLE_DEFAULT_MS  2       /* FLAG_D forced to status C read    */
+#define ST_AGE_NEVER          0xFFFFFFFFu
+
+/* Self tests, all checked on status C */
+typedef enum
+{
+  ST_OSC = 0,     /* FLAG_D0 oscillator counter fast -> OSCCHK       */
+  ST_THSD,        /* FLAG_D4 thermal shutdown -> THSD                */
+  ST_SUPPLY_UV,   /* FLAG_D2 supply error, UV -> VA_UV, VD_UV        */
+  ST_SUPPLY_OV,   /* FLAG_D2 + D3 supply error, OV -> VA_OV, VD_OV   */
+  ST_FUSE_ED,     /* FLAG_D5 fuse ED -> OTP1_ED, OTP2_ED             */
+  ST_FUSE_MED,    /* FLAG_D6 fuse MED -> OTP1_MED, OTP2_MED          */
+  ST_TMODCHK,     /* FLAG_D7 test mode -> TMODCHK                    */
+  ST_CSFLT,       /* RDSTATC ERR read -> every CSxFLT, latent faults */
+  ST_NB
+} ST_TEST;
+
+/* Self test settings */
+typedef struct
+{
+  uint32_t period_ms[ST_NB];  /* Run interval of each test, 0 = off */
+  uint32_t settle_ms;         /* Wait between forcing and reading   */
+} st_cfg_;
+
+/* Result of one self test */
+typedef struct
+{
+  uint32_t fail_mask;   /* Ics that failed the last run, bit n = ic n */
+  uint32_t last_ms;     /* End of the last run                        */
+  uint32_t run_count;   /* Completed runs                             */
+  uint32_t fail_count;  /* Runs with at least one ic failing          */
+} st_result_;
+
+void adBmsStConfig(const st_cfg_ *cfg);
+bool adBmsStStep(uint8_t tIC, cell_asic *ic);
+uint32_t adBmsStRun(uint8_t tIC, cell_asic *ic, ST_TEST test);
+const st_result_ *adBmsStResult(ST_TEST test);
+uint32_t adBmsStAgeMs(ST_TEST test);
+uint32_t adBmsStFailMask(void);
+void adBmsStReset(void);
+
+#endif
+/** @}*/
+/** @}*/
@@ -0,0 +1,58 @@
+/*******************************************************************************
+* @file:    adBms6830Stats.h
+* @brief:   Pack code statistics header file
+*****************************************************************************/
+/** @addtogroup BMS_DRIVER
+*  @{
+*
+*/
+
+/** @addtogroup PACK_STATS PACK STATISTICS
+*  @{
+*
+*/
+#ifndef __ADBMSSTATS_H
+#define __ADBMSSTATS_H
+
+#include "common.h"
+#include "adBms6830Data.h"
+
+/* Max codes per call, keeps sum and indexes in range */
+#define STATS_MAX_COUNT 32768u
+
+/* Statistics of a run of adc codes */
+typedef struct
+{
+  int32_t sum;          /* Sum of the codes              */
+  int16_t min;          /* Smallest code                 */
+  int16_t max;          /* Largest code                  */
+  uint16_t argmin;      /* First index holding min       */
+  uint16_t argmax;      /* First index holding max       */
+} code_stats_;
+
+/* Incremental statistics of one pack store code array */
+typedef struct
+{
+  uint8_t tIC;              /* ICs in the reduction, 0 = not built yet */
+  code_stats_ ic[MAX_IC];   /* Per ic summary, ic local indexes        */
+  code_stats_ pack;         /* Pack reduction, pack indexes            */
+} pack_stats_;
+
+/* Codes of one ic taken into pack_stats_ */
+typedef struct
+{
+  uint8_t bit;              /* PACK_PEC_x dirty bit of the array       */
+  uint8_t stride;           /* Codes per ic in the array (CELL, AUX)   */
+  uint8_t first;            /* First code used of each ic              */
+  uint8_t count;            /* Codes used of each ic                   */
+} pack_stats_src_;
+
+void adBmsCodeStats(const int16_t *code, uint16_t count, code_stats_ *stats);
+void adBmsCodeStatsScalar(const int16_t *code, uint16_t count, code_stats_ *stats);
+void adBmsCodeStatsMerge(code_stats_ *stats, const code_stats_ *part, uint16_t offset);
+uint8_t adBmsPackStatsUpdate(pack_stats_ *stats, pack_store_ *pack, const int16_t *code, const pack_stats_src_ *src);
+void adBmsPackStatsReset(pack_stats_ *stats);
+
+#endif
+/** @}*/
+/** @}*/
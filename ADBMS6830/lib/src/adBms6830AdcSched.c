@@ -0,0 +1,180 @@
+/*******************************************************************************
+* @file:    adBms6830AdcSched.c
+* @brief:   Adc conversion scheduler
+*****************************************************************************/
+/*! \addtogroup BMS_DRIVER
+*  @{
+*/
+
+/*! @addtogroup ADC_SCHED ADC CONVERSION SCHEDULER
+*  @{
+*/
+#include "common.h"
+#include "adbms_main.h"
+#include "adBms6830CmdList.h"
+#include "adBms6830AdcSched.h"
+
+#define ADC_PROBE_INTERVAL_US 100       /* Wait between probes once overdue */
+
+/* Expected conversion time (us), datasheet figures rounded up */
+typedef struct
+{
+  uint32_t conv_us;     /* Conversion without open wire          */
+  uint32_t ow_us;       /* Extra time with open wire current on  */
+} adc_time_;
+
+static const adc_time_ adc_time[ADC_CONV_NB] =
+{
+  [ADC_CONV_C]    = { 1100,    0 },   /* 16 cells, 1ms update rate            */
+  [ADC_CONV_S]    = { 8500, 8500 },   /* 16 cells sequential, ow soak per cell */
+  [ADC_CONV_AUX]  = { 1700, 1700 },   /* all channels, ow soak per channel     */
+  [ADC_CONV_AUX2] = { 1500,    0 },   /* redundant aux, all channels           */
+};
+
+/* Poll command of each converter (SDO low while busy) */
+static const cmd_desc_ *const adc_poll_cmd[ADC_CONV_NB] =
+{
+  [ADC_CONV_C]    = &PLCADC,
+  [ADC_CONV_S]    = &PLSADC,
+  [ADC_CONV_AUX]  = &PLAUX1,
+  [ADC_CONV_AUX2] = &PLAUX2,
+};
+
+/* Running conversion */
+typedef struct
+{
+  ADC_STATE state;      /* ADC_IDLE or ADC_BUSY          */
+  uint32_t start_us;    /* Conversion command sent      */
+  uint32_t due_us;      /* Expected conversion time     */
+} adc_slot_;
+
+static adc_slot_ adc_slot[ADC_CONV_NB];
+static adc_conv_stats_ adc_stats[ADC_CONV_NB];
+
+/**
+*******************************************************************************
+* Function: adBmsAdcSchedStart
+* @brief Record conversion start.
+*
+* @details Called by the conversion commands (ADCV, ADSV, ADAX, ADAX2) right
+*          after the command is sent; the result is due after the expected
+*          conversion time of the command.
+*
+* Parameters:
+* @param [in]  conv     Converter
+*
+* @param [in]  ow       Open wire current source on
+*
+* @return None
+*
+*******************************************************************************
+*/
+void adBmsAdcSchedStart(ADC_CONV conv, bool ow)
+{
+  if(conv >= ADC_CONV_NB){ return; }
+  adc_slot[conv].state = ADC_BUSY;
+  adc_slot[conv].start_us = getTimUs();
+  adc_slot[conv].due_us = adc_time[conv].conv_us + (ow ? adc_time[conv].ow_us : 0);
+}
+
+/**
+*******************************************************************************
+* Function: adBmsAdcPoll
+* @brief Non blocking conversion state.
+*
+* @details Before the expected conversion time no spi traffic is done. Once
+*          due, one short poll probe (command + 1 byte) is sent per call; the
+*          first probe that reads SDO high completes the conversion and
+*          records the measured time. ADC_DONE is returned by that call
+*          only, the slot is idle again right away and the next call returns
+*          ADC_IDLE.
+*
+* Parameters:
+* @param [in]  conv     Converter
+*
+* @return Conversion state
+*
+*******************************************************************************
+*/
+ADC_STATE adBmsAdcPoll(ADC_CONV conv)
+{
+  adc_slot_ *slot;
+  adc_conv_stats_ *stats;
+  uint32_t elapsed;
+  if(conv >= ADC_CONV_NB){ return ADC_IDLE; }
+  slot = &adc_slot[conv];
+  stats = &adc_stats[conv];
+  if(slot->state == ADC_IDLE){ return ADC_IDLE; }
+  if((getTimUs() - slot->start_us) < slot->due_us){ return ADC_BUSY; }
+  stats->probe_count++;
+  if(!adBmsProbeAdc(adc_poll_cmd[conv])){ return ADC_BUSY; }
+  elapsed = getTimUs() - slot->start_us;
+  stats->last_us = elapsed;
+  if((stats->count == 0) || (elapsed < stats->min_us)){ stats->min_us = elapsed; }
+  if(elapsed > stats->max_us){ stats->max_us = elapsed; }
+  stats->count++;
+  slot->state = ADC_IDLE;
+  return ADC_DONE;
+}
+
+/**
+*******************************************************************************
+* Function: adBmsAdcWait
+* @brief Wait conversion done.
+*
+* @details Blocking helper for the sequential application flow: sleeps until
+*          the conversion is due, then probes every ADC_PROBE_INTERVAL_US.
+*
+* Parameters:
+* @param [in]  conv     Converter
+*
+* @return Measured conversion time (us), 0 if no conversion was running
+*
+*******************************************************************************
+*/
+uint32_t adBmsAdcWait(ADC_CONV conv)
+{
+  ADC_STATE state;
+  uint32_t elapsed;
+  if((conv >= ADC_CONV_NB) || (adc_slot[conv].state == ADC_IDLE)){ return 0; }
+  while((state = adBmsAdcPoll(conv)) == ADC_BUSY)
+  {
+    elapsed = getTimUs() - adc_slot[conv].start_us;
+    Delay_us((elapsed < adc_slot[conv].due_us) ? (adc_slot[conv].due_us - elapsed) : ADC_PROBE_INTERVAL_US);
+  }
+  return((state == ADC_DONE) ? adc_stats[conv].last_us : 0);
+}
+
+/**
+*******************************************************************************
+* Function: adBmsAdcStats
+* @brief Measured conversion time statistics.
+*
+* Parameters:
+* @param [in]  conv     Converter
+*
+* @return Pointer to the converter statistics
+*
+*******************************************************************************
+*/
+const adc_conv_stats_ *adBmsAdcStats(ADC_CONV conv)
+{
+  return(&adc_stats[(conv < ADC_CONV_NB) ? conv : ADC_CONV_C]);
+}
+
+/**
+*******************************************************************************
+* Function: adBmsAdcClearStats
+* @brief Clear conversion time statistics.
+*
+* @return None
+*
+*******************************************************************************
+*/
+void adBmsAdcClearStats(void)
+{
+  memset(&adc_stats[0], 0, sizeof(adc_stats));
+}
+
+/** @}*/
+/** @}*/
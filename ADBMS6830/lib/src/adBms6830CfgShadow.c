@@ -0,0 +1,186 @@
+/*******************************************************************************
+* @file:    adBms6830CfgShadow.c
+* @brief:   Configuration register shadow
+*****************************************************************************/
+/*! \addtogroup BMS_DRIVER
+*  @{
+*/
+
+/*! @addtogroup CFG_SHADOW CONFIGURATION SHADOW
+*  @{
+*/
+#include "common.h"
+#include "adbms_main.h"
+#include "adBms6830CmdList.h"
+#include "adBms6830CfgShadow.h"
+
+/* Last bytes written to configuration register A and B of each ic */
+static uint8_t cfg_shadow[2][MAX_IC][TX_DATA];
+static uint8_t cfg_valid[MAX_IC];   /* CFG_REG_x bits holding a written value */
+static cfg_shadow_stats_ cfg_stats;
+
+/**
+*******************************************************************************
+* Function: adBmsCfgShadowNote
+* @brief Record a configuration register write.
+*
+* @details Called by adBmsWriteData for every WRCFGA/WRCFGB, so the shadow
+*          follows all writes whichever path sent them.
+*
+* Parameters:
+* @param [in]	tIC      Total IC
+*
+* @param [in]  *cmd     Write command descriptor
+*
+* @param [in]  *data    Write buffer, TX_DATA bytes per ic
+*
+* @return None
+*
+*******************************************************************************
+*/
+void adBmsCfgShadowNote(uint8_t tIC, const cmd_desc_ *cmd, const uint8_t *data)
+{
+  uint8_t reg = (cmd->grp == A) ? 0 : 1;
+  for (uint8_t cic = 0; cic < tIC; cic++)
+  {
+    memcpy(&cfg_shadow[reg][cic][0], &data[cic * TX_DATA], TX_DATA);
+    cfg_valid[cic] |= (uint8_t)(reg ? CFG_REG_B : CFG_REG_A);
+  }
+  cfg_stats.write_count++;
+}
+
+/**
+*******************************************************************************
+* Function: adBmsCfgDirty
+* @brief Compare the configuration fields with the shadow.
+*
+* @details Builds the configuration A/B bytes from tx_cfga/tx_cfgb and
+*          compares them per ic with the last written bytes.
+*
+* Parameters:
+* @param [in]	tIC      Total IC
+*
+* @param [in]  *ic      cell_asic stucture pointer
+*
+* @param [out] *dirty   CFG_REG_x bits per ic, may be NULL
+*
+* @return CFG_REG_x bits dirty on any ic
+*
+*******************************************************************************
+*/
+uint8_t adBmsCfgDirty(uint8_t tIC, cell_asic *ic, uint8_t *dirty)
+{
+  uint8_t chain = 0, bits;
+  adBms6830CreateConfiga(tIC, &ic[0]);
+  adBms6830CreateConfigb(tIC, &ic[0]);
+  for (uint8_t cic = 0; cic < tIC; cic++)
+  {
+    bits = (uint8_t)((CFG_REG_A | CFG_REG_B) & ~cfg_valid[cic]);
+    if (memcmp(&ic[cic].configa.tx_data[0], &cfg_shadow[0][cic][0], TX_DATA) != 0){ bits |= CFG_REG_A; }
+    if (memcmp(&ic[cic].configb.tx_data[0], &cfg_shadow[1][cic][0], TX_DATA) != 0){ bits |= CFG_REG_B; }
+    if (dirty != NULL){ dirty[cic] = bits; }
+    chain |= bits;
+  }
+  return chain;
+}
+
+/**
+*******************************************************************************
+* Function: adBmsCfgWrite
+* @brief Write configuration register A/B when a field changed.
+*
+* @details A daisy chain write carries every ic, so a register is written
+*          for the whole chain as soon as one ic differs from the shadow and
+*          skipped otherwise. The ic must be awake.
+*
+* Parameters:
+* @param [in]	tIC      Total IC
+*
+* @param [in]  *ic      cell_asic stucture pointer
+*
+* @return CFG_REG_x bits written
+*
+*******************************************************************************
+*/
+uint8_t adBmsCfgWrite(uint8_t tIC, cell_asic *ic)
+{
+  uint8_t dirty = adBmsCfgDirty(tIC, &ic[0], NULL);
+  if (dirty & CFG_REG_A){ adBmsWriteData(tIC, &ic[0], &WRCFGA); } else { cfg_stats.skip_count++; }
+  if (dirty & CFG_REG_B){ adBmsWriteData(tIC, &ic[0], &WRCFGB); } else { cfg_stats.skip_count++; }
+  return dirty;
+}
+
+/**
+*******************************************************************************
+* Function: adBmsCfgVerify
+* @brief Read back configuration A/B and restore it if it differs.
+*
+* @details Meant to run at a slow period: an ic that went through a power on
+*          reset reads its default configuration. Registers that read back
+*          different from the shadow are invalidated and written again; ics
+*          with a pec error on the read back are not judged.
+*
+* Parameters:
+* @param [in]	tIC      Total IC
+*
+* @param [in]  *ic      cell_asic stucture pointer
+*
+* @return Number of ics with a configuration mismatch
+*
+*******************************************************************************
+*/
+uint8_t adBmsCfgVerify(uint8_t tIC, cell_asic *ic)
+{
+  static uint8_t pec_a[MAX_IC];
+  uint8_t mismatch = 0, bits;
+  adBmsReadData(tIC, &ic[0], &RDCFGA);
+  for (uint8_t cic = 0; cic < tIC; cic++){ pec_a[cic] = ic[cic].cccrc.cfgr_pec; }
+  adBmsReadData(tIC, &ic[0], &RDCFGB);
+  cfg_stats.verify_count++;
+  for (uint8_t cic = 0; cic < tIC; cic++)
+  {
+    if (pec_a[cic] || ic[cic].cccrc.cfgr_pec){ continue; }
+    bits = 0;
+    if (memcmp(&ic[cic].configa.rx_data[0], &cfg_shadow[0][cic][0], TX_DATA) != 0){ bits |= CFG_REG_A; }
+    if (memcmp(&ic[cic].configb.rx_data[0], &cfg_shadow[1][cic][0], TX_DATA) != 0){ bits |= CFG_REG_B; }
+    if (bits != 0)
+    {
+      cfg_valid[cic] &= (uint8_t)~bits;
+      cfg_stats.mismatch_count++;
+      mismatch++;
+    }
+  }
+  if (mismatch != 0){ adBmsCfgWrite(tIC, &ic[0]); }
+  return mismatch;
+}
+
+/**
+*******************************************************************************
+* Function: adBmsCfgInvalidate
+* @brief Forget the shadow, the next adBmsCfgWrite writes both registers.
+*
+* @return None
+*
+*******************************************************************************
+*/
+void adBmsCfgInvalidate(void)
+{
+  memset(&cfg_valid[0], 0, sizeof(cfg_valid));
+}
+
+/**
+*******************************************************************************
+* Function: adBmsCfgStats
+* @brief Shadow counters.
+*
+* @return Pointer to the counters
+*
+*******************************************************************************
+*/
+const cfg_shadow_stats_ *adBmsCfgStats(void)
+{
+  return(&cfg_stats);
+}
+
+/** @}*/
+/** @}*/
@@ -0,0 +1,149 @@
+/*******************************************************************************
+* @file:    adBms6830CmdCntr.c
+* @brief:   Command counter accounting
+*****************************************************************************/
+/*! \addtogroup BMS_DRIVER
+*  @{
+*/
+
+/*! @addtogroup CMD_CNTR COMMAND COUNTER
+*  @{
+*/
+#include "common.h"
+#include "adbms_main.h"
+#include "adBms6830CmdList.h"
+#include "adBms6830CmdCntr.h"
+
+#define CC_MAX 63                   /* 6 bit counter, wraps to 1 */
+
+static uint8_t cc_expect[MAX_IC];   /* Predicted counter of each ic      */
+static bool cc_known[MAX_IC];       /* Prediction synced to a read back  */
+static uint8_t cc_mismatch;         /* Ics found off since last clear    */
+static cc_stats_ cc_stats;
+
+/**
+*******************************************************************************
+* Function: adBmsCcSent
+* @brief Account for a command sent on the daisy chain.
+*
+* @details Every ic receives every command. Command only and write commands
+*          increment the counter (63 wraps to 1), RSTCC clears it, read and
+*          poll commands leave it unchanged.
+*
+* Parameters:
+* @param [in]  *cmd     Command descriptor
+*
+* @return None
+*
+*******************************************************************************
+*/
+void adBmsCcSent(const cmd_desc_ *cmd)
+{
+  if ((cmd->kind == CMD_READ) || (cmd->kind == CMD_POLL)){ return; }
+  if ((cmd->frame[0] == RSTCC.frame[0]) && (cmd->frame[1] == RSTCC.frame[1]))
+  {
+    memset(&cc_expect[0], 0, sizeof(cc_expect));
+    memset(&cc_known[0], true, sizeof(cc_known));
+    return;
+  }
+  for (uint8_t cic = 0; cic < MAX_IC; cic++)
+  {
+    cc_expect[cic] = (uint8_t)((cc_expect[cic] >= CC_MAX) ? 1 : (cc_expect[cic] + 1));
+  }
+}
+
+/**
+*******************************************************************************
+* Function: adBmsCcCheck
+* @brief Compare a read back counter with the prediction.
+*
+* @details Called by the read parsers for every ic with a good pec. The
+*          first read back syncs the prediction. A mismatch means a command
+*          was lost or corrupted, or the ic went through a reset (counter
+*          back to 0): the ic is counted in adBmsCcMismatch and the
+*          prediction is resynced.
+*
+* Parameters:
+* @param [in]  cic        Ic index in the chain
+*
+* @param [in]  cmd_cntr   Read back command counter
+*
+* @return None
+*
+*******************************************************************************
+*/
+void adBmsCcCheck(uint8_t cic, uint8_t cmd_cntr)
+{
+  if (cic >= MAX_IC){ return; }
+  if (cc_known[cic])
+  {
+    cc_stats.check_count++;
+    if (cc_expect[cic] != cmd_cntr)
+    {
+      cc_stats.mismatch_count++;
+      if (cc_mismatch < MAX_IC){ cc_mismatch++; }
+    }
+  }
+  cc_expect[cic] = cmd_cntr;
+  cc_known[cic] = true;
+}
+
+/**
+*******************************************************************************
+* Function: adBmsCcMismatch
+* @brief Ics found with an unexpected counter since the last clear.
+*
+* @return Number of mismatches, 0 when every write went through
+*
+*******************************************************************************
+*/
+uint8_t adBmsCcMismatch(void)
+{
+  return cc_mismatch;
+}
+
+/**
+*******************************************************************************
+* Function: adBmsCcClearMismatch
+* @brief Acknowledge the mismatches, e.g. after a full configuration verify.
+*
+* @return None
+*
+*******************************************************************************
+*/
+void adBmsCcClearMismatch(void)
+{
+  cc_mismatch = 0;
+}
+
+/**
+*******************************************************************************
+* Function: adBmsCcReset
+* @brief Forget the predictions, the next read back of each ic syncs it.
+*
+* @return None
+*
+*******************************************************************************
+*/
+void adBmsCcReset(void)
+{
+  memset(&cc_known[0], false, sizeof(cc_known));
+  cc_mismatch = 0;
+}
+
+/**
+*******************************************************************************
+* Function: adBmsCcStats
+* @brief Command counter accounting counters.
+*
+* @return Pointer to the counters
+*
+*******************************************************************************
+*/
+const cc_stats_ *adBmsCcStats(void)
+{
+  return(&cc_stats);
+}
+
+/** @}*/
+/** @}*/
@@ -0,0 +1,132 @@
+/*******************************************************************************
+* @file:    adBms6830CmdList.c
+* @brief:   Command descriptor table
+*****************************************************************************/
+/*! @addtogroup BMS_DRIVER
+*  @{
+*
+*/
+
+/*! @addtogroup BMS_COMMAND BMS COMMAND
+*  @{
+*
+*/
+
+#include "common.h"
+#include "adBms6830CmdList.h"
+
+/* { Cmd0, Cmd1, Pec15 msb, Pec15 lsb }, kind, per ic read back size, register type, register group */
+/* configuration registers commands */
+const cmd_desc_ WRCFGA     = { { 0x00, 0x01, 0x3D, 0x6E }, CMD_WRITE, 0, Config, A };
+const cmd_desc_ WRCFGB     = { { 0x00, 0x24, 0xB1, 0x9E }, CMD_WRITE, 0, Config, B };
+const cmd_desc_ RDCFGA     = { { 0x00, 0x02, 0x2B, 0x0A }, CMD_READ, RX_DATA, Config, A };
+const cmd_desc_ RDCFGB     = { { 0x00, 0x26, 0x2C, 0xC8 }, CMD_READ, RX_DATA, Config, B };
+
+/* Read cell voltage result registers commands */
+const cmd_desc_ RDCVA      = { { 0x00, 0x04, 0x07, 0xC2 }, CMD_READ, RX_DATA, Cell, A };
+const cmd_desc_ RDCVB      = { { 0x00, 0x06, 0x9A, 0x94 }, CMD_READ, RX_DATA, Cell, B };
+const cmd_desc_ RDCVC      = { { 0x00, 0x08, 0x5E, 0x52 }, CMD_READ, RX_DATA, Cell, C };
+const cmd_desc_ RDCVD      = { { 0x00, 0x0A, 0xC3, 0x04 }, CMD_READ, RX_DATA, Cell, D };
+const cmd_desc_ RDCVE      = { { 0x00, 0x09, 0xD5, 0x60 }, CMD_READ, RX_DATA, Cell, E };
+const cmd_desc_ RDCVF      = { { 0x00, 0x0B, 0x48, 0x36 }, CMD_READ, RX_DATA, Cell, F };
+const cmd_desc_ RDCVALL    = { { 0x00, 0x0C, 0xEF, 0xCC }, CMD_READ, RDCVALL_SIZE, Rdcvall, ALL_GRP };
+
+/* Read average cell voltage result registers commands commands */
+const cmd_desc_ RDACA      = { { 0x00, 0x44, 0xE0, 0x48 }, CMD_READ, RX_DATA, AvgCell, A };
+const cmd_desc_ RDACB      = { { 0x00, 0x46, 0x7D, 0x1E }, CMD_READ, RX_DATA, AvgCell, B };
+const cmd_desc_ RDACC      = { { 0x00, 0x48, 0xB9, 0xD8 }, CMD_READ, RX_DATA, AvgCell, C };
+const cmd_desc_ RDACD      = { { 0x00, 0x4A, 0x24, 0x8E }, CMD_READ, RX_DATA, AvgCell, D };
+const cmd_desc_ RDACE      = { { 0x00, 0x49, 0x32, 0xEA }, CMD_READ, RX_DATA, AvgCell, E };
+const cmd_desc_ RDACF      = { { 0x00, 0x4B, 0xAF, 0xBC }, CMD_READ, RX_DATA, AvgCell, F };
+const cmd_desc_ RDACALL    = { { 0x00, 0x4C, 0x08, 0x46 }, CMD_READ, RDACALL_SIZE, Rdacall, ALL_GRP };
+
+/* Read s voltage result registers commands */
+const cmd_desc_ RDSVA      = { { 0x00, 0x03, 0xA0, 0x38 }, CMD_READ, RX_DATA, S_volt, A };
+const cmd_desc_ RDSVB      = { { 0x00, 0x05, 0x8C, 0xF0 }, CMD_READ, RX_DATA, S_volt, B };
+const cmd_desc_ RDSVC      = { { 0x00, 0x07, 0x11, 0xA6 }, CMD_READ, RX_DATA, S_volt, C };
+const cmd_desc_ RDSVD      = { { 0x00, 0x0D, 0x64, 0xFE }, CMD_READ, RX_DATA, S_volt, D };
+const cmd_desc_ RDSVE      = { { 0x00, 0x0E, 0x72, 0x9A }, CMD_READ, RX_DATA, S_volt, E };
+const cmd_desc_ RDSVF      = { { 0x00, 0x0F, 0xF9, 0xA8 }, CMD_READ, RX_DATA, S_volt, F };
+const cmd_desc_ RDSALL     = { { 0x00, 0x10, 0xED, 0x72 }, CMD_READ, RDSALL_SIZE, Rdsall, ALL_GRP };
+
+/* Read c and s results */
+const cmd_desc_ RDCSALL    = { { 0x00, 0x11, 0x66, 0x40 }, CMD_READ, RDCSALL_SIZE, Rdcsall, ALL_GRP };
+const cmd_desc_ RDACSALL   = { { 0x00, 0x51, 0x81, 0xCA }, CMD_READ, RDACSALL_SIZE, Rdacsall, ALL_GRP };
+
+/* Read all AUX and all Status Registers */
+const cmd_desc_ RDASALL    = { { 0x00, 0x35, 0x61, 0x82 }, CMD_READ, RDASALL_SIZE, Rdasall, ALL_GRP };
+
+/* Read filtered cell voltage result registers*/
+const cmd_desc_ RDFCA      = { { 0x00, 0x12, 0x70, 0x24 }, CMD_READ, RX_DATA, F_volt, A };
+const cmd_desc_ RDFCB      = { { 0x00, 0x13, 0xFB, 0x16 }, CMD_READ, RX_DATA, F_volt, B };
+const cmd_desc_ RDFCC      = { { 0x00, 0x14, 0x5C, 0xEC }, CMD_READ, RX_DATA, F_volt, C };
+const cmd_desc_ RDFCD      = { { 0x00, 0x15, 0xD7, 0xDE }, CMD_READ, RX_DATA, F_volt, D };
+const cmd_desc_ RDFCE      = { { 0x00, 0x16, 0xC1, 0xBA }, CMD_READ, RX_DATA, F_volt, E };
+const cmd_desc_ RDFCF      = { { 0x00, 0x17, 0x4A, 0x88 }, CMD_READ, RX_DATA, F_volt, F };
+const cmd_desc_ RDFCALL    = { { 0x00, 0x18, 0x05, 0x7C }, CMD_READ, RDFCALL_SIZE, Rdfcall, ALL_GRP };
+
+/* Read aux results */
+const cmd_desc_ RDAUXA     = { { 0x00, 0x19, 0x8E, 0x4E }, CMD_READ, RX_DATA, Aux, A };
+const cmd_desc_ RDAUXB     = { { 0x00, 0x1A, 0x98, 0x2A }, CMD_READ, RX_DATA, Aux, B };
+const cmd_desc_ RDAUXC     = { { 0x00, 0x1B, 0x13, 0x18 }, CMD_READ, RX_DATA, Aux, C };
+const cmd_desc_ RDAUXD     = { { 0x00, 0x1F, 0xA2, 0x86 }, CMD_READ, RX_DATA, Aux, D };
+
+/* Read redundant aux results */
+const cmd_desc_ RDRAXA     = { { 0x00, 0x1C, 0xB4, 0xE2 }, CMD_READ, RX_DATA, RAux, A };
+const cmd_desc_ RDRAXB     = { { 0x00, 0x1D, 0x3F, 0xD0 }, CMD_READ, RX_DATA, RAux, B };
+const cmd_desc_ RDRAXC     = { { 0x00, 0x1E, 0x29, 0xB4 }, CMD_READ, RX_DATA, RAux, C };
+const cmd_desc_ RDRAXD     = { { 0x00, 0x25, 0x3A, 0xAC }, CMD_READ, RX_DATA, RAux, D };
+
+/* Read status registers */
+const cmd_desc_ RDSTATA    = { { 0x00, 0x30, 0x5B, 0x2E }, CMD_READ, RX_DATA, Status, A };
+const cmd_desc_ RDSTATB    = { { 0x00, 0x31, 0xD0, 0x1C }, CMD_READ, RX_DATA, Status, B };
+const cmd_desc_ RDSTATC    = { { 0x00, 0x32, 0xC6, 0x78 }, CMD_READ, RX_DATA, Status, C };
+const cmd_desc_ RDSTATCERR = { { 0x00, 0x72, 0x21, 0xF2 }, CMD_READ, RX_DATA, Status, C }; /* ERR */
+const cmd_desc_ RDSTATD    = { { 0x00, 0x33, 0x4D, 0x4A }, CMD_READ, RX_DATA, Status, D };
+const cmd_desc_ RDSTATE    = { { 0x00, 0x34, 0xEA, 0xB0 }, CMD_READ, RX_DATA, Status, E };
+
+/* Pwm registers commands */
+const cmd_desc_ WRPWM1     = { { 0x00, 0x20, 0x00, 0x00 }, CMD_WRITE, 0, Pwm, A };
+const cmd_desc_ RDPWM1     = { { 0x00, 0x22, 0x9D, 0x56 }, CMD_READ, RX_DATA, Pwm, A };
+
+const cmd_desc_ WRPWM2     = { { 0x00, 0x21, 0x8B, 0x32 }, CMD_WRITE, 0, Pwm, B };
+const cmd_desc_ RDPWM2     = { { 0x00, 0x23, 0x16, 0x64 }, CMD_READ, RX_DATA, Pwm, B };
+
+/* Clear commands */
+const cmd_desc_ CLRCELL    = { { 0x07, 0x11, 0xC9, 0xC0 }, CMD_ONLY, 0, Cmd, NONE };
+const cmd_desc_ CLRAUX     = { { 0x07, 0x12, 0xDF, 0xA4 }, CMD_ONLY, 0, Cmd, NONE };
+const cmd_desc_ CLRSPIN    = { { 0x07, 0x16, 0x6E, 0x3A }, CMD_ONLY, 0, Cmd, NONE };
+const cmd_desc_ CLRFLAG    = { { 0x07, 0x17, 0xE5, 0x08 }, CMD_WRITE, 0, Clrflag, NONE };
+const cmd_desc_ CLRFC      = { { 0x07, 0x14, 0xF3, 0x6C }, CMD_ONLY, 0, Cmd, NONE };
+const cmd_desc_ CLOVUV     = { { 0x07, 0x15, 0x78, 0x5E }, CMD_ONLY, 0, Cmd, NONE };
+
+/* Poll adc command */
+const cmd_desc_ PLADC      = { { 0x07, 0x18, 0xAA, 0xFC }, CMD_POLL, 0, Cmd, NONE };
+const cmd_desc_ PLAUT      = { { 0x07, 0x19, 0x21, 0xCE }, CMD_POLL, 0, Cmd, NONE };
+const cmd_desc_ PLCADC     = { { 0x07, 0x1C, 0x1B, 0x62 }, CMD_POLL, 0, Cmd, NONE };
+const cmd_desc_ PLSADC     = { { 0x07, 0x1D, 0x90, 0x50 }, CMD_POLL, 0, Cmd, NONE };
+const cmd_desc_ PLAUX1     = { { 0x07, 0x1E, 0x86, 0x34 }, CMD_POLL, 0, Cmd, NONE };
+const cmd_desc_ PLAUX2     = { { 0x07, 0x1F, 0x0D, 0x06 }, CMD_POLL, 0, Cmd, NONE };
+
+/* Diagn command */
+const cmd_desc_ DIAGN      = { { 0x07, 0x15, 0x78, 0x5E }, CMD_ONLY, 0, Cmd, NONE };
+
+/* GPIOs Comm commands */
+const cmd_desc_ WRCOMM     = { { 0x07, 0x21, 0x24, 0xB2 }, CMD_WRITE, 0, Comm, NONE };
+const cmd_desc_ RDCOMM     = { { 0x07, 0x22, 0x32, 0xD6 }, CMD_READ, RX_DATA, Comm, NONE };
+const uint8_t STCOMM[13] = { 0x07, 0x23, 0xB9, 0xE4 ,0x00 ,0x00 ,0x00 ,0x00 ,0x00 ,0x00 ,0x00 ,0x00 ,0x00};
+
+/* Mute and Unmute commands */
+const cmd_desc_ MUTE       = { { 0x00, 0x28, 0xE8, 0x0E }, CMD_ONLY, 0, Cmd, NONE };
+const cmd_desc_ UNMUTE     = { { 0x00, 0x29, 0x63, 0x3C }, CMD_ONLY, 0, Cmd, NONE };
+
+const cmd_desc_ RSTCC      = { { 0x00, 0x2E, 0xC4, 0xC6 }, CMD_ONLY, 0, Cmd, NONE };
+const cmd_desc_ SNAP       = { { 0x00, 0x2D, 0xD2, 0xA2 }, CMD_ONLY, 0, Cmd, NONE };
+const cmd_desc_ UNSNAP     = { { 0x00, 0x2F, 0x4F, 0xF4 }, CMD_ONLY, 0, Cmd, NONE };
+const cmd_desc_ SRST       = { { 0x00, 0x27, 0xA7, 0xFA }, CMD_ONLY, 0, Cmd, NONE };
+
+/* Read SID command */
+const cmd_desc_ RDSID      = { { 0x00, 0x2C, 0x59, 0x90 }, CMD_READ, RX_DATA, Sid, NONE };
+
+/** @}*/
+/** @}*/
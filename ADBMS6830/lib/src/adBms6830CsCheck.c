@@ -0,0 +1,159 @@
+/*******************************************************************************
+* @file:    adBms6830CsCheck.c
+* @brief:   C-ADC vs S-ADC cross check
+*****************************************************************************/
+/*! \addtogroup BMS_DRIVER
+*  @{
+*/
+
+/*! @addtogroup CS_CHECK C VS S CROSS CHECK
+*  @{
+*/
+#include "common.h"
+#include "adbms_main.h"
+#include "adBms6830CsCheck.h"
+
+static cs_cfg_ cs_cfg = { CS_TOL_DEFAULT_UV, CS_DEBOUNCE_DEFAULT };
+static cs_stats_ cs_stats;
+static uint16_t cs_bad[MAX_IC];            /* Debounced state, bit per cell      */
+static uint8_t cs_run[MAX_IC][CELL];       /* Compares against the cell state    */
+
+/**
+*******************************************************************************
+* Function: adBmsCsConfig
+* @brief Set cross check tolerance and debounce.
+*
+* Parameters:
+* @param [in]  *cfg     Settings
+*
+* @return None
+*
+*******************************************************************************
+*/
+void adBmsCsConfig(const cs_cfg_ *cfg)
+{
+  cs_cfg = *cfg;
+}
+
+/**
+*******************************************************************************
+* Function: adBmsCsCheck
+* @brief Compare the C-ADC and S-ADC codes of every cell.
+*
+* @details Both sets of codes come with one RDCSALL read, the check costs no
+*          bus traffic. C and S codes share the same lsb and offset, the
+*          difference is compared in uV. A cell changes state (agree or
+*          disagree) only after debounce consecutive compares the other way,
+*          so the S-ADC lagging a fast C-ADC step does not flag it. Ics not
+*          in ic_mask (pec error, stale codes) are not compared and keep
+*          their state.
+*
+* Parameters:
+* @param [in]	tIC      Total IC
+*
+* @param [in]  *ic      cell_asic stucture pointer
+*
+* @param [in]  ic_mask  Ics read this time, bit n = ic n
+*
+* @return Ic mask with at least one cell in disagree
+*
+*******************************************************************************
+*/
+uint32_t adBmsCsCheck(uint8_t tIC, cell_asic *ic, uint32_t ic_mask)
+{
+  int32_t diff_uv;
+  uint16_t bit;
+  bool disagree;
+  if(tIC > MAX_IC){ tIC = MAX_IC; }
+  for(uint8_t cic = 0; cic < tIC; cic++)
+  {
+    if((ic_mask & (1u << cic)) == 0){ continue; }
+    cs_stats.check_count++;
+    for(uint8_t cell = 0; cell < CELL; cell++)
+    {
+      bit = (uint16_t)(1u << cell);
+      diff_uv = ((int32_t)ic[cic].cell.c_codes[cell] - ic[cic].scell.sc_codes[cell]) * CODE_LSB_UV;
+      disagree = (diff_uv > cs_cfg.tol_uv) || (diff_uv < -cs_cfg.tol_uv);
+      if(disagree){ cs_stats.disagree_count++; }
+      if(disagree == ((cs_bad[cic] & bit) != 0))
+      {
+        cs_run[cic][cell] = 0;
+        continue;
+      }
+      if(++cs_run[cic][cell] < cs_cfg.debounce){ continue; }
+      cs_run[cic][cell] = 0;
+      cs_bad[cic] ^= bit;
+      if(disagree){ cs_stats.fault_count++; }
+    }
+  }
+  return adBmsCsFaultMask();
+}
+
+/**
+*******************************************************************************
+* Function: adBmsCsFaultMask
+* @brief Ics with a cell in disagree.
+*
+* @return Ic mask, bit n set = a cell of ic n disagrees after debounce
+*
+*******************************************************************************
+*/
+uint32_t adBmsCsFaultMask(void)
+{
+  uint32_t mask = 0;
+  for(uint8_t cic = 0; cic < MAX_IC; cic++)
+  {
+    if(cs_bad[cic] != 0){ mask |= (1u << cic); }
+  }
+  return mask;
+}
+
+/**
+*******************************************************************************
+* Function: adBmsCsCellMask
+* @brief Cells of one ic in disagree.
+*
+* Parameters:
+* @param [in]  cic      Ic index in the chain
+*
+* @return Cell mask, bit n set = cell n+1 disagrees after debounce
+*
+*******************************************************************************
+*/
+uint16_t adBmsCsCellMask(uint8_t cic)
+{
+  return((cic < MAX_IC) ? cs_bad[cic] : 0);
+}
+
+/**
+*******************************************************************************
+* Function: adBmsCsReset
+* @brief Clear cross check state and counters, every cell agrees.
+*
+* @return None
+*
+*******************************************************************************
+*/
+void adBmsCsReset(void)
+{
+  memset(&cs_bad[0], 0, sizeof(cs_bad));
+  memset(&cs_run[0][0], 0, sizeof(cs_run));
+  memset(&cs_stats, 0, sizeof(cs_stats));
+}
+
+/**
+*******************************************************************************
+* Function: adBmsCsStats
+* @brief Cross check counters.
+*
+* @return Pointer to the counters
+*
+*******************************************************************************
+*/
+const cs_stats_ *adBmsCsStats(void)
+{
+  return(&cs_stats);
+}
+
+/** @}*/
+/** @}*/
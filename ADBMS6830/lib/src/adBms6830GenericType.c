@@ -24,12 +24,35 @@ Using the BMS Driver Application can:
 */
 #include "common.h"
 #include "adbms_main.h"
+#include <stddef.h>
 #ifdef MBED
 extern Serial pc;
 #endif
+
+/* Static transaction buffers, sized for MAX_IC devices and the largest (RDASALL) response.
+   The blocking transfers copy them by cpu, they live in CCM ram; the dma path
+   has its own SRAM buffers in mcuWrapper.c */
+CCMRAM static uint8_t spi_rx_buffer[MAX_IC * MAX_RX_SIZE];
+CCMRAM static uint8_t spi_tx_buffer[4 + (MAX_IC * RX_DATA)];
+CCMRAM static uint8_t read_buffer[MAX_IC * MAX_RX_SIZE];
+CCMRAM static uint8_t write_buffer[MAX_IC * TX_DATA];
+CCMRAM static uint8_t pec_error[MAX_IC];
+CCMRAM static uint8_t cmd_count[MAX_IC];
+static xfer_stats_ xfer_stats;
+static pack_store_ *pack_store = NULL;     /* Optional pack level store */
+
+/* Pending dma read (adBmsReadDataStart / adBmsReadDataFinish) */
+static struct
+{
+  bool pending;
+  uint8_t tIC;
+  cell_asic *ic;
+  const cmd_desc_ *cmd;
+} dma_read;
+
 /**************************************** BMS Driver APIs definitions ********************************************/
-/* Precomputed CRC15 Table */
-const uint16_t Crc15Table[256] = 
+/* Precomputed CRC15 Table, in CCM ram next to the frame buffers */
+CCMRAM_CONST const uint16_t Crc15Table[256] = 
 { 
   0x0000,0xc599, 0xceab, 0xb32, 0xd8cf, 0x1d56, 0x1664, 0xd3fd, 0xf407, 0x319e, 0x3aac,  
   0xff35, 0x2cc8, 0xe951, 0xe263, 0x27fa, 0xad97, 0x680e, 0x633c, 0xa6a5, 0x7558, 0xb0c1,
@@ -72,7 +95,7 @@ const uint16_t Crc15Table[256] =
 *
 *******************************************************************************
 */
-uint16_t Pec15_Calc
+RAMFUNC uint16_t Pec15_Calc
 ( 
 uint8_t len, /* Number of bytes that will be used to calculate a PEC */
 uint8_t *data /* Array of data that will be used to calculate  a PEC */								 
@@ -88,79 +111,425 @@ uint8_t *data /* Array of data that will be used to calculate  a PEC */
   return(remainder*2);/* The CRC15 has a 0 in the LSB so the remainder must be multiplied by 2 */
 }
 
-uint16_t pec10_calc(bool rx_cmd, int len, uint8_t *data)
+/* Precomputed CRC10 Tables (poly 0x48F).
+   [0] byte table, [1..3] byte table followed by 1..3 zero bytes (slice-by-4) */
+CCMRAM_CONST const uint16_t Crc10Table[4][256] =
+{
+  {
+    0x000, 0x08f, 0x11e, 0x191, 0x23c, 0x2b3, 0x322, 0x3ad, 0x0f7, 0x078, 0x1e9, 0x166,
+    0x2cb, 0x244, 0x3d5, 0x35a, 0x1ee, 0x161, 0x0f0, 0x07f, 0x3d2, 0x35d, 0x2cc, 0x243,
+    0x119, 0x196, 0x007, 0x088, 0x325, 0x3aa, 0x23b, 0x2b4, 0x3dc, 0x353, 0x2c2, 0x24d,
+    0x1e0, 0x16f, 0x0fe, 0x071, 0x32b, 0x3a4, 0x235, 0x2ba, 0x117, 0x198, 0x009, 0x086,
+    0x232, 0x2bd, 0x32c, 0x3a3, 0x00e, 0x081, 0x110, 0x19f, 0x2c5, 0x24a, 0x3db, 0x354,
+    0x0f9, 0x076, 0x1e7, 0x168, 0x337, 0x3b8, 0x229, 0x2a6, 0x10b, 0x184, 0x015, 0x09a,
+    0x3c0, 0x34f, 0x2de, 0x251, 0x1fc, 0x173, 0x0e2, 0x06d, 0x2d9, 0x256, 0x3c7, 0x348,
+    0x0e5, 0x06a, 0x1fb, 0x174, 0x22e, 0x2a1, 0x330, 0x3bf, 0x012, 0x09d, 0x10c, 0x183,
+    0x0eb, 0x064, 0x1f5, 0x17a, 0x2d7, 0x258, 0x3c9, 0x346, 0x01c, 0x093, 0x102, 0x18d,
+    0x220, 0x2af, 0x33e, 0x3b1, 0x105, 0x18a, 0x01b, 0x094, 0x339, 0x3b6, 0x227, 0x2a8,
+    0x1f2, 0x17d, 0x0ec, 0x063, 0x3ce, 0x341, 0x2d0, 0x25f, 0x2e1, 0x26e, 0x3ff, 0x370,
+    0x0dd, 0x052, 0x1c3, 0x14c, 0x216, 0x299, 0x308, 0x387, 0x02a, 0x0a5, 0x134, 0x1bb,
+    0x30f, 0x380, 0x211, 0x29e, 0x133, 0x1bc, 0x02d, 0x0a2, 0x3f8, 0x377, 0x2e6, 0x269,
+    0x1c4, 0x14b, 0x0da, 0x055, 0x13d, 0x1b2, 0x023, 0x0ac, 0x301, 0x38e, 0x21f, 0x290,
+    0x1ca, 0x145, 0x0d4, 0x05b, 0x3f6, 0x379, 0x2e8, 0x267, 0x0d3, 0x05c, 0x1cd, 0x142,
+    0x2ef, 0x260, 0x3f1, 0x37e, 0x024, 0x0ab, 0x13a, 0x1b5, 0x218, 0x297, 0x306, 0x389,
+    0x1d6, 0x159, 0x0c8, 0x047, 0x3ea, 0x365, 0x2f4, 0x27b, 0x121, 0x1ae, 0x03f, 0x0b0,
+    0x31d, 0x392, 0x203, 0x28c, 0x038, 0x0b7, 0x126, 0x1a9, 0x204, 0x28b, 0x31a, 0x395,
+    0x0cf, 0x040, 0x1d1, 0x15e, 0x2f3, 0x27c, 0x3ed, 0x362, 0x20a, 0x285, 0x314, 0x39b,
+    0x036, 0x0b9, 0x128, 0x1a7, 0x2fd, 0x272, 0x3e3, 0x36c, 0x0c1, 0x04e, 0x1df, 0x150,
+    0x3e4, 0x36b, 0x2fa, 0x275, 0x1d8, 0x157, 0x0c6, 0x049, 0x313, 0x39c, 0x20d, 0x282,
+    0x12f, 0x1a0, 0x031, 0x0be
+  },
+  {
+    0x000, 0x14d, 0x29a, 0x3d7, 0x1bb, 0x0f6, 0x321, 0x26c, 0x376, 0x23b, 0x1ec, 0x0a1,
+    0x2cd, 0x380, 0x057, 0x11a, 0x263, 0x32e, 0x0f9, 0x1b4, 0x3d8, 0x295, 0x142, 0x00f,
+    0x115, 0x058, 0x38f, 0x2c2, 0x0ae, 0x1e3, 0x234, 0x379, 0x049, 0x104, 0x2d3, 0x39e,
+    0x1f2, 0x0bf, 0x368, 0x225, 0x33f, 0x272, 0x1a5, 0x0e8, 0x284, 0x3c9, 0x01e, 0x153,
+    0x22a, 0x367, 0x0b0, 0x1fd, 0x391, 0x2dc, 0x10b, 0x046, 0x15c, 0x011, 0x3c6, 0x28b,
+    0x0e7, 0x1aa, 0x27d, 0x330, 0x092, 0x1df, 0x208, 0x345, 0x129, 0x064, 0x3b3, 0x2fe,
+    0x3e4, 0x2a9, 0x17e, 0x033, 0x25f, 0x312, 0x0c5, 0x188, 0x2f1, 0x3bc, 0x06b, 0x126,
+    0x34a, 0x207, 0x1d0, 0x09d, 0x187, 0x0ca, 0x31d, 0x250, 0x03c, 0x171, 0x2a6, 0x3eb,
+    0x0db, 0x196, 0x241, 0x30c, 0x160, 0x02d, 0x3fa, 0x2b7, 0x3ad, 0x2e0, 0x137, 0x07a,
+    0x216, 0x35b, 0x08c, 0x1c1, 0x2b8, 0x3f5, 0x022, 0x16f, 0x303, 0x24e, 0x199, 0x0d4,
+    0x1ce, 0x083, 0x354, 0x219, 0x075, 0x138, 0x2ef, 0x3a2, 0x124, 0x069, 0x3be, 0x2f3,
+    0x09f, 0x1d2, 0x205, 0x348, 0x252, 0x31f, 0x0c8, 0x185, 0x3e9, 0x2a4, 0x173, 0x03e,
+    0x347, 0x20a, 0x1dd, 0x090, 0x2fc, 0x3b1, 0x066, 0x12b, 0x031, 0x17c, 0x2ab, 0x3e6,
+    0x18a, 0x0c7, 0x310, 0x25d, 0x16d, 0x020, 0x3f7, 0x2ba, 0x0d6, 0x19b, 0x24c, 0x301,
+    0x21b, 0x356, 0x081, 0x1cc, 0x3a0, 0x2ed, 0x13a, 0x077, 0x30e, 0x243, 0x194, 0x0d9,
+    0x2b5, 0x3f8, 0x02f, 0x162, 0x078, 0x135, 0x2e2, 0x3af, 0x1c3, 0x08e, 0x359, 0x214,
+    0x1b6, 0x0fb, 0x32c, 0x261, 0x00d, 0x140, 0x297, 0x3da, 0x2c0, 0x38d, 0x05a, 0x117,
+    0x37b, 0x236, 0x1e1, 0x0ac, 0x3d5, 0x298, 0x14f, 0x002, 0x26e, 0x323, 0x0f4, 0x1b9,
+    0x0a3, 0x1ee, 0x239, 0x374, 0x118, 0x055, 0x382, 0x2cf, 0x1ff, 0x0b2, 0x365, 0x228,
+    0x044, 0x109, 0x2de, 0x393, 0x289, 0x3c4, 0x013, 0x15e, 0x332, 0x27f, 0x1a8, 0x0e5,
+    0x39c, 0x2d1, 0x106, 0x04b, 0x227, 0x36a, 0x0bd, 0x1f0, 0x0ea, 0x1a7, 0x270, 0x33d,
+    0x151, 0x01c, 0x3cb, 0x286
+  },
+  {
+    0x000, 0x248, 0x01f, 0x257, 0x03e, 0x276, 0x021, 0x269, 0x07c, 0x234, 0x063, 0x22b,
+    0x042, 0x20a, 0x05d, 0x215, 0x0f8, 0x2b0, 0x0e7, 0x2af, 0x0c6, 0x28e, 0x0d9, 0x291,
+    0x084, 0x2cc, 0x09b, 0x2d3, 0x0ba, 0x2f2, 0x0a5, 0x2ed, 0x1f0, 0x3b8, 0x1ef, 0x3a7,
+    0x1ce, 0x386, 0x1d1, 0x399, 0x18c, 0x3c4, 0x193, 0x3db, 0x1b2, 0x3fa, 0x1ad, 0x3e5,
+    0x108, 0x340, 0x117, 0x35f, 0x136, 0x37e, 0x129, 0x361, 0x174, 0x33c, 0x16b, 0x323,
+    0x14a, 0x302, 0x155, 0x31d, 0x3e0, 0x1a8, 0x3ff, 0x1b7, 0x3de, 0x196, 0x3c1, 0x189,
+    0x39c, 0x1d4, 0x383, 0x1cb, 0x3a2, 0x1ea, 0x3bd, 0x1f5, 0x318, 0x150, 0x307, 0x14f,
+    0x326, 0x16e, 0x339, 0x171, 0x364, 0x12c, 0x37b, 0x133, 0x35a, 0x112, 0x345, 0x10d,
+    0x210, 0x058, 0x20f, 0x047, 0x22e, 0x066, 0x231, 0x079, 0x26c, 0x024, 0x273, 0x03b,
+    0x252, 0x01a, 0x24d, 0x005, 0x2e8, 0x0a0, 0x2f7, 0x0bf, 0x2d6, 0x09e, 0x2c9, 0x081,
+    0x294, 0x0dc, 0x28b, 0x0c3, 0x2aa, 0x0e2, 0x2b5, 0x0fd, 0x34f, 0x107, 0x350, 0x118,
+    0x371, 0x139, 0x36e, 0x126, 0x333, 0x17b, 0x32c, 0x164, 0x30d, 0x145, 0x312, 0x15a,
+    0x3b7, 0x1ff, 0x3a8, 0x1e0, 0x389, 0x1c1, 0x396, 0x1de, 0x3cb, 0x183, 0x3d4, 0x19c,
+    0x3f5, 0x1bd, 0x3ea, 0x1a2, 0x2bf, 0x0f7, 0x2a0, 0x0e8, 0x281, 0x0c9, 0x29e, 0x0d6,
+    0x2c3, 0x08b, 0x2dc, 0x094, 0x2fd, 0x0b5, 0x2e2, 0x0aa, 0x247, 0x00f, 0x258, 0x010,
+    0x279, 0x031, 0x266, 0x02e, 0x23b, 0x073, 0x224, 0x06c, 0x205, 0x04d, 0x21a, 0x052,
+    0x0af, 0x2e7, 0x0b0, 0x2f8, 0x091, 0x2d9, 0x08e, 0x2c6, 0x0d3, 0x29b, 0x0cc, 0x284,
+    0x0ed, 0x2a5, 0x0f2, 0x2ba, 0x057, 0x21f, 0x048, 0x200, 0x069, 0x221, 0x076, 0x23e,
+    0x02b, 0x263, 0x034, 0x27c, 0x015, 0x25d, 0x00a, 0x242, 0x15f, 0x317, 0x140, 0x308,
+    0x161, 0x329, 0x17e, 0x336, 0x123, 0x36b, 0x13c, 0x374, 0x11d, 0x355, 0x102, 0x34a,
+    0x1a7, 0x3ef, 0x1b8, 0x3f0, 0x199, 0x3d1, 0x186, 0x3ce, 0x1db, 0x393, 0x1c4, 0x38c,
+    0x1e5, 0x3ad, 0x1fa, 0x3b2
+  },
+  {
+    0x000, 0x211, 0x0ad, 0x2bc, 0x15a, 0x34b, 0x1f7, 0x3e6, 0x2b4, 0x0a5, 0x219, 0x008,
+    0x3ee, 0x1ff, 0x343, 0x152, 0x1e7, 0x3f6, 0x14a, 0x35b, 0x0bd, 0x2ac, 0x010, 0x201,
+    0x353, 0x142, 0x3fe, 0x1ef, 0x209, 0x018, 0x2a4, 0x0b5, 0x3ce, 0x1df, 0x363, 0x172,
+    0x294, 0x085, 0x239, 0x028, 0x17a, 0x36b, 0x1d7, 0x3c6, 0x020, 0x231, 0x08d, 0x29c,
+    0x229, 0x038, 0x284, 0x095, 0x373, 0x162, 0x3de, 0x1cf, 0x09d, 0x28c, 0x030, 0x221,
+    0x1c7, 0x3d6, 0x16a, 0x37b, 0x313, 0x102, 0x3be, 0x1af, 0x249, 0x058, 0x2e4, 0x0f5,
+    0x1a7, 0x3b6, 0x10a, 0x31b, 0x0fd, 0x2ec, 0x050, 0x241, 0x2f4, 0x0e5, 0x259, 0x048,
+    0x3ae, 0x1bf, 0x303, 0x112, 0x040, 0x251, 0x0ed, 0x2fc, 0x11a, 0x30b, 0x1b7, 0x3a6,
+    0x0dd, 0x2cc, 0x070, 0x261, 0x187, 0x396, 0x12a, 0x33b, 0x269, 0x078, 0x2c4, 0x0d5,
+    0x333, 0x122, 0x39e, 0x18f, 0x13a, 0x32b, 0x197, 0x386, 0x060, 0x271, 0x0cd, 0x2dc,
+    0x38e, 0x19f, 0x323, 0x132, 0x2d4, 0x0c5, 0x279, 0x068, 0x2a9, 0x0b8, 0x204, 0x015,
+    0x3f3, 0x1e2, 0x35e, 0x14f, 0x01d, 0x20c, 0x0b0, 0x2a1, 0x147, 0x356, 0x1ea, 0x3fb,
+    0x34e, 0x15f, 0x3e3, 0x1f2, 0x214, 0x005, 0x2b9, 0x0a8, 0x1fa, 0x3eb, 0x157, 0x346,
+    0x0a0, 0x2b1, 0x00d, 0x21c, 0x167, 0x376, 0x1ca, 0x3db, 0x03d, 0x22c, 0x090, 0x281,
+    0x3d3, 0x1c2, 0x37e, 0x16f, 0x289, 0x098, 0x224, 0x035, 0x080, 0x291, 0x02d, 0x23c,
+    0x1da, 0x3cb, 0x177, 0x366, 0x234, 0x025, 0x299, 0x088, 0x36e, 0x17f, 0x3c3, 0x1d2,
+    0x1ba, 0x3ab, 0x117, 0x306, 0x0e0, 0x2f1, 0x04d, 0x25c, 0x30e, 0x11f, 0x3a3, 0x1b2,
+    0x254, 0x045, 0x2f9, 0x0e8, 0x05d, 0x24c, 0x0f0, 0x2e1, 0x107, 0x316, 0x1aa, 0x3bb,
+    0x2e9, 0x0f8, 0x244, 0x055, 0x3b3, 0x1a2, 0x31e, 0x10f, 0x274, 0x065, 0x2d9, 0x0c8,
+    0x32e, 0x13f, 0x383, 0x192, 0x0c0, 0x2d1, 0x06d, 0x27c, 0x19a, 0x38b, 0x137, 0x326,
+    0x393, 0x182, 0x33e, 0x12f, 0x2c9, 0x0d8, 0x264, 0x075, 0x127, 0x336, 0x18a, 0x39b,
+    0x07d, 0x26c, 0x0d0, 0x2c1
+  }
+};
+
+/**
+*******************************************************************************
+* Function: pec10_cmd_cntr
+* @brief CRC10 command counter tail
+*
+* @details This function shifts the 6 bit command counter of a read back
+*          frame into the CRC10 remainder.
+*
+* Parameters:
+* @param [in]	remainder	Current remainder
+*
+* @param [in] cmd_cntr    Command counter byte (cc in bits 7:2)
+*
+* @return Remainder
+*
+*******************************************************************************
+*/
+RAMFUNC static uint16_t pec10_cmd_cntr(uint16_t remainder, uint8_t cmd_cntr)
 {
-  uint16_t remainder = 16; /* PEC_SEED;   0000010000 */ 
-  uint16_t polynom = 0x8F; /* x10 + x7 + x3 + x2 + x + 1 <- the CRC15 polynomial         100 1000 1111   48F */
-  
-  /* Perform modulo-2 division, a byte at a time. */
-  for (uint8_t pbyte = 0; pbyte < len; ++pbyte)
+  uint16_t polynom = 0x8F; /* x10 + x7 + x3 + x2 + x + 1 */
+  remainder ^= (uint16_t)((cmd_cntr & 0xFC) << 2);
+  /* Perform modulo-2 division, a bit at a time */
+  for (uint8_t bit_ = 6; bit_ > 0; --bit_)
   {
-    /* Bring the next byte into the remainder. */
-    remainder ^= (uint16_t)(data[pbyte] << 2);
-    /* Perform modulo-2 division, a bit at a time.*/
-    for (uint8_t bit_ = 8; bit_ > 0; --bit_)
+    if ((remainder & 0x200) > 0)
     {
-      /* Try to divide the current data bit. */
-      if ((remainder & 0x200) > 0)//equivalent to remainder & 2^14 simply check for MSB
-      {
-        remainder = (uint16_t)((remainder << 1));
-        remainder = (uint16_t)(remainder ^ polynom);
-      }
-      else
-      {
-        remainder = (uint16_t)(remainder << 1);
-      }
+      remainder = (uint16_t)((remainder << 1) ^ polynom);
     }
-  }
-  if (rx_cmd == true)
-  {  
-    remainder ^= (uint16_t)((data[len] & 0xFC) << 2);
-    /* Perform modulo-2 division, a bit at a time */
-    for (uint8_t bit_ = 6; bit_ > 0; --bit_)
+    else
     {
-      /* Try to divide the current data bit */
-      if ((remainder & 0x200) > 0)//equivalent to remainder & 2^14 simply check for MSB
-      {
-        remainder = (uint16_t)((remainder << 1));
-        remainder = (uint16_t)(remainder ^ polynom);
-      }
-      else
-      {
-        remainder = (uint16_t)((remainder << 1));
-      }
+      remainder = (uint16_t)(remainder << 1);
     }
   }
+  return remainder;
+}
+
+/**
+*******************************************************************************
+* Function: pec10_calc
+* @brief CRC10 Pec Calculation Function
+*
+* @details This function calculates and return the CRC10 value, one table
+*          lookup per byte. If rx_cmd is true the command counter at
+*          data[len] is included.
+*
+* Parameters:
+* @param [in]	rx_cmd	Include command counter
+*
+* @param [in] len     Data length
+*
+* @param [in] *data   Data pointer
+*
+* @return CRC10_Value
+*
+*******************************************************************************
+*/
+RAMFUNC uint16_t pec10_calc(bool rx_cmd, int len, uint8_t *data)
+{
+  uint16_t remainder = 16; /* PEC_SEED;   0000010000 */
+  for (int pbyte = 0; pbyte < len; ++pbyte)
+  {
+    remainder = (uint16_t)(((remainder & 0x03) << 8) ^ Crc10Table[0][((remainder >> 2) ^ data[pbyte]) & 0xFF]);
+  }
+  if (rx_cmd == true)
+  {
+    remainder = pec10_cmd_cntr(remainder, data[len]);
+  }
+  return ((uint16_t)(remainder & 0x3FF));
+}
+
+/**
+*******************************************************************************
+* Function: pec10_calc_slice4
+* @brief CRC10 Pec Calculation Function, slice-by-4
+*
+* @details This function calculates the same CRC10 value as pec10_calc,
+*          four bytes per step. Used for the long *ALL read back frames.
+*
+* Parameters:
+* @param [in]	rx_cmd	Include command counter
+*
+* @param [in] len     Data length
+*
+* @param [in] *data   Data pointer
+*
+* @return CRC10_Value
+*
+*******************************************************************************
+*/
+RAMFUNC uint16_t pec10_calc_slice4(bool rx_cmd, int len, uint8_t *data)
+{
+  uint32_t remainder = 16; /* PEC_SEED;   0000010000 */
+  uint32_t word;
+  int pbyte = 0;
+  for (; (pbyte + 4) <= len; pbyte += 4)
+  {
+    /* Remainder is aligned with the first 10 bits of the 32 bit word */
+    word = (remainder << 22) ^ (((uint32_t)data[pbyte] << 24) | ((uint32_t)data[pbyte + 1] << 16) |
+                                ((uint32_t)data[pbyte + 2] << 8) | (uint32_t)data[pbyte + 3]);
+    remainder = (uint32_t)(Crc10Table[3][word >> 24] ^ Crc10Table[2][(word >> 16) & 0xFF] ^
+                           Crc10Table[1][(word >> 8) & 0xFF] ^ Crc10Table[0][word & 0xFF]);
+  }
+  for (; pbyte < len; ++pbyte)
+  {
+    remainder = (((remainder & 0x03) << 8) ^ Crc10Table[0][((remainder >> 2) ^ data[pbyte]) & 0xFF]);
+  }
+  if (rx_cmd == true)
+  {
+    remainder = pec10_cmd_cntr((uint16_t)remainder, data[len]);
+  }
   return ((uint16_t)(remainder & 0x3FF));
 }
 
+/**
+*******************************************************************************
+* Function: adBmsMakeCmd
+* @brief Build command descriptor
+*
+* @details This function build a command only descriptor for commands with
+*          run time arguments (ADCV, ADSV, ADAX...) and calculate the command pec.
+*
+* Parameters:
+* @param [out]	*cmd	Command descriptor
+*
+* @param [in]  cmd0   Command byte 0
+*
+* @param [in]  cmd1   Command byte 1
+*
+* @return None
+*
+*******************************************************************************
+*/
+void adBmsMakeCmd(cmd_desc_ *cmd, uint8_t cmd0, uint8_t cmd1)
+{
+  uint16_t cmd_pec;
+  cmd->frame[0] = cmd0;
+  cmd->frame[1] = cmd1;
+  cmd_pec = Pec15_Calc(2, cmd->frame);
+  cmd->frame[2] = (uint8_t)(cmd_pec >> 8);
+  cmd->frame[3] = (uint8_t)(cmd_pec);
+  cmd->kind = CMD_ONLY;
+  cmd->rx_size = 0;
+  cmd->type = Cmd;
+  cmd->grp = NONE;
+}
+
+/**
+*******************************************************************************
+* Function: adBmsCheckBusFree
+* @brief Check no dma transfer holds the spi bus.
+*
+* @details The blocking transfers must not start while a dma read started by
+*          adBmsReadDataStart is clocking; the transfer is refused and
+*          counted instead of corrupting both frames.
+*
+* @return true if the bus is free, false otherwise
+*
+*******************************************************************************
+*/
+static bool adBmsCheckBusFree(void)
+{
+  if(spiDmaBusy())
+  {
+    xfer_stats.busy_count++;
+    return false;
+  }
+  return true;
+}
+
 /**
 *******************************************************************************
 * Function: spiSendCmd
 * @brief Send command in spi line
 *
-* @details This function send bms command in spi line
+* @details This function send bms command frame (with precomputed pec) in spi line
 *	   
 * Parameters:
-* @param [in]	tx_cmd	Tx command bytes
+* @param [in]	*cmd	Command descriptor
 *
 * @return None
 *
 *******************************************************************************
 */
-void spiSendCmd(uint8_t tx_cmd[2])
+void spiSendCmd(const cmd_desc_ *cmd)
+{
+  if(!adBmsCheckBusFree()){ return; }
+  PROF_BEGIN(PROF_SPI);
+  adBmsCsLow();
+  spiWriteBytes(4, (uint8_t *)&cmd->frame[0]);
+  adBmsCsHigh();
+  PROF_END(PROF_SPI);
+  adBmsCcSent(cmd);
+  xfer_stats.cmd_count++;
+  xfer_stats.tx_bytes += 4;
+}
+
+/**
+*******************************************************************************
+* Function: adBmsCheckIcCount
+* @brief Check daisy chain length against the static buffers.
+*
+* @details This function reject transaction if total ic exceed MAX_IC.
+*
+* Parameters:
+* @param [in]	tIC     Total IC
+*
+* @return true if tIC fits into the driver buffers, false otherwise
+*
+*******************************************************************************
+*/
+static bool adBmsCheckIcCount(uint8_t tIC)
+{
+  if(tIC > MAX_IC)
+  {
+    xfer_stats.reject_count++;
+#ifdef MBED
+    pc.printf(" Total IC %d exceeds MAX_IC %d \n", tIC, MAX_IC);
+#else
+    printf(" Total IC %d exceeds MAX_IC %d \n", tIC, MAX_IC);
+#endif
+    return false;
+  }
+  return true;
+}
+
+/**
+*******************************************************************************
+* Function: spiReadFrame
+* @brief Spi Read raw Bms Data
+*
+* @details This function send bms read command and clock the read back frame
+*          of all ic into the driver receive buffer.
+*
+* Parameters:
+* @param [in]	tIC     Total IC
+*
+* @param [in]  *cmd     Command descriptor (read back size per ic)
+*
+* @return Pointer to the receive buffer, NULL if the bus is held by dma
+*
+*******************************************************************************
+*/
+static uint8_t *spiReadFrame(uint8_t tIC, const cmd_desc_ *cmd)
 {
-  uint8_t cmd[4];
-  uint16_t cmd_pec;	
-  cmd[0] = tx_cmd[0];
-  cmd[1] =  tx_cmd[1];
-  cmd_pec = Pec15_Calc(2, cmd);
-  cmd[2] = (uint8_t)(cmd_pec >> 8);
-  cmd[3] = (uint8_t)(cmd_pec);
+  uint16_t RX_BUFFER = (cmd->rx_size * tIC);
+  if(!adBmsCheckBusFree()){ return NULL; }
+  PROF_BEGIN(PROF_SPI);
   adBmsCsLow();
-  spiWriteBytes(4, &cmd[0]);
+  spiWriteReadBytes((uint8_t *)&cmd->frame[0], &spi_rx_buffer[0], RX_BUFFER);   /* Read the data of all ICs on the daisy chain into receive buffer */
   adBmsCsHigh();
+  PROF_END(PROF_SPI);
+  xfer_stats.read_count++;
+  xfer_stats.tx_bytes += 4;
+  xfer_stats.rx_bytes += RX_BUFFER;
+  return(&spi_rx_buffer[0]);
+}
+
+/**
+*******************************************************************************
+* Function: spiCheckFrame
+* @brief Check raw read back frame.
+*
+* @details This function copy the data bytes of each ic, extract the command
+*          counter and check the data pec of the raw read back frame.
+*
+* Parameters:
+* @param [in]	tIC     Total IC
+*
+* @param [in]  *cmd     Command descriptor (read back size per ic)
+*
+* @param [in]  *data    Raw read back frame
+*
+* @param [in]  *rx_data Rx data pointer
+*
+* @param [in]  *pec_error Pec error pointer
+*
+* @param [in]  *cmd_cntr command counter pointer
+*
+* @return None
+*
+*******************************************************************************
+*/
+static void spiCheckFrame
+(
+uint8_t tIC,
+const cmd_desc_ *cmd,
+uint8_t *data,
+uint8_t *rx_data,
+uint8_t *pec_error,
+uint8_t *cmd_cntr
+)
+{
+  uint16_t received_pec, calculated_pec;
+  uint8_t BYTES_IN_REG = cmd->rx_size;
+  uint16_t src_address;
+
+  for (uint8_t current_ic = 0; current_ic < tIC; current_ic++)     /* executes for each ic in the daisy chain and packs the data */
+  {																																      /* Into the r_comm array as well as check the received data for any bit errors */
+    src_address = (current_ic * BYTES_IN_REG);
+    for (uint8_t current_byte = 0; current_byte < (BYTES_IN_REG-2); current_byte++)
+    {
+      rx_data[src_address + current_byte] = data[src_address + current_byte];
+    }
+    /* Get command counter value */
+    cmd_cntr[current_ic] = (data[src_address + (BYTES_IN_REG - 2)] >> 2);
+    /* Get received pec value from ic*/
+    received_pec = (uint16_t)(((data[src_address + (BYTES_IN_REG - 2)] & 0x03) << 8) | data[src_address + (BYTES_IN_REG - 1)]);
+    /* Calculate data pec in place, the command counter byte follows the data */
+    if (BYTES_IN_REG > RX_DATA){ calculated_pec = pec10_calc_slice4(true, (BYTES_IN_REG-2), &data[src_address]); }
+    else{ calculated_pec = pec10_calc(true, (BYTES_IN_REG-2), &data[src_address]); }
+    /* Match received pec with calculated pec */
+    if (received_pec == calculated_pec){ pec_error[current_ic] = 0; }/* If no error is there value set to 0 */
+    else{ pec_error[current_ic] = 1; }                               /* If error is there value set to 1 */
+    if (pec_error[current_ic] == 0){ adBmsCcCheck(current_ic, cmd_cntr[current_ic]); }
+  }
 }
+
 /**
 *******************************************************************************
 * Function: spiReadData
@@ -171,7 +540,7 @@ void spiSendCmd(uint8_t tx_cmd[2])
 * Parameters:
 * @param [in]	tIC     Total IC
 *
-* @param [in]  tx_cmd   Tx command bytes
+* @param [in]  *cmd     Command descriptor (read back size per ic)
 *
 * @param [in]  *rx_data Rx data pointer
 *
@@ -186,62 +555,21 @@ void spiSendCmd(uint8_t tx_cmd[2])
 void spiReadData
 ( 
 uint8_t tIC, 
-uint8_t tx_cmd[2], 
+const cmd_desc_ *cmd,
 uint8_t *rx_data,
 uint8_t *pec_error,
-uint8_t *cmd_cntr,
-uint8_t regData_size
+uint8_t *cmd_cntr
 )
 {
-  uint8_t *data, *copyArray, src_address = 0;
-  uint16_t cmd_pec, received_pec, calculated_pec;
-  uint8_t BYTES_IN_REG = regData_size;
-  uint8_t RX_BUFFER = (regData_size * tIC);
-  
-  data = (uint8_t *)calloc(RX_BUFFER, sizeof(uint8_t));
-  copyArray = (uint8_t *)calloc(BYTES_IN_REG, sizeof(uint8_t));
-  if((data == NULL) || (copyArray == NULL))
+  uint8_t *frame;
+  if(!adBmsCheckIcCount(tIC)){ return; }
+  frame = spiReadFrame(tIC, cmd);
+  if(frame == NULL)
   {
-   #ifdef MBED     
-    pc.printf(" Failed to allocate spi read data memory \n");
-    #else
-    printf(" Failed to allocate spi read data memory \n");
-    #endif	  
-    exit(0);
+    memset(&pec_error[0], 1, tIC);  /* Not read, flag every ic */
+    return;
   }
-  else
-  {
-    uint8_t cmd[4];
-    cmd[0] = tx_cmd[0];
-    cmd[1] = tx_cmd[1];
-    cmd_pec = Pec15_Calc(2, cmd);
-    cmd[2] = (uint8_t)(cmd_pec >> 8);
-    cmd[3] = (uint8_t)(cmd_pec);
-    adBmsCsLow();
-    spiWriteReadBytes(&cmd[0], &data[0], RX_BUFFER);                 /* Read the configuration data of all ICs on the daisy chain into readdata array */
-    adBmsCsHigh();
-    for (uint8_t current_ic = 0; current_ic < tIC; current_ic++)     /* executes for each ic in the daisy chain and packs the data */
-    {																																      /* Into the r_comm array as well as check the received data for any bit errors */
-      for (uint8_t current_byte = 0; current_byte < (BYTES_IN_REG-2); current_byte++)
-      {
-        rx_data[(current_ic*BYTES_IN_REG)+current_byte] = data[current_byte + (current_ic*BYTES_IN_REG)];
-      }
-      /* Get command counter value */
-      cmd_cntr[current_ic] = (data[(current_ic * BYTES_IN_REG) + (BYTES_IN_REG - 2)] >> 2);
-      /* Get received pec value from ic*/
-      received_pec = (uint16_t)(((data[(current_ic * BYTES_IN_REG) + (BYTES_IN_REG - 2)] & 0x03) << 8) | data[(current_ic * BYTES_IN_REG) + (BYTES_IN_REG - 1)]);
-      /* Copy each ic correspond data + pec value for calculate data pec */
-      memcpy(&copyArray[0], &data[src_address], BYTES_IN_REG);
-      src_address = ((current_ic+1) * (regData_size));
-      /* Calculate data pec */
-      calculated_pec = (uint16_t)pec10_calc(true, (BYTES_IN_REG-2), &copyArray[0]);
-      /* Match received pec with calculated pec */
-      if (received_pec == calculated_pec){ pec_error[current_ic] = 0; }/* If no error is there value set to 0 */
-      else{ pec_error[current_ic] = 1; }                               /* If error is there value set to 1 */                         
-    }
-  }
-  free(data);
-  free(copyArray);
+  spiCheckFrame(tIC, cmd, frame, rx_data, pec_error, cmd_cntr);
 }
 
 /**
@@ -254,7 +582,7 @@ uint8_t regData_size
 * Parameters:
 * @param [in]	tIC      Total IC
 *
-* @param [in]  tx_cmd   Tx command bytes
+* @param [in]  *cmd     Command descriptor
 *
 * @param [in]  *data   Data pointer
 *				
@@ -265,319 +593,663 @@ uint8_t regData_size
 void spiWriteData
 (
 uint8_t tIC, 
-uint8_t tx_cmd[2], 
+const cmd_desc_ *cmd,
 uint8_t *data
 )
 {
   uint8_t BYTES_IN_REG = TX_DATA;
-  uint8_t CMD_LEN = 4 + (RX_DATA * tIC);
-  uint16_t data_pec, cmd_pec;
-  uint8_t *cmd, copyArray[TX_DATA], src_address = 0;
-  uint8_t cmd_index;
-  cmd = (uint8_t *)calloc(CMD_LEN, sizeof(uint8_t)); 
-  if(cmd == NULL)
-  {
-#ifdef MBED
-    pc.printf(" Failed to allocate cmd array memory \n");
-#else
-    printf(" Failed to allocate cmd array memory \n");
-#endif  
-    exit(0);
-  }
-  else
+  uint16_t CMD_LEN = 4 + (RX_DATA * tIC);
+  uint16_t data_pec;
+  uint8_t *tx = &spi_tx_buffer[0], copyArray[TX_DATA + 1];
+  uint16_t cmd_index, src_address;
+
+  if(!adBmsCheckIcCount(tIC) || !adBmsCheckBusFree()){ return; }
+  memcpy(&tx[0], &cmd->frame[0], 4); /* Command + precomputed pec */
+  cmd_index = 4;
+  /* executes for each LTC68xx, this loops starts with the last IC on the stack */
+  for (uint8_t current_ic = tIC; current_ic > 0; current_ic--)
   {
-    cmd[0] = tx_cmd[0];
-    cmd[1] = tx_cmd[1];
-    cmd_pec = Pec15_Calc(2, cmd);
-    cmd[2] = (uint8_t)(cmd_pec >> 8);
-    cmd[3] = (uint8_t)(cmd_pec);
-    cmd_index = 4;
-    /* executes for each LTC68xx, this loops starts with the last IC on the stack */
-    for (uint8_t current_ic = tIC; current_ic > 0; current_ic--)                
-    {	                                                                      
-      src_address = ((current_ic-1) * TX_DATA); 
-      /* The first configuration written is received by the last IC in the daisy chain */
-      for (uint8_t current_byte = 0; current_byte < BYTES_IN_REG; current_byte++)
-      {
-        cmd[cmd_index] = data[((current_ic-1)*6)+current_byte];
-        cmd_index = cmd_index + 1;
-      }
-      /* Copy each ic correspond data + pec value for calculate data pec */
-      memcpy(&copyArray[0], &data[src_address], TX_DATA); /* dst, src, size */
-      /* calculating the PEC for each Ics configuration register data */
-      data_pec = (uint16_t)pec10_calc(true,BYTES_IN_REG, &copyArray[0]);  
-      cmd[cmd_index] = (uint8_t)(data_pec >> 8);
-      cmd_index = cmd_index + 1;
-      cmd[cmd_index] = (uint8_t)data_pec;
+    src_address = ((current_ic-1) * TX_DATA);
+    /* The first configuration written is received by the last IC in the daisy chain */
+    for (uint8_t current_byte = 0; current_byte < BYTES_IN_REG; current_byte++)
+    {
+      tx[cmd_index] = data[src_address + current_byte];
       cmd_index = cmd_index + 1;
     }
-    adBmsCsLow();
-    spiWriteBytes(CMD_LEN, &cmd[0]);
-    adBmsCsHigh();
+    /* Copy each ic data for the data pec; the pec covers the command counter
+       field after the data, which is 0 on a write */
+    memcpy(&copyArray[0], &data[src_address], TX_DATA); /* dst, src, size */
+    copyArray[TX_DATA] = 0;
+    /* calculating the PEC for each Ics configuration register data */
+    data_pec = (uint16_t)pec10_calc(true,BYTES_IN_REG, &copyArray[0]);
+    tx[cmd_index] = (uint8_t)(data_pec >> 8);
+    cmd_index = cmd_index + 1;
+    tx[cmd_index] = (uint8_t)data_pec;
+    cmd_index = cmd_index + 1;
   }
-  free(cmd); 
+  PROF_BEGIN(PROF_SPI);
+  adBmsCsLow();
+  spiWriteBytes(CMD_LEN, &tx[0]);
+  adBmsCsHigh();
+  PROF_END(PROF_SPI);
+  adBmsCcSent(cmd);
+  xfer_stats.write_count++;
+  xfer_stats.tx_bytes += CMD_LEN;
+}
+
+/* Register parser, group comes from the command descriptor */
+typedef void (*parse_fn_)(uint8_t tIC, cell_asic *ic, GRP grp, uint8_t *data);
+
+/* One register segment of a read back frame */
+typedef struct
+{
+  parse_fn_ parse;      /* Segment parser                         */
+  uint8_t data_offset;  /* Segment byte offset in read back frame */
+  uint8_t pec_offset;   /* offsetof cmdcnt_pec_ pec error flag    */
+} parse_seg_;
+
+/* Parser entry for one register TYPE */
+typedef struct
+{
+  uint8_t seg_count;
+  parse_seg_ seg[3];
+} parse_entry_;
+
+static void adBmsParseComm(uint8_t tIC, cell_asic *ic, GRP grp, uint8_t *data)
+{
+  (void)grp;
+  adBms6830ParseComm(tIC, ic, data);
+}
+
+static void adBmsParseSid(uint8_t tIC, cell_asic *ic, GRP grp, uint8_t *data)
+{
+  (void)grp;
+  adBms6830ParseSID(tIC, ic, data);
 }
 
+#define PEC_FLAG(flag) ((uint8_t)offsetof(cmdcnt_pec_, flag))
+
+/* Read back parser table, indexed by descriptor TYPE */
+static const parse_entry_ parse_table[Cmd] =
+{
+  [Cell]     = { 1, { { adBms6830ParseCell,        0, PEC_FLAG(cell_pec)  } } },
+  [Aux]      = { 1, { { adBms6830ParseAux,         0, PEC_FLAG(aux_pec)   } } },
+  [RAux]     = { 1, { { adBms6830ParseRAux,        0, PEC_FLAG(raux_pec)  } } },
+  [Status]   = { 1, { { adBms6830ParseStatus,      0, PEC_FLAG(stat_pec)  } } },
+  [Pwm]      = { 1, { { adBms6830ParsePwm,         0, PEC_FLAG(pwm_pec)   } } },
+  [AvgCell]  = { 1, { { adBms6830ParseAverageCell, 0, PEC_FLAG(acell_pec) } } },
+  [S_volt]   = { 1, { { adBms6830ParseSCell,       0, PEC_FLAG(scell_pec) } } },
+  [F_volt]   = { 1, { { adBms6830ParseFCell,       0, PEC_FLAG(fcell_pec) } } },
+  [Config]   = { 1, { { adBms6830ParseConfig,      0, PEC_FLAG(cfgr_pec)  } } },
+  [Comm]     = { 1, { { adBmsParseComm,            0, PEC_FLAG(comm_pec)  } } },
+  [Sid]      = { 1, { { adBmsParseSid,             0, PEC_FLAG(sid_pec)   } } },
+};
+
+/* Segment of a *ALL read back frame */
+typedef struct
+{
+  uint8_t data_offset;  /* Segment byte offset in read back frame       */
+  uint8_t size;         /* Segment bytes                                */
+  uint16_t dst_offset;  /* offsetof cell_asic code array, 0 = no codes  */
+  uint8_t pec_offset;   /* offsetof cmdcnt_pec_ pec error flag          */
+  uint8_t pack_bit;     /* PACK_PEC_x, 0 = not kept in the pack store   */
+  uint16_t pack_offset; /* offsetof pack_store_ code array              */
+} all_seg_;
+
+/* Fused parser entry for one *ALL TYPE */
+typedef struct
+{
+  uint8_t seg_count;
+  all_seg_ seg[3];
+} all_entry_;
+
+#define CODES(codes) ((uint16_t)offsetof(cell_asic, codes))
+#define PACK(bit, codes) bit, ((uint16_t)offsetof(pack_store_, codes))
+#define NO_PACK 0, 0
+#define STATUS_SEG 0
+
+/* *ALL read back frame layout, indexed by descriptor TYPE */
+static const all_entry_ all_table[Cmd] =
+{
+  /* 32 byte data + 2 byte pec */
+  [Rdcvall]  = { 1, { {  0, 32, CODES(cell.c_codes),   PEC_FLAG(cell_pec),  PACK(PACK_PEC_CELL, cell)   } } },
+  [Rdacall]  = { 1, { {  0, 32, CODES(acell.ac_codes), PEC_FLAG(acell_pec), NO_PACK                      } } },
+  [Rdsall]   = { 1, { {  0, 32, CODES(scell.sc_codes), PEC_FLAG(scell_pec), PACK(PACK_PEC_SCELL, scell) } } },
+  [Rdfcall]  = { 1, { {  0, 32, CODES(fcell.fc_codes), PEC_FLAG(fcell_pec), NO_PACK                      } } },
+  /* 64 byte + 2 byte pec = 32 byte (avg) cell data + 32 byte scell volt data */
+  [Rdcsall]  = { 2, { {  0, 32, CODES(cell.c_codes),   PEC_FLAG(cell_pec),  PACK(PACK_PEC_CELL, cell)   },
+                      { 32, 32, CODES(scell.sc_codes), PEC_FLAG(scell_pec), PACK(PACK_PEC_SCELL, scell) } } },
+  [Rdacsall] = { 2, { {  0, 32, CODES(acell.ac_codes), PEC_FLAG(acell_pec), NO_PACK                      },
+                      { 32, 32, CODES(scell.sc_codes), PEC_FLAG(scell_pec), PACK(PACK_PEC_SCELL, scell) } } },
+  /* 68 byte + 2 byte pec: 24 byte gpio data + 20 byte Redundant gpio data +
+     24 byte status A(6 byte), B(6 byte), C(4 byte), D(6 byte) & E(2 byte) */
+  [Rdasall]  = { 3, { {  0, 24, CODES(aux.a_codes),    PEC_FLAG(aux_pec),   PACK(PACK_PEC_AUX, aux)     },
+                      { 24, 20, CODES(raux.ra_codes),  PEC_FLAG(raux_pec),  NO_PACK                      },
+                      { 44, 24, STATUS_SEG,            PEC_FLAG(stat_pec),  PACK_PEC_STAT, 0            } } },
+};
+
 /**
 *******************************************************************************
-* Function: adBmsReadData
-* @brief Adbms Read Data From Bms ic. 
-*
-* @details This function send bms command, read payload data parse into function and check pec error.
+* Function: adBmsPackBits
+* @brief Pack store pec bits updated by a read command.
 *
 * Parameters:
-* @param [in]	tIC      Total IC
+* @param [in]  *cmd     Read command descriptor
 *
-* @param [in]  *ic      cell_asic stucture pointer
+* @return PACK_PEC_x bits, 0 if the command is not kept in the pack store
 *
-* @param [in]  cmd_arg   command bytes
-*			
-* @param [in]  TYPE   Enum type of resistor  
+*******************************************************************************
+*/
+static uint8_t adBmsPackBits(const cmd_desc_ *cmd)
+{
+  uint8_t bits = 0;
+  if (cmd->grp == ALL_GRP)
+  {
+    for (uint8_t s = 0; s < all_table[cmd->type].seg_count; s++)
+    {
+      bits |= all_table[cmd->type].seg[s].pack_bit;
+    }
+    return bits;
+  }
+  switch (cmd->type)
+  {
+  case Cell:   return PACK_PEC_CELL;
+  case S_volt: return PACK_PEC_SCELL;
+  case Aux:    return PACK_PEC_AUX;
+  case Status: return PACK_PEC_STAT;
+  default:     return 0;
+  }
+}
+
+/**
+*******************************************************************************
+* Function: adBmsPackStatus
+* @brief Copy decoded status of one ic into the pack store.
 *
-* @param [in]  GRP   Enum type of resistor group
-*	
-* @return None 
+* Parameters:
+* @param [in]  cic      Ic index in the chain
+*
+* @param [in]  *ic      cell_asic of the ic
+*
+* @return None
 *
 *******************************************************************************
 */
-void adBmsReadData(uint8_t tIC, cell_asic *ic, uint8_t cmd_arg[2], TYPE type, GRP group)
+static void adBmsPackStatus(uint8_t cic, cell_asic *ic)
 {
-  uint16_t rBuff_size;
-  uint8_t regData_size;
-  if(group == ALL_GRP)
+  uint16_t ov = 0, uv = 0;
+  pack_store->vref2[cic] = ic->stata.vref2;
+  pack_store->itmp[cic] = ic->stata.itmp;
+  for (uint8_t c = 0; c < CELL; c++)
   {
-    if(type == Rdcvall){rBuff_size = RDCVALL_SIZE; regData_size = RDCVALL_SIZE;}
-    else if(type == Rdsall){rBuff_size = RDSALL_SIZE; regData_size = RDSALL_SIZE;}
-    else if(type == Rdacall){rBuff_size = RDACALL_SIZE; regData_size = RDACALL_SIZE;}
-    else if(type == Rdfcall){rBuff_size = RDFCALL_SIZE; regData_size = RDFCALL_SIZE;}
-    else if(type == Rdcsall){rBuff_size = RDCSALL_SIZE; regData_size = RDCSALL_SIZE;}
-    else if(type == Rdasall){rBuff_size = RDASALL_SIZE; regData_size = RDASALL_SIZE;}
-    else if(type == Rdacsall){rBuff_size = RDACSALL_SIZE; regData_size = RDACSALL_SIZE;}
-    else{printf("Read All cmd wrong type select \n");}
+    ov |= (uint16_t)((ic->statd.c_ov[c] & 0x01) << c);
+    uv |= (uint16_t)((ic->statd.c_uv[c] & 0x01) << c);
   }
-  else{rBuff_size = (tIC * RX_DATA); regData_size = RX_DATA;}
-  uint8_t *read_buffer, *pec_error, *cmd_count;
-  read_buffer = (uint8_t *)calloc(rBuff_size, sizeof(uint8_t));
-  pec_error = (uint8_t *)calloc(tIC, sizeof(uint8_t)); 
-  cmd_count = (uint8_t *)calloc(tIC, sizeof(uint8_t));
-  if((pec_error == NULL) || (cmd_count == NULL) || (read_buffer == NULL))
+  pack_store->c_ov[cic] = ov;
+  pack_store->c_uv[cic] = uv;
+}
+
+/**
+*******************************************************************************
+* Function: adBmsPackStale
+* @brief Set or clear the stale bits of one register read.
+*
+* @details A register group covers 3 codes (group A codes 0-2, B 3-5 ...),
+*          a *ALL read covers every code of the type.
+*
+* Parameters:
+* @param [in]  cic      Ic index in the chain
+*
+* @param [in]  bit      PACK_PEC_x type of the codes
+*
+* @param [in]  grp      Register group read
+*
+* @param [in]  stale    true: read failed, pack store codes kept
+*
+* @return None
+*
+*******************************************************************************
+*/
+static void adBmsPackStale(uint8_t cic, uint8_t bit, GRP grp, bool stale)
+{
+  uint16_t *flags;
+  uint32_t mask;
+  switch (bit)
   {
-#ifdef MBED
-    pc.printf(" Failed to allocate memory \n");
-#else
-    printf(" Failed to allocate memory \n");
-#endif
-    exit(0);
+  case PACK_PEC_CELL:  flags = &pack_store->cell_stale[cic];  mask = (1u << CELL) - 1u; break;
+  case PACK_PEC_SCELL: flags = &pack_store->scell_stale[cic]; mask = (1u << CELL) - 1u; break;
+  case PACK_PEC_AUX:   flags = &pack_store->aux_stale[cic];   mask = (1u << AUX) - 1u;  break;
+  default: return; /* Status, ic level pec_err bit only */
   }
-  else
-  {
-    spiReadData(tIC, &cmd_arg[0], &read_buffer[0], &pec_error[0], &cmd_count[0], regData_size);
-    switch (type)
+  if (grp != ALL_GRP){ mask &= (0x7u << ((grp - A) * 3)); }
+  *flags = (uint16_t)(stale ? (*flags | mask) : (*flags & ~mask));
+}
+
+/**
+*******************************************************************************
+* Function: adBmsPackSync
+* @brief Copy group read results into the pack store.
+*
+* @details Group reads are parsed into cell_asic first; the register type is
+*          then copied into the pack store for the ics read with a good pec
+*          and marked dirty, see adBmsPackStatsUpdate. An ic with a pec
+*          error keeps its last good codes, the read group is marked stale.
+*
+* Parameters:
+* @param [in]	tIC      Total IC
+*
+* @param [in]  *ic      cell_asic stucture pointer
+*
+* @param [in]  *cmd     Read command descriptor
+*
+* @param [in]  ic_mask  Ics parsed by the read
+*
+* @return None
+*
+*******************************************************************************
+*/
+static void adBmsPackSync(uint8_t tIC, cell_asic *ic, const cmd_desc_ *cmd, uint32_t ic_mask)
+{
+  uint8_t bits = adBmsPackBits(cmd);
+  if (bits == 0){ return; }
+  for (uint8_t cic = 0; cic < tIC; cic++)
+  {
+    if ((ic_mask & (1u << cic)) == 0){ continue; }
+    pack_store->cmd_cntr[cic] = ic[cic].cccrc.cmd_cntr;
+    adBmsPackStale(cic, bits, (GRP)cmd->grp, (pec_error[cic] != 0));
+    if (pec_error[cic] != 0)
+    {
+      pack_store->pec_err[cic] |= bits;
+      continue;
+    }
+    switch (cmd->type)
     {
-    case Config:
-      adBms6830ParseConfig(tIC, ic, group, &read_buffer[0]);
-      for (uint8_t cic = 0; cic < tIC; cic++)
-      {							
-        ic[cic].cccrc.cfgr_pec = pec_error[cic];
-        ic[cic].cccrc.cmd_cntr = cmd_count[cic];
-      }
-      break;
-      
     case Cell:
-      adBms6830ParseCell(tIC, ic, group, &read_buffer[0]);
-      for (uint8_t cic = 0; cic < tIC; cic++)
-      {							
-        ic[cic].cccrc.cell_pec = pec_error[cic];
-        ic[cic].cccrc.cmd_cntr = cmd_count[cic];
-      }
+      memcpy(&pack_store->cell[cic * CELL], &ic[cic].cell.c_codes[0], sizeof(ic[cic].cell.c_codes));
       break;
-      
-    case AvgCell:
-      adBms6830ParseAverageCell(tIC, ic, group, &read_buffer[0]);
-      for (uint8_t cic = 0; cic < tIC; cic++)
-      {							
-        ic[cic].cccrc.acell_pec = pec_error[cic];
-        ic[cic].cccrc.cmd_cntr = cmd_count[cic];
-      }
-      break;
-      
     case S_volt:
-      adBms6830ParseSCell(tIC, ic, group, &read_buffer[0]);
-      for (uint8_t cic = 0; cic < tIC; cic++)
-      {							
-        ic[cic].cccrc.scell_pec = pec_error[cic];
-        ic[cic].cccrc.cmd_cntr = cmd_count[cic];
-      }
-      break;
-      
-    case F_volt:
-      adBms6830ParseFCell(tIC, ic, group, &read_buffer[0]);
-      for (uint8_t cic = 0; cic < tIC; cic++)
-      {							
-        ic[cic].cccrc.fcell_pec = pec_error[cic];
-        ic[cic].cccrc.cmd_cntr = cmd_count[cic];
-      }
+      memcpy(&pack_store->scell[cic * CELL], &ic[cic].scell.sc_codes[0], sizeof(ic[cic].scell.sc_codes));
       break;
-      
     case Aux:
-      adBms6830ParseAux(tIC, ic, group, &read_buffer[0]);
-      for (uint8_t cic = 0; cic < tIC; cic++)
-      {
-        ic[cic].cccrc.aux_pec = pec_error[cic];
-        ic[cic].cccrc.cmd_cntr = cmd_count[cic];
-      }
+      memcpy(&pack_store->aux[cic * AUX], &ic[cic].aux.a_codes[0], sizeof(ic[cic].aux.a_codes));
       break;
-      
-    case RAux:
-      adBms6830ParseRAux(tIC, ic, group, &read_buffer[0]);
-      for (uint8_t cic = 0; cic < tIC; cic++)
-      {
-        ic[cic].cccrc.raux_pec = pec_error[cic];
-        ic[cic].cccrc.cmd_cntr = cmd_count[cic];
-      }
-      break;
-      
-    case Status:
-      adBms6830ParseStatus(tIC, ic, group, &read_buffer[0]);
-      for (uint8_t cic = 0; cic < tIC; cic++)
-      {
-        ic[cic].cccrc.stat_pec = pec_error[cic];
-        ic[cic].cccrc.cmd_cntr = cmd_count[cic];
-      }
+    default: /* Status */
+      adBmsPackStatus(cic, &ic[cic]);
       break;
-      
-    case Comm:
-      adBms6830ParseComm(tIC, ic, &read_buffer[0]);
-      for (uint8_t cic = 0; cic < tIC; cic++)
-      {
-        ic[cic].cccrc.comm_pec = pec_error[cic];
-        ic[cic].cccrc.cmd_cntr = cmd_count[cic];
-      }
-      break;
-      
-    case Pwm:
-      adBms6830ParsePwm(tIC, ic, group, &read_buffer[0]);
-      for (uint8_t cic = 0; cic < tIC; cic++)
+    }
+    pack_store->pec_err[cic] &= (uint8_t)~bits;
+    pack_store->dirty[cic] |= bits;
+  }
+  pack_store->tIC = tIC;
+}
+
+/**
+*******************************************************************************
+* Function: adBmsReadAll
+* @brief Fused *ALL read back parse and pec check.
+*
+* @details This function walks the raw receive buffer once per ic. Each 16 bit
+*          code is fed into the pec (slice-by-2) and staged in the same step;
+*          status bytes are only fed into the pec. Only an ic with a good pec
+*          gets the staged codes and the decoded status, in cell_asic and in
+*          the pack store; a failed ic keeps its last good values.
+*
+* Parameters:
+* @param [in]	tIC      Total IC
+*
+* @param [in]  *ic      cell_asic stucture pointer
+*
+* @param [in]  *cmd     *ALL read command descriptor
+*
+* @param [in]  *frame   Raw read back frame
+*
+* @param [in]  ic_mask  Ics to parse, the others are left untouched
+*
+* @return None
+*
+*******************************************************************************
+*/
+static void adBmsReadAll(uint8_t tIC, cell_asic *ic, const cmd_desc_ *cmd, uint8_t *frame, uint32_t ic_mask)
+{
+  const all_entry_ *entry = &all_table[cmd->type];
+  const all_seg_ *seg;
+  uint8_t size = cmd->rx_size;
+  uint8_t *raw;
+  int16_t code[MAX_RX_SIZE / 2];
+  uint16_t remainder, word, received_pec;
+  uint8_t pec, pack_bits = adBmsPackBits(cmd);
+
+  for (uint8_t cic = 0; cic < tIC; cic++)
+  {
+    if ((ic_mask & (1u << cic)) == 0){ continue; }
+    raw = &frame[cic * size];
+    remainder = 16; /* PEC_SEED */
+    for (uint8_t byte = 0; byte < (size - 2); byte += 2)
+    {
+      word = (uint16_t)((remainder << 6) ^ ((raw[byte] << 8) | raw[byte + 1]));
+      remainder = Crc10Table[1][word >> 8] ^ Crc10Table[0][word & 0xFF];
+      code[byte / 2] = (int16_t)(raw[byte] | (raw[byte + 1] << 8));
+    }
+    remainder = pec10_cmd_cntr(remainder, raw[size - 2]);
+    received_pec = (uint16_t)(((raw[size - 2] & 0x03) << 8) | raw[size - 1]);
+    pec = (received_pec == (remainder & 0x3FF)) ? 0 : 1;
+    ic[cic].cccrc.cmd_cntr = (raw[size - 2] >> 2);
+    for (uint8_t s = 0; s < entry->seg_count; s++)
+    {
+      seg = &entry->seg[s];
+      ((uint8_t *)&ic[cic].cccrc)[seg->pec_offset] = pec;
+      if ((pack_store != NULL) && (seg->pack_bit != 0)){ adBmsPackStale(cic, seg->pack_bit, ALL_GRP, (pec != 0)); }
+      if (pec != 0){ continue; }
+      if (seg->dst_offset == STATUS_SEG)
       {
-        ic[cic].cccrc.pwm_pec = pec_error[cic];
-        ic[cic].cccrc.cmd_cntr = cmd_count[cic];
+        adBms6830ParseStatus(1, &ic[cic], ALL_GRP, &raw[seg->data_offset]);
+        if (pack_store != NULL){ adBmsPackStatus(cic, &ic[cic]); }
+        continue;
       }
-      break;
-      
-    case Sid:
-      adBms6830ParseSID(tIC, ic, &read_buffer[0]);
-      for (uint8_t cic = 0; cic < tIC; cic++)
+      memcpy((uint8_t *)&ic[cic] + seg->dst_offset, &code[seg->data_offset / 2], seg->size);
+      if ((pack_store != NULL) && (seg->pack_offset != 0))
       {
-        ic[cic].cccrc.sid_pec = pec_error[cic];
-        ic[cic].cccrc.cmd_cntr = cmd_count[cic];
+        memcpy((int16_t *)((uint8_t *)pack_store + seg->pack_offset) + (cic * (seg->size / 2)), &code[seg->data_offset / 2], seg->size);
       }
-      break;
-      
-    case Rdcvall:
-      /* 32 byte cell data + 2 byte pec */
-      adBms6830ParseCell(tIC, ic, group, &read_buffer[0]);
-      for (uint8_t cic = 0; cic < tIC; cic++)
-      {							
-        ic[cic].cccrc.cell_pec = pec_error[cic];
-        ic[cic].cccrc.cmd_cntr = cmd_count[cic];
-      }
-      break;
-      
-    case Rdacall:
-      /* 32 byte avg cell data + 2 byte pec */
-      adBms6830ParseAverageCell(tIC, ic, group, &read_buffer[0]);
-      for (uint8_t cic = 0; cic < tIC; cic++)
-      {							
-        ic[cic].cccrc.acell_pec = pec_error[cic];
-        ic[cic].cccrc.cmd_cntr = cmd_count[cic];
-      }
-      break;
-      
-    case Rdsall:
-      /* 32 byte scell volt data + 2 byte pec */
-      adBms6830ParseSCell(tIC, ic, group, &read_buffer[0]);
-      for (uint8_t cic = 0; cic < tIC; cic++)
-      {							
-        ic[cic].cccrc.scell_pec = pec_error[cic];
-        ic[cic].cccrc.cmd_cntr = cmd_count[cic];
-      }
-      break;
-      
-    case Rdfcall:
-      /* 32 byte fcell data + 2 byte pec */
-      adBms6830ParseFCell(tIC, ic, group, &read_buffer[0]);
-      for (uint8_t cic = 0; cic < tIC; cic++)
-      {							
-        ic[cic].cccrc.fcell_pec = pec_error[cic];
-        ic[cic].cccrc.cmd_cntr = cmd_count[cic];
-      }
-      break;
-      
-    case Rdcsall:
-      /* 64 byte + 2 byte pec = 32 byte cell data + 32 byte scell volt data */
-      adBms6830ParseCell(tIC, ic, group, &read_buffer[0]);
-      for (uint8_t cic = 0; cic < tIC; cic++)
-      {							
-        ic[cic].cccrc.cell_pec = pec_error[cic];
-        ic[cic].cccrc.cmd_cntr = cmd_count[cic];
-      }
-      adBms6830ParseSCell(tIC, ic, group, &read_buffer[32]);
-      for (uint8_t cic = 0; cic < tIC; cic++)
-      {							
-        ic[cic].cccrc.scell_pec = pec_error[cic];
-        ic[cic].cccrc.cmd_cntr = cmd_count[cic];
-      }
-      break;
-      
-    case Rdacsall:
-      /* 64 byte + 2 byte pec = 32 byte avg cell data + 32 byte scell volt data */
-      adBms6830ParseAverageCell(tIC, ic, group, &read_buffer[0]);
-      for (uint8_t cic = 0; cic < tIC; cic++)
-      {							
-        ic[cic].cccrc.acell_pec = pec_error[cic];
-        ic[cic].cccrc.cmd_cntr = cmd_count[cic];
-      }
-      adBms6830ParseSCell(tIC, ic, group, &read_buffer[32]);
-      for (uint8_t cic = 0; cic < tIC; cic++)
-      {							
-        ic[cic].cccrc.scell_pec = pec_error[cic];
-        ic[cic].cccrc.cmd_cntr = cmd_count[cic];
-      }
-      break;
-      
-    case Rdasall:
-      /* 68 byte + 2 byte pec: 
-      24 byte gpio data + 20 byte Redundant gpio data +
-      24 byte status A(6 byte), B(6 byte), C(4 byte), D(6 byte) & E(2 byte)
-      */
-      adBms6830ParseAux(tIC, ic, group, &read_buffer[0]);
-      for (uint8_t cic = 0; cic < tIC; cic++)
-      {
-        ic[cic].cccrc.aux_pec = pec_error[cic];
-        ic[cic].cccrc.cmd_cntr = cmd_count[cic];
-      }
-      adBms6830ParseRAux(tIC, ic, group, &read_buffer[24]);
-      for (uint8_t cic = 0; cic < tIC; cic++)
+    }
+    if (pec == 0){ adBmsCcCheck(cic, ic[cic].cccrc.cmd_cntr); }
+    if (pack_store != NULL)
+    {
+      pack_store->cmd_cntr[cic] = ic[cic].cccrc.cmd_cntr;
+      if (pec != 0){ pack_store->pec_err[cic] |= pack_bits; }
+      else
       {
-        ic[cic].cccrc.raux_pec = pec_error[cic];
-        ic[cic].cccrc.cmd_cntr = cmd_count[cic];
+        pack_store->pec_err[cic] &= (uint8_t)~pack_bits;
+        pack_store->dirty[cic] |= pack_bits;
       }
-      adBms6830ParseStatus(tIC, ic, group, &read_buffer[44]);
-      for (uint8_t cic = 0; cic < tIC; cic++)
+    }
+  }
+  if (pack_store != NULL){ pack_store->tIC = tIC; }
+}
+
+/**
+*******************************************************************************
+* Function: adBmsParseFrame
+* @brief Parse raw read back frame into cell_asic.
+*
+* @details The parser is selected by the descriptor register type, *ALL reads
+*          use the fused single pass parser. Group reads are parsed per ic,
+*          only when the ic pec is good, so cell_asic keeps the last good
+*          register values.
+*
+* Parameters:
+* @param [in]	tIC      Total IC
+*
+* @param [in]  *ic      cell_asic stucture pointer
+*
+* @param [in]  *cmd     Read command descriptor
+*
+* @param [in]  *frame   Raw read back frame
+*
+* @param [in]  ic_mask  Ics to parse, the others are left untouched
+*
+* @return None
+*
+*******************************************************************************
+*/
+static void adBmsParseFrame(uint8_t tIC, cell_asic *ic, const cmd_desc_ *cmd, uint8_t *frame, uint32_t ic_mask)
+{
+  const parse_entry_ *entry;
+  const parse_seg_ *seg;
+  if(cmd->grp == ALL_GRP)
+  {
+    adBmsReadAll(tIC, ic, cmd, frame, ic_mask);
+    return;
+  }
+  spiCheckFrame(tIC, cmd, frame, &read_buffer[0], &pec_error[0], &cmd_count[0]);
+  entry = &parse_table[cmd->type];
+  for (uint8_t cic = 0; cic < tIC; cic++)
+  {
+    if ((ic_mask & (1u << cic)) == 0){ continue; }
+    for (uint8_t s = 0; s < entry->seg_count; s++)
+    {
+      seg = &entry->seg[s];
+      if (pec_error[cic] == 0){ seg->parse(1, &ic[cic], (GRP)cmd->grp, &read_buffer[(cic * cmd->rx_size) + seg->data_offset]); }
+      ((uint8_t *)&ic[cic].cccrc)[seg->pec_offset] = pec_error[cic];
+    }
+    ic[cic].cccrc.cmd_cntr = cmd_count[cic];
+  }
+  if(pack_store != NULL){ adBmsPackSync(tIC, ic, cmd, ic_mask); }
+}
+
+/**
+*******************************************************************************
+* Function: adBmsSetPecError
+* @brief Flag pec error for a failed read.
+*
+* @details This function set the pec error flag of every register segment of
+*          the read command, the register data is left untouched and marked
+*          stale in the pack store.
+*
+* Parameters:
+* @param [in]	tIC      Total IC
+*
+* @param [in]  *ic      cell_asic stucture pointer
+*
+* @param [in]  *cmd     Read command descriptor
+*
+* @param [in]  ic_mask  Ics to flag, bit n = ic n, READ_IC_ALL for all
+*
+* @return None
+*
+*******************************************************************************
+*/
+static void adBmsSetPecError(uint8_t tIC, cell_asic *ic, const cmd_desc_ *cmd, uint32_t ic_mask)
+{
+  uint8_t seg_count, pec_offset, bits = adBmsPackBits(cmd);
+  for (uint8_t cic = 0; cic < tIC; cic++)
+  {
+    if((ic_mask & (1u << cic)) == 0){ continue; }
+    seg_count = (cmd->grp == ALL_GRP) ? all_table[cmd->type].seg_count : parse_table[cmd->type].seg_count;
+    for (uint8_t s = 0; s < seg_count; s++)
+    {
+      pec_offset = (cmd->grp == ALL_GRP) ? all_table[cmd->type].seg[s].pec_offset : parse_table[cmd->type].seg[s].pec_offset;
+      ((uint8_t *)&ic[cic].cccrc)[pec_offset] = 1;
+    }
+    if(pack_store != NULL)
+    {
+      pack_store->pec_err[cic] |= bits;
+      for (uint8_t bit = PACK_PEC_CELL; bit <= PACK_PEC_AUX; bit <<= 1)
       {
-        ic[cic].cccrc.stat_pec = pec_error[cic];
-        ic[cic].cccrc.cmd_cntr = cmd_count[cic];
+        if(bits & bit){ adBmsPackStale(cic, bit, (GRP)cmd->grp, true); }
       }
-      break;
-      
-    default:
-      break;
     }
   }
-  free(read_buffer);
-  free(pec_error); 
-  free(cmd_count); 
 }
+
+/**
+*******************************************************************************
+* Function: adBmsCheckReadCmd
+* @brief Check read command descriptor.
+*
+* Parameters:
+* @param [in]	tIC      Total IC
+*
+* @param [in]  *cmd     Read command descriptor
+*
+* @return true if the descriptor is a read command that fits the driver buffers
+*
+*******************************************************************************
+*/
+static bool adBmsCheckReadCmd(uint8_t tIC, const cmd_desc_ *cmd)
+{
+  if(!adBmsCheckIcCount(tIC)){ return false; }
+  if((cmd->kind != CMD_READ) || (cmd->type >= Cmd) || (cmd->rx_size > MAX_RX_SIZE))
+  {
+    printf("Read cmd wrong type select \n");
+    return false;
+  }
+  return true;
+}
+
+/**
+*******************************************************************************
+* Function: adBmsReadData
+* @brief Adbms Read Data From Bms ic. 
+*
+* @details This function send bms command, read payload data parse into function and check pec error.
+*          The parser is selected by the descriptor register type, *ALL reads
+*          use the fused single pass parser.
+*
+* Parameters:
+* @param [in]	tIC      Total IC
+*
+* @param [in]  *ic      cell_asic stucture pointer
+*
+* @param [in]  *cmd     Read command descriptor
+*	
+* @return None 
+*
+*******************************************************************************
+*/
+void adBmsReadData(uint8_t tIC, cell_asic *ic, const cmd_desc_ *cmd)
+{
+  adBmsReadDataMask(tIC, ic, cmd, READ_IC_ALL);
+}
+
+/**
+*******************************************************************************
+* Function: adBmsReadDataMask
+* @brief Adbms Read Data of selected ics.
+*
+* @details The daisy chain always clocks the register of every ic; only the
+*          ics in ic_mask are parsed, have their pec flags updated and are
+*          copied into the pack store. Used to retry a read for the ics that
+*          failed it without touching the ones already read good.
+*
+* Parameters:
+* @param [in]	tIC      Total IC
+*
+* @param [in]  *ic      cell_asic stucture pointer
+*
+* @param [in]  *cmd     Read command descriptor
+*
+* @param [in]  ic_mask  Ics to parse, bit n = ic n, READ_IC_ALL for all
+*
+* @return None
+*
+*******************************************************************************
+*/
+void adBmsReadDataMask(uint8_t tIC, cell_asic *ic, const cmd_desc_ *cmd, uint32_t ic_mask)
+{
+  uint8_t *frame;
+  if(!adBmsCheckReadCmd(tIC, cmd)){ return; }
+  frame = spiReadFrame(tIC, cmd);
+  if(frame == NULL)
+  {
+    adBmsSetPecError(tIC, ic, cmd, ic_mask);
+    return;
+  }
+  PROF_BEGIN(PROF_PARSE);
+  adBmsParseFrame(tIC, ic, cmd, frame, ic_mask);
+  PROF_END(PROF_PARSE);
+}
+
+/**
+*******************************************************************************
+* Function: adBmsReadPecMask
+* @brief Ics with a pec error on the register of a read command.
+*
+* @details All segments of one read share the ic pec, the flag of the first
+*          segment stands for the whole read.
+*
+* Parameters:
+* @param [in]	tIC      Total IC
+*
+* @param [in]  *ic      cell_asic stucture pointer
+*
+* @param [in]  *cmd     Read command descriptor
+*
+* @return Ic mask, bit n set = ic n pec error
+*
+*******************************************************************************
+*/
+uint32_t adBmsReadPecMask(uint8_t tIC, cell_asic *ic, const cmd_desc_ *cmd)
+{
+  uint32_t mask = 0;
+  uint8_t pec_offset;
+  if((cmd->type >= Cmd) || (tIC > MAX_IC)){ return 0; }
+  pec_offset = (cmd->grp == ALL_GRP) ? all_table[cmd->type].seg[0].pec_offset : parse_table[cmd->type].seg[0].pec_offset;
+  for (uint8_t cic = 0; cic < tIC; cic++)
+  {
+    if(((uint8_t *)&ic[cic].cccrc)[pec_offset] != 0){ mask |= (1u << cic); }
+  }
+  return mask;
+}
+
+/**
+*******************************************************************************
+* Function: adBmsReadDataStart
+* @brief Start dma read of Bms Data.
+*
+* @details This function start the read command as spi dma transfer and
+*          returns immediately. The frame is parsed by adBmsReadDataFinish
+*          once the transfer is done; done_cb is called from the dma interrupt.
+*
+* Parameters:
+* @param [in]	tIC      Total IC
+*
+* @param [in]  *ic      cell_asic stucture pointer (must stay valid until finish)
+*
+* @param [in]  *cmd     Read command descriptor
+*
+* @param [in]  done_cb  Transfer done callback (optional)
+*
+* @return false if the command is invalid or a transfer is already pending
+*
+*******************************************************************************
+*/
+bool adBmsReadDataStart(uint8_t tIC, cell_asic *ic, const cmd_desc_ *cmd, void (*done_cb)(void))
+{
+  uint16_t RX_BUFFER = (cmd->rx_size * tIC);
+  if(dma_read.pending || !adBmsCheckReadCmd(tIC, cmd)){ return false; }
+  if(!spiWriteReadBytesDma((uint8_t *)&cmd->frame[0], RX_BUFFER, done_cb)){ return false; }
+  dma_read.tIC = tIC;
+  dma_read.ic = ic;
+  dma_read.cmd = cmd;
+  dma_read.pending = true;
+  xfer_stats.read_count++;
+  xfer_stats.tx_bytes += 4;
+  xfer_stats.rx_bytes += RX_BUFFER;
+  return true;
+}
+
+/**
+*******************************************************************************
+* Function: adBmsReadDataFinish
+* @brief Finish dma read of Bms Data.
+*
+* @details This function parse the dma read back frame into cell_asic once the
+*          transfer is done (call from thread context, not from done_cb).
+*          A failed transfer sets the pec error flags of the read registers.
+*
+* @return false while the transfer is still pending, true otherwise
+*
+*******************************************************************************
+*/
+bool adBmsReadDataFinish(void)
+{
+  if(!dma_read.pending){ return true; }
+  if(spiDmaBusy()){ return false; }
+  dma_read.pending = false;
+  if(spiDmaError())
+  {
+    adBmsSetPecError(dma_read.tIC, dma_read.ic, dma_read.cmd, READ_IC_ALL);
+  }
+  else
+  {
+    PROF_BEGIN(PROF_PARSE);
+    adBmsParseFrame(dma_read.tIC, dma_read.ic, dma_read.cmd, spiDmaRxData(), READ_IC_ALL);
+    PROF_END(PROF_PARSE);
+  }
+  return true;
+}
+
 /**
 *******************************************************************************
 * Function: adBmsWriteData
@@ -590,154 +1262,206 @@ void adBmsReadData(uint8_t tIC, cell_asic *ic, uint8_t cmd_arg[2], TYPE type, GR
 *
 * @param [in]  *ic      cell_asic stucture pointer
 *
-* @param [in]  cmd_arg   command bytes
-*			
-* @param [in]  TYPE   Enum type of resistor  
-*
-* @param [in]  GRP   Enum type of resistor group
+* @param [in]  *cmd     Write command descriptor
 *	
 * @return None 
 *
 *******************************************************************************
 */
-void adBmsWriteData(uint8_t tIC, cell_asic *ic, uint8_t cmd_arg[2], TYPE type, GRP group)
+void adBmsWriteData(uint8_t tIC, cell_asic *ic, const cmd_desc_ *cmd)
 {	  
-  uint8_t data_len = TX_DATA, write_size = (TX_DATA * tIC);
-  uint8_t *write_buffer = (uint8_t *)calloc(write_size, sizeof(uint8_t));
-  if(write_buffer == NULL)
+  uint8_t data_len = TX_DATA;
+  if(!adBmsCheckIcCount(tIC)){ return; }
+  if(cmd->kind != CMD_WRITE)
   {
-#ifdef MBED
-    pc.printf(" Failed to allocate write_buffer array memory \n");
-#else
-    printf(" Failed to allocate write_buffer array memory \n");
-#endif
-    exit(0);
+    printf("Write cmd wrong type select \n");
+    return;
   }
-  else
-  {
-    switch (type)
-    {	   
-    case Config:	
-      switch (group)
+  switch (cmd->type)
+  {	   
+  case Config:	
+    switch (cmd->grp)
+    {
+    case A:
+      adBms6830CreateConfiga(tIC, &ic[0]);
+      for (uint8_t cic = 0; cic < tIC; cic++)
       {
-      case A:
-        adBms6830CreateConfiga(tIC, &ic[0]);
-        for (uint8_t cic = 0; cic < tIC; cic++)
-        {
-          for (uint8_t data = 0; data < data_len; data++)
-          {
-            write_buffer[(cic * data_len) + data] = ic[cic].configa.tx_data[data];
-          }
-        }
-        break;
-      case B:
-        adBms6830CreateConfigb(tIC, &ic[0]);
-        for (uint8_t cic = 0; cic < tIC; cic++)
+        for (uint8_t data = 0; data < data_len; data++)
         {
-          for (uint8_t data = 0; data < data_len; data++)
-          {
-            write_buffer[(cic * data_len) + data] = ic[cic].configb.tx_data[data];
-          }		
+          write_buffer[(cic * data_len) + data] = ic[cic].configa.tx_data[data];
         }
-        break;
       }
       break;
-      
-    case Comm:
-      adBms6830CreateComm(tIC, &ic[0]);
+    case B:
+      adBms6830CreateConfigb(tIC, &ic[0]);
       for (uint8_t cic = 0; cic < tIC; cic++)
       {
         for (uint8_t data = 0; data < data_len; data++)
         {
-          write_buffer[(cic * data_len) + data] = ic[cic].com.tx_data[data];
-        }	
+          write_buffer[(cic * data_len) + data] = ic[cic].configb.tx_data[data];
+        }		
       }
       break;
-      
-    case Pwm:
-      switch (group)
+    }
+    break;
+    
+  case Comm:
+    adBms6830CreateComm(tIC, &ic[0]);
+    for (uint8_t cic = 0; cic < tIC; cic++)
+    {
+      for (uint8_t data = 0; data < data_len; data++)
       {
-      case A:
-        adBms6830CreatePwma(tIC, &ic[0]);
-        for (uint8_t cic = 0; cic < tIC; cic++)
-        {
-          for (uint8_t data = 0; data < data_len; data++)
-          {
-            write_buffer[(cic * data_len) + data] = ic[cic].pwma.tx_data[data];
-          }	
-        }
-        break;   
-      case B:
-        adBms6830CreatePwmb(tIC, &ic[0]);
-        for (uint8_t cic = 0; cic < tIC; cic++)
+        write_buffer[(cic * data_len) + data] = ic[cic].com.tx_data[data];
+      }	
+    }
+    break;
+    
+  case Pwm:
+    switch (cmd->grp)
+    {
+    case A:
+      adBms6830CreatePwma(tIC, &ic[0]);
+      for (uint8_t cic = 0; cic < tIC; cic++)
+      {
+        for (uint8_t data = 0; data < data_len; data++)
         {
-          for (uint8_t data = 0; data < data_len; data++)
-          {
-            write_buffer[(cic * data_len) + data] = ic[cic].pwmb.tx_data[data];
-          }	
-        }
-        break;
+          write_buffer[(cic * data_len) + data] = ic[cic].pwma.tx_data[data];
+        }	
       }
-      break;
-      
-    case Clrflag:	
-      adBms6830CreateClrflagData(tIC, &ic[0]);
+      break;   
+    case B:
+      adBms6830CreatePwmb(tIC, &ic[0]);
       for (uint8_t cic = 0; cic < tIC; cic++)
       {
         for (uint8_t data = 0; data < data_len; data++)
         {
-          write_buffer[(cic * data_len) + data] = ic[cic].clrflag.tx_data[data];
-        }
+          write_buffer[(cic * data_len) + data] = ic[cic].pwmb.tx_data[data];
+        }	
       }
       break;
-      
-    default:
-      break;
     }
+    break;
+    
+  case Clrflag:	
+    adBms6830CreateClrflagData(tIC, &ic[0]);
+    for (uint8_t cic = 0; cic < tIC; cic++)
+    {
+      for (uint8_t data = 0; data < data_len; data++)
+      {
+        write_buffer[(cic * data_len) + data] = ic[cic].clrflag.tx_data[data];
+      }
+    }
+    break;
+    
+  default:
+    break;
   }
-  spiWriteData(tIC, cmd_arg, &write_buffer[0]);	
-  free(write_buffer);
+  spiWriteData(tIC, cmd, &write_buffer[0]);
+  if(cmd->type == Config){ adBmsCfgShadowNote(tIC, cmd, &write_buffer[0]); }
 }
 
 /**
 *******************************************************************************
-* Function: adBmsPollAdc
-* @brief PLADC Command. 
+* Function: adBmsProbeAdc
+* @brief Single poll adc probe.
 *
-* @details Send poll adc command and retun adc conversion count.
+* @details Send poll command and clock one byte, then release chip select.
+*          Does not wait for the conversion.
 *
 * Parameters:
-*	
-* @param [in]  tIC      Total IC 
 *
-* @param [in]  tx_cmd   Tx command byte 
+* @param [in]  *cmd     Poll command descriptor
 *
-* @return None 
+* @return true if SDO reads high (conversion done)
 *
 *******************************************************************************
 */
-uint32_t adBmsPollAdc(uint8_t tx_cmd[2])
+bool adBmsProbeAdc(const cmd_desc_ *cmd)
 {
-  uint32_t conv_count = 0;
-  uint8_t cmd[4];
-  uint16_t cmd_pec;
   uint8_t read_data = 0x00;
-  uint8_t SDO_Line = 0xFF;
-  cmd[0] = tx_cmd[0];
-  cmd[1] = tx_cmd[1];
-  cmd_pec = Pec15_Calc(2, cmd);
-  cmd[2] = (uint8_t)(cmd_pec >> 8);
-  cmd[3] = (uint8_t)(cmd_pec);
-  startTimer();
+  if(!adBmsCheckBusFree()){ return false; }
+  PROF_BEGIN(PROF_SPI);
   adBmsCsLow();
-  spiWriteBytes(4, &cmd[0]);
-  do{
-    spiReadBytes(1, &read_data);
-  }while(!(read_data == SDO_Line));
+  spiWriteBytes(4, (uint8_t *)&cmd->frame[0]);
+  spiReadBytes(1, &read_data);
   adBmsCsHigh();
-  conv_count = getTimCount();
-  stopTimer();
-  return(conv_count);
+  PROF_END(PROF_SPI);
+  xfer_stats.poll_count++;
+  xfer_stats.tx_bytes += 4;
+  xfer_stats.rx_bytes += 1;
+  return(read_data == 0xFF);
+}
+
+/**
+*******************************************************************************
+* Function: adBmsSetPackStore
+* @brief Select the pack level store.
+*
+* @details Cell, S-cell, aux codes and status summary of every read are also
+*          written into the pack store (ic major, contiguous), next to the
+*          cell_asic structures. NULL disables the pack store.
+*
+* Parameters:
+* @param [in]  *pack    Pack store pointer
+*
+* @return None
+*
+*******************************************************************************
+*/
+void adBmsSetPackStore(pack_store_ *pack)
+{
+  pack_store = pack;
+}
+
+/**
+*******************************************************************************
+* Function: adBmsGetPackStore
+* @brief Registered pack level store.
+*
+* @return Pack store pointer, NULL if none
+*
+*******************************************************************************
+*/
+pack_store_ *adBmsGetPackStore(void)
+{
+  return pack_store;
+}
+
+/**
+*******************************************************************************
+* Function: adBmsGetXferStats
+* @brief Driver transaction counters.
+*
+* @details This function return the transaction and byte counters of the
+*          driver. All transactions use static buffers, no heap is used.
+*
+* Parameters:
+*
+* @return Pointer to the transaction counters
+*
+*******************************************************************************
+*/
+const xfer_stats_ *adBmsGetXferStats(void)
+{
+  return(&xfer_stats);
+}
+
+/**
+*******************************************************************************
+* Function: adBmsClearXferStats
+* @brief Clear driver transaction counters.
+*
+* @details This function reset the transaction and byte counters to zero.
+*
+* Parameters:
+*
+* @return None
+*
+*******************************************************************************
+*/
+void adBmsClearXferStats(void)
+{
+  memset(&xfer_stats, 0, sizeof(xfer_stats));
 }
 
 /**
@@ -772,10 +1496,10 @@ RSTF rstf,
 OW_C_S owcs
 )
 {
-  uint8_t cmd[2];
-  cmd[0] = 0x02 + rd;
-  cmd[1] = (cont<<7)+(dcp<<4)+(rstf<<2)+(owcs & 0x03) + 0x60;
-  spiSendCmd(cmd);
+  cmd_desc_ cmd;
+  adBmsMakeCmd(&cmd, (0x02 + rd), ((cont<<7)+(dcp<<4)+(rstf<<2)+(owcs & 0x03) + 0x60));
+  spiSendCmd(&cmd);
+  adBmsAdcSchedStart(ADC_CONV_C, (owcs != OW_OFF_ALL_CH));
 }
 
 /**
@@ -804,10 +1528,10 @@ DCP dcp,
 OW_C_S owcs
 )
 {
-  uint8_t cmd[2];
-  cmd[0] = 0x01;
-  cmd[1] = (cont<<7)+(dcp<<4)+(owcs &0x03) + 0x68;
-  spiSendCmd(cmd);
+  cmd_desc_ cmd;
+  adBmsMakeCmd(&cmd, 0x01, ((cont<<7)+(dcp<<4)+(owcs &0x03) + 0x68));
+  spiSendCmd(&cmd);
+  adBmsAdcSchedStart(ADC_CONV_S, (owcs != OW_OFF_ALL_CH));
 }
 
 /**
@@ -836,10 +1560,10 @@ PUP pup,
 CH ch
 )
 {
-  uint8_t cmd[2];
-  cmd[0] = 0x04 + owaux;
-  cmd[1] = (pup << 7) + (((ch >>4)&0x01)<<6) + (ch & 0x0F) + 0x10;
-  spiSendCmd(cmd);
+  cmd_desc_ cmd;
+  adBmsMakeCmd(&cmd, (0x04 + owaux), ((pup << 7) + (((ch >>4)&0x01)<<6) + (ch & 0x0F) + 0x10));
+  spiSendCmd(&cmd);
+  adBmsAdcSchedStart(ADC_CONV_AUX, (owaux != AUX_OW_OFF));
 }
 /**
 *******************************************************************************
@@ -861,10 +1585,10 @@ void adBms6830_Adax2
 CH ch
 )
 {
-  uint8_t cmd[2];
-  cmd[0] = 0x04;
-  cmd[1] = (ch & 0x0F);
-  spiSendCmd(cmd);
+  cmd_desc_ cmd;
+  adBmsMakeCmd(&cmd, 0x04, (ch & 0x0F));
+  spiSendCmd(&cmd);
+  adBmsAdcSchedStart(ADC_CONV_AUX2, false);
 }
 
 /** @}*/
@@ -0,0 +1,376 @@
+/*******************************************************************************
+* @file:    adBms6830OwSched.c
+* @brief:   Open wire detection
+*****************************************************************************/
+/*! \addtogroup BMS_DRIVER
+*  @{
+*/
+
+/*! @addtogroup OW_SCHED OPEN WIRE DETECTION
+*  @{
+*/
+#include "common.h"
+#include "adbms_main.h"
+#include "adBms6830CmdList.h"
+#include "adBms6830OwSched.h"
+
+#define OW_WAIT_S    (1u << ADC_CONV_S)
+#define OW_WAIT_AUX  (1u << ADC_CONV_AUX)
+
+static ow_cfg_ ow_cfg = { OW_PERIOD_DEFAULT_MS, OW_CELL_TH_DEFAULT_UV, OW_AUX_TH_DEFAULT_UV };
+static ow_stats_ ow_stats;
+
+/* Background sequence state */
+static struct
+{
+  OW_STEP step;
+  bool started;       /* Conversion of the step sent          */
+  uint8_t wait;       /* Converters still running, OW_WAIT_x  */
+  uint32_t skip;      /* Ics with a pec error this sequence   */
+  uint32_t open;      /* Ics with an open wire, last sequence */
+  uint32_t last_ms;   /* End of the last sequence             */
+} ow;
+
+static int32_t owAbs(int32_t x){ return (x < 0) ? -x : x; }
+
+/**
+*******************************************************************************
+* Function: adBmsOwCellStore
+* @brief Keep the cell codes of an open wire conversion.
+*
+* Parameters:
+* @param [in]	tIC      Total IC
+*
+* @param [in]  *ic      cell_asic stucture pointer
+*
+* @param [in]  type     Cell (C-ADC codes) or S_volt (S-ADC codes)
+*
+* @param [in]  owcs     OW_ON_EVEN_CH or OW_ON_ODD_CH, the conversion current
+*
+* @return None
+*
+*******************************************************************************
+*/
+void adBmsOwCellStore(uint8_t tIC, cell_asic *ic, TYPE type, OW_C_S owcs)
+{
+  int16_t *code;
+  int *dst;
+  for(uint8_t cic = 0; cic < tIC; cic++)
+  {
+    code = (type == S_volt) ? &ic[cic].scell.sc_codes[0] : &ic[cic].cell.c_codes[0];
+    dst = (owcs == OW_ON_ODD_CH) ? &ic[cic].owcell.cell_ow_odd[0] : &ic[cic].owcell.cell_ow_even[0];
+    for(uint8_t cell = 0; cell < CELL; cell++){ dst[cell] = code[cell]; }
+  }
+}
+
+/**
+*******************************************************************************
+* Function: adBmsOwAuxStore
+* @brief Keep the gpio codes of an open wire conversion.
+*
+* Parameters:
+* @param [in]	tIC      Total IC
+*
+* @param [in]  *ic      cell_asic stucture pointer
+*
+* @param [in]  pup      PUP_UP or PUP_DOWN, the conversion current
+*
+* @return None
+*
+*******************************************************************************
+*/
+void adBmsOwAuxStore(uint8_t tIC, cell_asic *ic, PUP pup)
+{
+  int *dst;
+  for(uint8_t cic = 0; cic < tIC; cic++)
+  {
+    dst = (pup == PUP_UP) ? &ic[cic].gpio.aux_pup_up[0] : &ic[cic].gpio.aux_pup_down[0];
+    for(uint8_t gpio = 0; gpio < (AUX - 2); gpio++){ dst[gpio] = ic[cic].aux.a_codes[gpio]; }
+  }
+}
+
+/**
+*******************************************************************************
+* Function: adBmsOwCellCheck
+* @brief Compare the even and odd open wire codes of every cell.
+*
+* @details An open sense wire lets the open wire current pull the pin, the
+*          cell reads differently with the current on the even and on the
+*          odd channels; a connected wire reads the same. The difference is
+*          compared in uV, the code offset cancels out.
+*
+* Parameters:
+* @param [in]	tIC      Total IC
+*
+* @param [in]  *ic      cell_asic stucture pointer
+*
+* @param [in]  type     Cell (result in cell_ow) or S_volt (result in cellred_ow)
+*
+* @param [in]  th_uv    Difference that flags an open wire (uV)
+*
+* @param [in]  ic_mask  Ics to check, bit n = ic n; the others keep their result
+*
+* @return Ic mask with at least one open wire
+*
+*******************************************************************************
+*/
+uint32_t adBmsOwCellCheck(uint8_t tIC, cell_asic *ic, TYPE type, int32_t th_uv, uint32_t ic_mask)
+{
+  uint32_t open = 0;
+  uint8_t *result;
+  int32_t diff_uv;
+  for(uint8_t cic = 0; cic < tIC; cic++)
+  {
+    if((ic_mask & (1u << cic)) == 0){ continue; }
+    result = (type == S_volt) ? &ic[cic].diag_result.cellred_ow[0] : &ic[cic].diag_result.cell_ow[0];
+    for(uint8_t cell = 0; cell < CELL; cell++)
+    {
+      diff_uv = (int32_t)(ic[cic].owcell.cell_ow_even[cell] - ic[cic].owcell.cell_ow_odd[cell]) * CODE_LSB_UV;
+      result[cell] = (owAbs(diff_uv) > th_uv) ? 1 : 0;
+      if(result[cell]){ open |= (1u << cic); }
+    }
+  }
+  return open;
+}
+
+/**
+*******************************************************************************
+* Function: adBmsOwAuxCheck
+* @brief Compare the pull-up and pull-down codes of every gpio.
+*
+* @details A floating gpio follows the pull current, a connected one is held
+*          by its circuit.
+*
+* Parameters:
+* @param [in]	tIC      Total IC
+*
+* @param [in]  *ic      cell_asic stucture pointer
+*
+* @param [in]  th_uv    Difference that flags an open wire (uV)
+*
+* @param [in]  ic_mask  Ics to check, bit n = ic n; the others keep their result
+*
+* @return Ic mask with at least one open wire
+*
+*******************************************************************************
+*/
+uint32_t adBmsOwAuxCheck(uint8_t tIC, cell_asic *ic, int32_t th_uv, uint32_t ic_mask)
+{
+  uint32_t open = 0;
+  int32_t diff_uv;
+  for(uint8_t cic = 0; cic < tIC; cic++)
+  {
+    if((ic_mask & (1u << cic)) == 0){ continue; }
+    for(uint8_t gpio = 0; gpio < (AUX - 2); gpio++)
+    {
+      diff_uv = (int32_t)(ic[cic].gpio.aux_pup_up[gpio] - ic[cic].gpio.aux_pup_down[gpio]) * CODE_LSB_UV;
+      ic[cic].diag_result.aux_ow[gpio] = (owAbs(diff_uv) > th_uv) ? 1 : 0;
+      if(ic[cic].diag_result.aux_ow[gpio]){ open |= (1u << cic); }
+    }
+  }
+  return open;
+}
+
+/**
+*******************************************************************************
+* Function: adBmsOwStart
+* @brief Send the conversion of a sequence step.
+*
+* Parameters:
+* @param [in]  step     Sequence step
+*
+* @return None
+*
+*******************************************************************************
+*/
+static void adBmsOwStart(OW_STEP step)
+{
+  switch(step)
+  {
+  case OW_STEP_CELL_EVEN: adBms6830_Adsv(SINGLE, DCP_OFF, OW_ON_EVEN_CH); ow.wait = OW_WAIT_S; break;
+  case OW_STEP_CELL_ODD:  adBms6830_Adsv(SINGLE, DCP_OFF, OW_ON_ODD_CH);  ow.wait = OW_WAIT_S; break;
+  case OW_STEP_AUX_UP:    adBms6830_Adax(AUX_OW_ON, PUP_UP, AUX_ALL);     ow.wait = OW_WAIT_AUX; break;
+  case OW_STEP_AUX_DOWN:  adBms6830_Adax(AUX_OW_ON, PUP_DOWN, AUX_ALL);   ow.wait = OW_WAIT_AUX; break;
+  default: /* OW_STEP_SETTLE */
+    adBms6830_Adsv(SINGLE, DCP_OFF, OW_OFF_ALL_CH);
+    adBms6830_Adax(AUX_OW_OFF, PUP_DOWN, AUX_ALL);
+    ow.wait = OW_WAIT_S | OW_WAIT_AUX;
+    break;
+  }
+}
+
+/**
+*******************************************************************************
+* Function: adBmsOwRead
+* @brief Read the result of a sequence step.
+*
+* @details The open wire codes are read with the pack store detached, so they
+*          never reach the pack level data; cell_asic holds them afterwards.
+*          An ic with a pec error is left out of the check of this sequence.
+*
+* Parameters:
+* @param [in]	tIC      Total IC
+*
+* @param [in]  *ic      cell_asic stucture pointer
+*
+* @param [in]  *cmd     Read command descriptor
+*
+* @return None
+*
+*******************************************************************************
+*/
+static void adBmsOwRead(uint8_t tIC, cell_asic *ic, const cmd_desc_ *cmd)
+{
+  pack_store_ *pack = adBmsGetPackStore();
+  adBmsSetPackStore(NULL);
+  adBmsReadData(tIC, ic, cmd);
+  adBmsSetPackStore(pack);
+  ow.skip |= adBmsReadPecMask(tIC, ic, cmd);
+}
+
+/**
+*******************************************************************************
+* Function: adBmsOwConfig
+* @brief Set open wire detection period and thresholds.
+*
+* Parameters:
+* @param [in]  *cfg     Settings
+*
+* @return None
+*
+*******************************************************************************
+*/
+void adBmsOwConfig(const ow_cfg_ *cfg)
+{
+  ow_cfg = *cfg;
+}
+
+/**
+*******************************************************************************
+* Function: adBmsOwStep
+* @brief Advance the background open wire sequence by one step.
+*
+* @details Call once per acquisition tick, before the normal conversions.
+*          Every period_ms the sequence takes the S-ADC and aux adc over:
+*          cell even, cell odd, gpio pull-up, gpio pull-down, then one
+*          settle conversion without current whose result is discarded. A
+*          call sends at most one conversion or one read and never waits for
+*          the adc, the sequence spreads over the ticks the conversions take.
+*          A normal conversion running when the sequence starts is dropped.
+*          Results go to owcell, gpio and diag_result (cellred_ow, aux_ow).
+*
+* Parameters:
+* @param [in]	tIC      Total IC
+*
+* @param [in]  *ic      cell_asic stucture pointer
+*
+* @return true while the sequence owns the S-ADC and aux adc, skip their
+*         normal conversions (the C-ADC and other reads carry on)
+*
+*******************************************************************************
+*/
+bool adBmsOwStep(uint8_t tIC, cell_asic *ic)
+{
+  uint32_t open, checked;
+  if(ow.step == OW_STEP_IDLE)
+  {
+    if((getTickMs() - ow.last_ms) < ow_cfg.period_ms){ return false; }
+    ow.step = OW_STEP_CELL_EVEN;
+    ow.started = false;
+    ow.skip = 0;
+  }
+  if(!ow.started)
+  {
+    adBmsOwStart(ow.step);
+    ow.started = true;
+    return true;
+  }
+  if((ow.wait & OW_WAIT_S) && (adBmsAdcPoll(ADC_CONV_S) != ADC_BUSY)){ ow.wait &= ~OW_WAIT_S; }
+  if((ow.wait & OW_WAIT_AUX) && (adBmsAdcPoll(ADC_CONV_AUX) != ADC_BUSY)){ ow.wait &= ~OW_WAIT_AUX; }
+  if(ow.wait != 0){ return true; }
+  switch(ow.step)
+  {
+  case OW_STEP_CELL_EVEN:
+  case OW_STEP_CELL_ODD:
+    adBmsOwRead(tIC, ic, &RDSALL);
+    adBmsOwCellStore(tIC, ic, S_volt, (ow.step == OW_STEP_CELL_ODD) ? OW_ON_ODD_CH : OW_ON_EVEN_CH);
+    break;
+  case OW_STEP_AUX_UP:
+  case OW_STEP_AUX_DOWN:
+    adBmsOwRead(tIC, ic, &RDASALL);
+    adBmsOwAuxStore(tIC, ic, (ow.step == OW_STEP_AUX_UP) ? PUP_UP : PUP_DOWN);
+    break;
+  default: /* OW_STEP_SETTLE, nothing to keep */
+    break;
+  }
+  ow.started = false;
+  ow.step = (OW_STEP)(ow.step + 1);
+  if(ow.step < OW_STEP_NB){ return true; }
+  /* Sequence complete, ics with a failed read keep their last result */
+  checked = ~ow.skip;
+  open = adBmsOwCellCheck(tIC, ic, S_volt, ow_cfg.cell_th_uv, checked);
+  open |= adBmsOwAuxCheck(tIC, ic, ow_cfg.aux_th_uv, checked);
+  ow.open = (ow.open & ow.skip) | open;
+  ow_stats.cell_open = 0;
+  ow_stats.aux_open = 0;
+  for(uint8_t cic = 0; cic < tIC; cic++)
+  {
+    for(uint8_t cell = 0; cell < CELL; cell++){ ow_stats.cell_open += ic[cic].diag_result.cellred_ow[cell]; }
+    for(uint8_t gpio = 0; gpio < (AUX - 2); gpio++){ ow_stats.aux_open += ic[cic].diag_result.aux_ow[gpio]; }
+    if(ow.skip & (1u << cic)){ ow_stats.skip_count++; }
+  }
+  ow_stats.run_count++;
+  ow.step = OW_STEP_IDLE;
+  ow.last_ms = getTickMs();
+  return false;
+}
+
+/**
+*******************************************************************************
+* Function: adBmsOwOpenMask
+* @brief Ics with an open wire.
+*
+* @return Ic mask, bit n set = ic n had a cell or gpio wire open in the last sequence
+*
+*******************************************************************************
+*/
+uint32_t adBmsOwOpenMask(void)
+{
+  return ow.open;
+}
+
+/**
+*******************************************************************************
+* Function: adBmsOwReset
+* @brief Restart open wire detection.
+*
+* @details Clears results and counters, the next adBmsOwStep starts a new
+*          sequence.
+*
+* @return None
+*
+*******************************************************************************
+*/
+void adBmsOwReset(void)
+{
+  memset(&ow, 0, sizeof(ow));
+  memset(&ow_stats, 0, sizeof(ow_stats));
+  ow.last_ms = getTickMs() - ow_cfg.period_ms;
+}
+
+/**
+*******************************************************************************
+* Function: adBmsOwStats
+* @brief Open wire detection counters.
+*
+* @return Pointer to the counters
+*
+*******************************************************************************
+*/
+const ow_stats_ *adBmsOwStats(void)
+{
+  return(&ow_stats);
+}
+
+/** @}*/
+/** @}*/
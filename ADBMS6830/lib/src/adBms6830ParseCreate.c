@@ -28,23 +28,24 @@ extern Serial pc;
  * Function: SetOverVoltageThreshold
  * @brief Set Over Voltage Threshold.
  *
- * @details This function Set Over Voltage Threshold.
+ * @details This function Set Over Voltage Threshold. Threshold lsb is 16
+ *          adc lsb (2.4 mV) with the 12 bit code centred on 1.5 V.
  *
  * Parameters:
  *
- * @param [in]  voltage      Over voltage
+ * @param [in]  voltage      Over voltage (micro volt)
  *
  * @return OverVoltage_value
  *
  *******************************************************************************
  */
-uint16_t SetOverVoltageThreshold(float voltage)
+uint16_t SetOverVoltageThreshold(int32_t voltage)
 {
   uint16_t vov_value;
   uint8_t rbits = 12;
-  voltage = (voltage - 1.5);
-  voltage = voltage / (16 * 0.000150);
-  vov_value = (uint16_t)(voltage + 2 * (1 << (rbits - 1)));
+  int32_t lsb = 16 * CODE_LSB_UV;
+  /* Offset to keep the dividend positive so the division floors */
+  vov_value = (uint16_t)((voltage - CODE_OFFSET_UV + (2 * (1 << (rbits - 1)) * lsb)) / lsb);
   vov_value &= 0xFFF;
   return vov_value;
 }
@@ -54,23 +55,24 @@ uint16_t SetOverVoltageThreshold(float voltage)
  * Function: SetUnderVoltageThreshold
  * @brief Set Under Voltage Threshold.
  *
- * @details This function Set Under Voltage Threshold.
+ * @details This function Set Under Voltage Threshold. Threshold lsb is 16
+ *          adc lsb (2.4 mV) with the 12 bit code centred on 1.5 V.
  *
  * Parameters:
  *
- * @param [in]  voltage      Under voltage
+ * @param [in]  voltage      Under voltage (micro volt)
  *
  * @return UnderVoltage_value
  *
  *******************************************************************************
  */
-uint16_t SetUnderVoltageThreshold(float voltage)
+uint16_t SetUnderVoltageThreshold(int32_t voltage)
 {
   uint16_t vuv_value;
   uint8_t rbits = 12;
-  voltage = (voltage - 1.5);
-  voltage = voltage / (16 * 0.000150);
-  vuv_value = (uint16_t)(voltage + 2 * (1 << (rbits - 1)));
+  int32_t lsb = 16 * CODE_LSB_UV;
+  /* Offset to keep the dividend positive so the division floors */
+  vuv_value = (uint16_t)((voltage - CODE_OFFSET_UV + (2 * (1 << (rbits - 1)) * lsb)) / lsb);
   vuv_value &= 0xFFF;
   return vuv_value;
 }
@@ -261,7 +263,7 @@ void SetPwmDutyCycle(uint8_t tIC, cell_asic *ic, PWM_DUTY duty_cycle)
  */
 void adBms6830ParseConfiga(uint8_t tIC, cell_asic *ic, uint8_t *data)
 {
-  uint8_t address = 0;
+  uint16_t address = 0;
   for (uint8_t curr_ic = 0; curr_ic < tIC; curr_ic++)
   {
     memcpy(&ic[curr_ic].configa.rx_data[0], &data[address], RX_DATA); /* dst , src , size */
@@ -306,7 +308,7 @@ void adBms6830ParseConfiga(uint8_t tIC, cell_asic *ic, uint8_t *data)
  */
 void adBms6830ParseConfigb(uint8_t tIC, cell_asic *ic, uint8_t *data)
 {
-  uint8_t address = 0;
+  uint16_t address = 0;
   for (uint8_t curr_ic = 0; curr_ic < tIC; curr_ic++)
   {
     memcpy(&ic[curr_ic].configb.rx_data[0], &data[address], RX_DATA); /* dst , src , size */
@@ -383,7 +385,7 @@ void adBms6830ParseConfig(uint8_t tIC, cell_asic *ic, GRP grp, uint8_t *data)
 /* Parse cell voltages */
 void adBms6830ParseCell(uint8_t tIC, cell_asic *ic, GRP grp, uint8_t *cv_data)
 {
-  uint8_t *data, data_size, address = 0;
+  uint8_t *data, data_size;
   if (grp == ALL_GRP)
   {
     data_size = RDCVALL_SIZE;
@@ -392,20 +394,9 @@ void adBms6830ParseCell(uint8_t tIC, cell_asic *ic, GRP grp, uint8_t *cv_data)
   {
     data_size = RX_DATA;
   }
-  data = (uint8_t *)calloc(data_size, sizeof(uint8_t));
-  if (data == NULL)
-  {
-#ifdef MBED
-    pc.printf(" Failed to allocate parse cell memory \n");
-#else
-    printf(" Failed to allocate parse cell memory \n");
-#endif
-    exit(0);
-  }
   for (uint8_t curr_ic = 0; curr_ic < tIC; curr_ic++)
   {
-    memcpy(&data[0], &cv_data[address], data_size); /* dst , src , size */
-    address = ((curr_ic + 1) * (data_size));
+    data = &cv_data[curr_ic * data_size]; /* Per ic payload, parsed in place */
     switch (grp)
     {
     case A: /* Cell Register group A */
@@ -465,7 +456,6 @@ void adBms6830ParseCell(uint8_t tIC, cell_asic *ic, GRP grp, uint8_t *cv_data)
       break;
     }
   }
-  free(data);
 }
 
 /**
@@ -491,7 +481,7 @@ void adBms6830ParseCell(uint8_t tIC, cell_asic *ic, GRP grp, uint8_t *cv_data)
  */
 void adBms6830ParseAverageCell(uint8_t tIC, cell_asic *ic, GRP grp, uint8_t *acv_data)
 {
-  uint8_t *data, data_size, address = 0;
+  uint8_t *data, data_size;
   if (grp == ALL_GRP)
   {
     data_size = RDACALL_SIZE;
@@ -500,20 +490,9 @@ void adBms6830ParseAverageCell(uint8_t tIC, cell_asic *ic, GRP grp, uint8_t *acv
   {
     data_size = RX_DATA;
   }
-  data = (uint8_t *)calloc(data_size, sizeof(uint8_t));
-  if (data == NULL)
-  {
-#ifdef MBED
-    pc.printf(" Failed to allocate parse avg cell memory \n");
-#else
-    printf(" Failed to allocate parse avg cell memory \n");
-#endif
-    exit(0);
-  }
   for (uint8_t curr_ic = 0; curr_ic < tIC; curr_ic++)
   {
-    memcpy(&data[0], &acv_data[address], data_size); /* dst , src , size */
-    address = ((curr_ic + 1) * (data_size));
+    data = &acv_data[curr_ic * data_size]; /* Per ic payload, parsed in place */
     switch (grp)
     {
     case A: /* Cell Register group A */
@@ -573,7 +552,6 @@ void adBms6830ParseAverageCell(uint8_t tIC, cell_asic *ic, GRP grp, uint8_t *acv
       break;
     }
   }
-  free(data);
 }
 
 /**
@@ -600,7 +578,7 @@ void adBms6830ParseAverageCell(uint8_t tIC, cell_asic *ic, GRP grp, uint8_t *acv
 /* Parse S cell voltages */
 void adBms6830ParseSCell(uint8_t tIC, cell_asic *ic, GRP grp, uint8_t *scv_data)
 {
-  uint8_t *data, data_size, address = 0;
+  uint8_t *data, data_size;
   if (grp == ALL_GRP)
   {
     data_size = RDSALL_SIZE;
@@ -609,20 +587,9 @@ void adBms6830ParseSCell(uint8_t tIC, cell_asic *ic, GRP grp, uint8_t *scv_data)
   {
     data_size = RX_DATA;
   }
-  data = (uint8_t *)calloc(data_size, sizeof(uint8_t));
-  if (data == NULL)
-  {
-#ifdef MBED
-    pc.printf(" Failed to allocate parse scv memory \n");
-#else
-    printf(" Failed to allocate parse scv memory \n");
-#endif
-    exit(0);
-  }
   for (uint8_t curr_ic = 0; curr_ic < tIC; curr_ic++)
   {
-    memcpy(&data[0], &scv_data[address], data_size); /* dst , src , size */
-    address = ((curr_ic + 1) * (data_size));
+    data = &scv_data[curr_ic * data_size]; /* Per ic payload, parsed in place */
     switch (grp)
     {
     case A: /* Cell Register group A */
@@ -682,7 +649,6 @@ void adBms6830ParseSCell(uint8_t tIC, cell_asic *ic, GRP grp, uint8_t *scv_data)
       break;
     }
   }
-  free(data);
 }
 
 /**
@@ -708,7 +674,7 @@ void adBms6830ParseSCell(uint8_t tIC, cell_asic *ic, GRP grp, uint8_t *scv_data)
  */
 void adBms6830ParseFCell(uint8_t tIC, cell_asic *ic, GRP grp, uint8_t *fcv_data)
 {
-  uint8_t *data, data_size, address = 0;
+  uint8_t *data, data_size;
   if (grp == ALL_GRP)
   {
     data_size = RDFCALL_SIZE;
@@ -717,20 +683,9 @@ void adBms6830ParseFCell(uint8_t tIC, cell_asic *ic, GRP grp, uint8_t *fcv_data)
   {
     data_size = RX_DATA;
   }
-  data = (uint8_t *)calloc(data_size, sizeof(uint8_t));
-  if (data == NULL)
-  {
-#ifdef MBED
-    pc.printf(" Failed to allocate parse fcell memory \n");
-#else
-    printf(" Failed to allocate parse fcell memory \n");
-#endif
-    exit(0);
-  }
   for (uint8_t curr_ic = 0; curr_ic < tIC; curr_ic++)
   {
-    memcpy(&data[0], &fcv_data[address], data_size); /* dst , src , size */
-    address = ((curr_ic + 1) * (data_size));
+    data = &fcv_data[curr_ic * data_size]; /* Per ic payload, parsed in place */
     switch (grp)
     {
     case A: /* Cell Register group A */
@@ -790,7 +745,6 @@ void adBms6830ParseFCell(uint8_t tIC, cell_asic *ic, GRP grp, uint8_t *fcv_data)
       break;
     }
   }
-  free(data);
 }
 
 /**
@@ -816,7 +770,7 @@ void adBms6830ParseFCell(uint8_t tIC, cell_asic *ic, GRP grp, uint8_t *fcv_data)
  */
 void adBms6830ParseAux(uint8_t tIC, cell_asic *ic, GRP grp, uint8_t *aux_data)
 {
-  uint8_t *data, data_size, address = 0;
+  uint8_t *data, data_size;
   if (grp == ALL_GRP)
   {
     data_size = (RDASALL_SIZE - 44);
@@ -825,20 +779,9 @@ void adBms6830ParseAux(uint8_t tIC, cell_asic *ic, GRP grp, uint8_t *aux_data)
   {
     data_size = RX_DATA;
   }
-  data = (uint8_t *)calloc(data_size, sizeof(uint8_t));
-  if (data == NULL)
-  {
-#ifdef MBED
-    pc.printf(" Failed to allocate parse aux memory \n");
-#else
-    printf(" Failed to allocate parse aux memory \n");
-#endif
-    exit(0);
-  }
   for (uint8_t curr_ic = 0; curr_ic < tIC; curr_ic++)
   {
-    memcpy(&data[0], &aux_data[address], data_size); /* dst , src , size */
-    address = ((curr_ic + 1) * (data_size));
+    data = &aux_data[curr_ic * data_size]; /* Per ic payload, parsed in place */
     switch (grp)
     {
     case A: /* Aux Register group A */
@@ -884,7 +827,6 @@ void adBms6830ParseAux(uint8_t tIC, cell_asic *ic, GRP grp, uint8_t *aux_data)
       break;
     }
   }
-  free(data);
 }
 
 /**
@@ -910,7 +852,7 @@ void adBms6830ParseAux(uint8_t tIC, cell_asic *ic, GRP grp, uint8_t *aux_data)
  */
 void adBms6830ParseRAux(uint8_t tIC, cell_asic *ic, GRP grp, uint8_t *raux_data)
 {
-  uint8_t *data, data_size, address = 0;
+  uint8_t *data, data_size;
   if (grp == ALL_GRP)
   {
     data_size = (RDASALL_SIZE - 48);
@@ -919,20 +861,9 @@ void adBms6830ParseRAux(uint8_t tIC, cell_asic *ic, GRP grp, uint8_t *raux_data)
   {
     data_size = RX_DATA;
   }
-  data = (uint8_t *)calloc(data_size, sizeof(uint8_t));
-  if (data == NULL)
-  {
-#ifdef MBED
-    pc.printf(" Failed to allocate parse raux memory \n");
-#else
-    printf(" Failed to allocate parse raux memory \n");
-#endif
-    exit(0);
-  }
   for (uint8_t curr_ic = 0; curr_ic < tIC; curr_ic++)
   {
-    memcpy(&data[0], &raux_data[address], data_size); /* dst , src , size */
-    address = ((curr_ic + 1) * (data_size));
+    data = &raux_data[curr_ic * data_size]; /* Per ic payload, parsed in place */
     switch (grp)
     {
     case A: /* RAux Register group A */
@@ -974,7 +905,6 @@ void adBms6830ParseRAux(uint8_t tIC, cell_asic *ic, GRP grp, uint8_t *raux_data)
       break;
     }
   }
-  free(data);
 }
 
 /**
@@ -998,7 +928,7 @@ void adBms6830ParseRAux(uint8_t tIC, cell_asic *ic, GRP grp, uint8_t *raux_data)
  */
 void adBms6830ParseStatusA(uint8_t tIC, cell_asic *ic, uint8_t *data)
 {
-  uint8_t address = 0;
+  uint16_t address = 0;
   for (uint8_t curr_ic = 0; curr_ic < tIC; curr_ic++)
   {
     memcpy(&ic[curr_ic].stat.rx_data[0], &data[address], RX_DATA); /* dst , src , size */
@@ -1030,7 +960,7 @@ void adBms6830ParseStatusA(uint8_t tIC, cell_asic *ic, uint8_t *data)
  */
 void adBms6830ParseStatusB(uint8_t tIC, cell_asic *ic, uint8_t *data)
 {
-  uint8_t address = 0;
+  uint16_t address = 0;
   for (uint8_t curr_ic = 0; curr_ic < tIC; curr_ic++)
   {
     memcpy(&ic[curr_ic].stat.rx_data[0], &data[address], RX_DATA); /* dst , src , size */
@@ -1062,7 +992,7 @@ void adBms6830ParseStatusB(uint8_t tIC, cell_asic *ic, uint8_t *data)
  */
 void adBms6830ParseStatusC(uint8_t tIC, cell_asic *ic, uint8_t *data)
 {
-  uint8_t address = 0;
+  uint16_t address = 0;
   for (uint8_t curr_ic = 0; curr_ic < tIC; curr_ic++)
   {
     memcpy(&ic[curr_ic].stat.rx_data[0], &data[address], RX_DATA); /* dst , src , size */
@@ -1108,7 +1038,7 @@ void adBms6830ParseStatusC(uint8_t tIC, cell_asic *ic, uint8_t *data)
  */
 void adBms6830ParseStatusD(uint8_t tIC, cell_asic *ic, uint8_t *data)
 {
-  uint8_t address = 0;
+  uint16_t address = 0;
   for (uint8_t curr_ic = 0; curr_ic < tIC; curr_ic++)
   {
     memcpy(&ic[curr_ic].stat.rx_data[0], &data[address], RX_DATA); /* dst , src , size */
@@ -1178,7 +1108,7 @@ void adBms6830ParseStatusD(uint8_t tIC, cell_asic *ic, uint8_t *data)
  */
 void adBms6830ParseStatusE(uint8_t tIC, cell_asic *ic, uint8_t *data)
 {
-  uint8_t address = 0;
+  uint16_t address = 0;
   for (uint8_t curr_ic = 0; curr_ic < tIC; curr_ic++)
   {
     memcpy(&ic[curr_ic].stat.rx_data[0], &data[address], RX_DATA); /* dst , src , size */
@@ -1277,7 +1207,7 @@ void adBms6830ParseStatus(uint8_t tIC, cell_asic *ic, GRP grp, uint8_t *data)
  */
 void adBms6830ParseComm(uint8_t tIC, cell_asic *ic, uint8_t *data)
 {
-  uint8_t address = 0;
+  uint16_t address = 0;
   for (uint8_t curr_ic = 0; curr_ic < tIC; curr_ic++)
   {
     memcpy(&ic[curr_ic].com.rx_data[0], &data[address], RX_DATA); /* dst , src , size */
@@ -1315,7 +1245,7 @@ void adBms6830ParseComm(uint8_t tIC, cell_asic *ic, uint8_t *data)
  */
 void adBms6830ParseSID(uint8_t tIC, cell_asic *ic, uint8_t *data)
 {
-  uint8_t address = 0;
+  uint16_t address = 0;
   for (uint8_t curr_ic = 0; curr_ic < tIC; curr_ic++)
   {
     memcpy(&ic[curr_ic].rsid.rx_data[0], &data[address], RX_DATA); /* dst , src , size */
@@ -1350,7 +1280,7 @@ void adBms6830ParseSID(uint8_t tIC, cell_asic *ic, uint8_t *data)
  */
 void adBms6830ParsePwma(uint8_t tIC, cell_asic *ic, uint8_t *data)
 {
-  uint8_t address = 0;
+  uint16_t address = 0;
   for (uint8_t curr_ic = 0; curr_ic < tIC; curr_ic++)
   {
     memcpy(&ic[curr_ic].pwma.rx_data[0], &data[address], RX_DATA); /* dst , src , size */
@@ -1391,7 +1321,7 @@ void adBms6830ParsePwma(uint8_t tIC, cell_asic *ic, uint8_t *data)
  */
 void adBms6830ParsePwmb(uint8_t tIC, cell_asic *ic, uint8_t *data)
 {
-  uint8_t address = 0;
+  uint16_t address = 0;
   for (uint8_t curr_ic = 0; curr_ic < tIC; curr_ic++)
   {
     memcpy(&ic[curr_ic].pwmb.rx_data[0], &data[address], RX_DATA); /* dst , src , size */
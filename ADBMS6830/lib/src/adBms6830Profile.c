@@ -0,0 +1,148 @@
+/*******************************************************************************
+* @file:    adBms6830Profile.c
+* @brief:   Cycle counter profiling
+*****************************************************************************/
+/*! \addtogroup BMS_DRIVER
+*  @{
+*/
+
+/*! @addtogroup PROFILE CYCLE PROFILING
+*  @{
+*/
+#include "common.h"
+#include "adbms_main.h"
+#include "adBms6830Profile.h"
+
+#if PROFILE_ENABLE
+
+static prof_scope_ prof_scope[PROF_NB];
+
+static const char *const prof_name[PROF_NB] =
+{
+  [PROF_UPDATE_VALUES] = "update_values",
+  [PROF_CALC_VALUES]   = "calc_values",
+  [PROF_CHECK_FAULTS]  = "check_faults",
+  [PROF_FSM_RUN]       = "fsm_run",
+  [PROF_SPI]           = "spi",
+  [PROF_PARSE]         = "parse",
+  [PROF_CAN_PACK]      = "can_pack",
+};
+
+/**
+*******************************************************************************
+* Function: adBmsProfBegin
+* @brief Open a scope.
+*
+* @details Only the start cycle count is stored. A scope is not nested in
+*          itself; a second begin before the end restarts it.
+*
+* Parameters:
+* @param [in]  scope    Scope
+*
+* @return None
+*
+*******************************************************************************
+*/
+void adBmsProfBegin(PROF_SCOPE scope)
+{
+  prof_scope[scope].start = getCycleCount();
+}
+
+/**
+*******************************************************************************
+* Function: adBmsProfEnd
+* @brief Close a scope and account its duration.
+*
+* @details The 32 bit cycle counter wraps after 25 s at 168 MHz, the unsigned
+*          difference is right for any shorter scope. May be called from
+*          interrupt context (the spi dma completion closes PROF_SPI).
+*
+* Parameters:
+* @param [in]  scope    Scope
+*
+* @return None
+*
+*******************************************************************************
+*/
+void adBmsProfEnd(PROF_SCOPE scope)
+{
+  prof_scope_ *p = &prof_scope[scope];
+  uint32_t cycles = getCycleCount() - p->start;
+  uint8_t bin = (cycles == 0) ? 0 : (uint8_t)(31 - __builtin_clz(cycles));
+  if((p->count == 0) || (cycles < p->min)){ p->min = cycles; }
+  if(cycles > p->max){ p->max = cycles; }
+  p->sum += cycles;
+  p->hist[bin]++;
+  p->count++;
+}
+
+/**
+*******************************************************************************
+* Function: adBmsProfScope
+* @brief Durations of a scope.
+*
+* Parameters:
+* @param [in]  scope    Scope
+*
+* @return Scope statistics
+*
+*******************************************************************************
+*/
+const prof_scope_ *adBmsProfScope(PROF_SCOPE scope)
+{
+  return &prof_scope[scope];
+}
+
+/**
+*******************************************************************************
+* Function: adBmsProfName
+* @brief Name of a scope for the dump.
+*
+* Parameters:
+* @param [in]  scope    Scope
+*
+* @return Name
+*
+*******************************************************************************
+*/
+const char *adBmsProfName(PROF_SCOPE scope)
+{
+  return prof_name[scope];
+}
+
+/**
+*******************************************************************************
+* Function: adBmsProfMean
+* @brief Mean duration of a scope.
+*
+* Parameters:
+* @param [in]  scope    Scope
+*
+* @return Mean cycles, 0 when the scope never completed
+*
+*******************************************************************************
+*/
+uint32_t adBmsProfMean(PROF_SCOPE scope)
+{
+  const prof_scope_ *p = &prof_scope[scope];
+  return (p->count == 0) ? 0 : (uint32_t)(p->sum / p->count);
+}
+
+/**
+*******************************************************************************
+* Function: adBmsProfReset
+* @brief Clear all scopes and start the cycle counter.
+*
+* @return None
+*
+*******************************************************************************
+*/
+void adBmsProfReset(void)
+{
+  cycleCounterInit();
+  memset(prof_scope, 0, sizeof(prof_scope));
+}
+
+#endif
+/** @}*/
+/** @}*/
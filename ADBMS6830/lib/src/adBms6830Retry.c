@@ -0,0 +1,198 @@
+/*******************************************************************************
+* @file:    adBms6830Retry.c
+* @brief:   Read retry policy
+*****************************************************************************/
+/*! \addtogroup BMS_DRIVER
+*  @{
+*/
+
+/*! @addtogroup READ_RETRY READ RETRY
+*  @{
+*/
+#include "common.h"
+#include "adbms_main.h"
+#include "adBms6830Retry.h"
+
+static retry_cfg_ retry_cfg = { RETRY_MAX_DEFAULT, RETRY_BUDGET_DEFAULT, RETRY_FAULT_DEFAULT };
+static uint8_t retry_budget = RETRY_BUDGET_DEFAULT;  /* Retries left this tick    */
+static uint8_t fail_run[MAX_IC][Cmd];                /* Consecutive failed reads  */
+static uint32_t retry_fault[MAX_IC];                 /* TYPE bits at fault        */
+static retry_stats_ retry_stats;
+
+/**
+*******************************************************************************
+* Function: adBmsRetryConfig
+* @brief Set the read retry policy.
+*
+* Parameters:
+* @param [in]  *cfg     Retry policy
+*
+* @return None
+*
+*******************************************************************************
+*/
+void adBmsRetryConfig(const retry_cfg_ *cfg)
+{
+  retry_cfg = *cfg;
+  if(retry_cfg.fault_after == 0){ retry_cfg.fault_after = 1; }
+  retry_budget = retry_cfg.tick_budget;
+}
+
+/**
+*******************************************************************************
+* Function: adBmsRetryTick
+* @brief Refill the retry budget.
+*
+* @details Call once per acquisition tick; retries beyond the budget are
+*          left for the next tick, which bounds the extra bus time a noisy
+*          chain can take.
+*
+* @return None
+*
+*******************************************************************************
+*/
+void adBmsRetryTick(void)
+{
+  retry_budget = retry_cfg.tick_budget;
+}
+
+/**
+*******************************************************************************
+* Function: adBmsReadRetry
+* @brief Read with retry of the failing ics.
+*
+* @details The register of the command is read once, then the failing ics
+*          are retried by adBmsRetryFailing.
+*
+* Parameters:
+* @param [in]	tIC      Total IC
+*
+* @param [in]  *ic      cell_asic stucture pointer
+*
+* @param [in]  *cmd     Read command descriptor
+*
+* @return Ic mask still failing after the retries, bit n = ic n
+*
+*******************************************************************************
+*/
+uint32_t adBmsReadRetry(uint8_t tIC, cell_asic *ic, const cmd_desc_ *cmd)
+{
+  if((cmd->type >= Cmd) || (tIC > MAX_IC)){ return 0; }
+  adBmsReadData(tIC, ic, cmd);
+  return(adBmsRetryFailing(tIC, ic, cmd));
+}
+
+/**
+*******************************************************************************
+* Function: adBmsRetryFailing
+* @brief Retry the failing ics of a read already parsed.
+*
+* @details Takes the pec flags left by the first read of the command, done
+*          blocking (adBmsReadRetry) or by dma (adBmsReadDataFinish). The
+*          ics with a pec error are read again, same register group only, up
+*          to max_retry times while the tick budget lasts; each retry parses
+*          only the ics still failing, the ones read good are not touched
+*          again. An ic that stays failing keeps its last good values (stale
+*          in the pack store). Its run of failed reads of the register counts
+*          towards fault_after, a good read ends the run and the fault.
+*
+* Parameters:
+* @param [in]	tIC      Total IC
+*
+* @param [in]  *ic      cell_asic stucture pointer
+*
+* @param [in]  *cmd     Read command descriptor
+*
+* @return Ic mask still failing after the retries, bit n = ic n
+*
+*******************************************************************************
+*/
+uint32_t adBmsRetryFailing(uint8_t tIC, cell_asic *ic, const cmd_desc_ *cmd)
+{
+  uint32_t fail, first;
+  uint8_t retry = 0;
+  if((cmd->type >= Cmd) || (tIC > MAX_IC)){ return 0; }
+  first = fail = adBmsReadPecMask(tIC, ic, cmd);
+  retry_stats.read_count++;
+  if(fail != 0){ retry_stats.fail_count++; }
+  while((fail != 0) && (retry < retry_cfg.max_retry))
+  {
+    if(retry_budget == 0)
+    {
+      retry_stats.budget_count++;
+      break;
+    }
+    retry_budget--;
+    retry++;
+    retry_stats.retry_count++;
+    adBmsReadDataMask(tIC, ic, cmd, fail);
+    fail &= adBmsReadPecMask(tIC, ic, cmd);
+  }
+  for(uint8_t cic = 0; cic < tIC; cic++)
+  {
+    if((fail & (1u << cic)) == 0)
+    {
+      if(first & (1u << cic)){ retry_stats.recovered_count++; }
+      fail_run[cic][cmd->type] = 0;
+      retry_fault[cic] &= ~(1u << cmd->type);
+      continue;
+    }
+    if(fail_run[cic][cmd->type] < 0xFF){ fail_run[cic][cmd->type]++; }
+    if(fail_run[cic][cmd->type] == retry_cfg.fault_after){ retry_stats.fault_count++; }
+    if(fail_run[cic][cmd->type] >= retry_cfg.fault_after){ retry_fault[cic] |= (1u << cmd->type); }
+  }
+  return fail;
+}
+
+/**
+*******************************************************************************
+* Function: adBmsRetryFaults
+* @brief Ics with a register at fault.
+*
+* @return Ic mask, bit n set = a register of ic n failed fault_after reads in a row
+*
+*******************************************************************************
+*/
+uint32_t adBmsRetryFaults(void)
+{
+  uint32_t mask = 0;
+  for(uint8_t cic = 0; cic < MAX_IC; cic++)
+  {
+    if(retry_fault[cic] != 0){ mask |= (1u << cic); }
+  }
+  return mask;
+}
+
+/**
+*******************************************************************************
+* Function: adBmsRetryReset
+* @brief Clear failure runs, faults and counters.
+*
+* @return None
+*
+*******************************************************************************
+*/
+void adBmsRetryReset(void)
+{
+  memset(&fail_run[0][0], 0, sizeof(fail_run));
+  memset(&retry_fault[0], 0, sizeof(retry_fault));
+  memset(&retry_stats, 0, sizeof(retry_stats));
+  retry_budget = retry_cfg.tick_budget;
+}
+
+/**
+*******************************************************************************
+* Function: adBmsRetryStats
+* @brief Read retry counters.
+*
+* @return Pointer to the counters
+*
+*******************************************************************************
+*/
+const retry_stats_ *adBmsRetryStats(void)
+{
+  return(&retry_stats);
+}
+
+/** @}*/
+/** @}*/
@@ -0,0 +1,514 @@
+/*******************************************************************************
+* @file:    adBms6830SelfTest.c
+* @brief:   Rotating self test scheduler
+*****************************************************************************/
+/*! \addtogroup BMS_DRIVER
+*  @{
+*/
+
+/*! @addtogroup SELF_TEST SELF TEST
+*  @{
+*/
+#include "common.h"
+#include "adbms_main.h"
+#include "adBms6830CmdList.h"
+#include "adBms6830SelfTest.h"
+
+/* Status C flags, same bit layout as bytes 4 and 5 of RDSTATC and CLRFLAG */
+#define ST_F_OTP2_MED  0x0001u
+#define ST_F_OTP2_ED   0x0002u
+#define ST_F_OTP1_MED  0x0004u
+#define ST_F_OTP1_ED   0x0008u
+#define ST_F_VD_UV     0x0010u
+#define ST_F_VD_OV     0x0020u
+#define ST_F_VA_UV     0x0040u
+#define ST_F_VA_OV     0x0080u
+#define ST_F_OSCCHK    0x0100u
+#define ST_F_TMODCHK   0x0200u
+#define ST_F_THSD      0x0400u
+#define ST_F_VDEL      0x4000u
+#define ST_F_VDE       0x8000u
+
+#define ST_CSFLT_ALL   0xFFFFu   /* Every CSxFLT bit, forced by the ERR read */
+
+/* Test steps, one spi transaction each */
+typedef enum
+{
+  ST_PHASE_IDLE = 0,  /* No test running                        */
+  ST_PHASE_SET,       /* WRCFGA with the FLAG_D bits set        */
+  ST_PHASE_READ,      /* Status C read, forced flags expected   */
+  ST_PHASE_RESTORE,   /* WRCFGA with the FLAG_D bits cleared    */
+  ST_PHASE_CLEAR,     /* CLRFLAG of the flags of the test       */
+  ST_PHASE_VERIFY     /* Status C read, flags expected cleared  */
+} ST_PHASE;
+
+/* One self test */
+typedef struct
+{
+  uint8_t flag_d;           /* FLAG_D bits forcing the fault, 0 = none   */
+  const cmd_desc_ *read;    /* Status C read of the forced flags         */
+  uint16_t expect;          /* ST_F_x flags the fault has to set         */
+  uint16_t clear;           /* ST_F_x flags cleared after the test       */
+} st_desc_;
+
+static const st_desc_ st_desc[ST_NB] =
+{
+  [ST_OSC]       = { (1u << FLAG_D0),                    &RDSTATC,    ST_F_OSCCHK,                  ST_F_OSCCHK },
+  [ST_THSD]      = { (1u << FLAG_D4),                    &RDSTATC,    ST_F_THSD,                    ST_F_THSD },
+  [ST_SUPPLY_UV] = { (1u << FLAG_D2),                    &RDSTATC,    ST_F_VA_UV | ST_F_VD_UV,      ST_F_VA_UV | ST_F_VD_UV },
+  [ST_SUPPLY_OV] = { (1u << FLAG_D2) | (1u << FLAG_D3),  &RDSTATC,    ST_F_VA_OV | ST_F_VD_OV,      ST_F_VA_OV | ST_F_VD_OV | ST_F_VDE | ST_F_VDEL },
+  [ST_FUSE_ED]   = { (1u << FLAG_D5),                    &RDSTATC,    ST_F_OTP1_ED | ST_F_OTP2_ED,  ST_F_OTP1_ED | ST_F_OTP2_ED },
+  [ST_FUSE_MED]  = { (1u << FLAG_D6),                    &RDSTATC,    ST_F_OTP1_MED | ST_F_OTP2_MED, ST_F_OTP1_MED | ST_F_OTP2_MED },
+  [ST_TMODCHK]   = { (1u << FLAG_D7),                    &RDSTATC,    ST_F_TMODCHK,                 ST_F_TMODCHK },
+  [ST_CSFLT]     = { 0,                                  &RDSTATCERR, 0,                            0 },
+};
+
+static st_cfg_ st_cfg =
+{
+  { ST_PERIOD_DEFAULT_MS, ST_PERIOD_DEFAULT_MS, ST_PERIOD_DEFAULT_MS, ST_PERIOD_DEFAULT_MS,
+    ST_PERIOD_DEFAULT_MS, ST_PERIOD_DEFAULT_MS, ST_PERIOD_DEFAULT_MS, ST_PERIOD_DEFAULT_MS },
+  ST_SETTLE_DEFAULT_MS
+};
+static st_result_ st_result[ST_NB];
+
+/* Running test */
+static struct
+{
+  ST_PHASE phase;
+  ST_TEST test;       /* Test running or last run                */
+  uint32_t start_ms;  /* Fault forced                            */
+  uint32_t fail;      /* Ics failing this run                    */
+  uint32_t skip;      /* Ics with a pec error this run           */
+} st;
+
+/**
+*******************************************************************************
+* Function: adBmsStFlags
+* @brief Status C flags of one ic as ST_F_x bits.
+*
+* Parameters:
+* @param [in]  *statc   Decoded status C
+*
+* @return ST_F_x bits set
+*
+*******************************************************************************
+*/
+static uint16_t adBmsStFlags(const stc_ *statc)
+{
+  uint16_t flags = 0;
+  if(statc->otp2_med){ flags |= ST_F_OTP2_MED; }
+  if(statc->otp2_ed){ flags |= ST_F_OTP2_ED; }
+  if(statc->otp1_med){ flags |= ST_F_OTP1_MED; }
+  if(statc->otp1_ed){ flags |= ST_F_OTP1_ED; }
+  if(statc->vd_uv){ flags |= ST_F_VD_UV; }
+  if(statc->vd_ov){ flags |= ST_F_VD_OV; }
+  if(statc->va_uv){ flags |= ST_F_VA_UV; }
+  if(statc->va_ov){ flags |= ST_F_VA_OV; }
+  if(statc->oscchk){ flags |= ST_F_OSCCHK; }
+  if(statc->tmodchk){ flags |= ST_F_TMODCHK; }
+  if(statc->thsd){ flags |= ST_F_THSD; }
+  if(statc->vdel){ flags |= ST_F_VDEL; }
+  if(statc->vde){ flags |= ST_F_VDE; }
+  return flags;
+}
+
+/**
+*******************************************************************************
+* Function: adBmsStResultSlot
+* @brief diag_result field of a self test.
+*
+* Parameters:
+* @param [in]  *ic      cell_asic of the ic
+*
+* @param [in]  test     Self test
+*
+* @return Pointer to the result, 1 = pass
+*
+*******************************************************************************
+*/
+static uint8_t *adBmsStResultSlot(cell_asic *ic, ST_TEST test)
+{
+  switch(test)
+  {
+  case ST_OSC:       return &ic->diag_result.osc_mismatch;
+  case ST_THSD:      return &ic->diag_result.thsd;
+  case ST_SUPPLY_UV: return &ic->diag_result.supply_error;
+  case ST_SUPPLY_OV: return &ic->diag_result.supply_ovuv;
+  case ST_FUSE_ED:   return &ic->diag_result.fuse_ed;
+  case ST_FUSE_MED:  return &ic->diag_result.fuse_med;
+  case ST_TMODCHK:   return &ic->diag_result.tmodchk;
+  default:           return &ic->diag_result.cs_flt;
+  }
+}
+
+/**
+*******************************************************************************
+* Function: adBmsStSetFlagD
+* @brief Set or clear the FLAG_D bits of the running test and write CFGA.
+*
+* @details Only the bits of the test are touched, the configuration shadow
+*          skips the write when nothing changed.
+*
+* Parameters:
+* @param [in]	tIC      Total IC
+*
+* @param [in]  *ic      cell_asic stucture pointer
+*
+* @param [in]  set      true to force the fault, false to release it
+*
+* @return None
+*
+*******************************************************************************
+*/
+static void adBmsStSetFlagD(uint8_t tIC, cell_asic *ic, bool set)
+{
+  uint8_t bits = st_desc[st.test].flag_d;
+  for(uint8_t cic = 0; cic < tIC; cic++)
+  {
+    ic[cic].tx_cfga.flag_d = set ? (uint8_t)(ic[cic].tx_cfga.flag_d | bits) : (uint8_t)(ic[cic].tx_cfga.flag_d & ~bits);
+  }
+  adBmsCfgWrite(tIC, &ic[0]);
+}
+
+/**
+*******************************************************************************
+* Function: adBmsStRead
+* @brief Read status C for the running test.
+*
+* @details Read with the pack store detached, like the open wire reads. Ics
+*          with a pec error are left out of this run.
+*
+* Parameters:
+* @param [in]	tIC      Total IC
+*
+* @param [in]  *ic      cell_asic stucture pointer
+*
+* @param [in]  *cmd     RDSTATC or RDSTATCERR
+*
+* @return Ic mask read without pec error
+*
+*******************************************************************************
+*/
+static uint32_t adBmsStRead(uint8_t tIC, cell_asic *ic, const cmd_desc_ *cmd)
+{
+  pack_store_ *pack = adBmsGetPackStore();
+  uint32_t pec;
+  adBmsSetPackStore(NULL);
+  adBmsReadData(tIC, ic, cmd);
+  adBmsSetPackStore(pack);
+  pec = adBmsReadPecMask(tIC, ic, cmd);
+  st.skip |= pec;
+  return ~pec;
+}
+
+/**
+*******************************************************************************
+* Function: adBmsStClear
+* @brief Clear the flags of the running test with CLRFLAG.
+*
+* Parameters:
+* @param [in]	tIC      Total IC
+*
+* @param [in]  *ic      cell_asic stucture pointer
+*
+* @return None
+*
+*******************************************************************************
+*/
+static void adBmsStClear(uint8_t tIC, cell_asic *ic)
+{
+  uint16_t clear = st_desc[st.test].clear;
+  for(uint8_t cic = 0; cic < tIC; cic++)
+  {
+    memset(&ic[cic].clflag, 0, sizeof(clrflag_));
+    ic[cic].clflag.cl_smed  = (clear & ST_F_OTP2_MED) ? 1 : 0;
+    ic[cic].clflag.cl_sed   = (clear & ST_F_OTP2_ED) ? 1 : 0;
+    ic[cic].clflag.cl_cmed  = (clear & ST_F_OTP1_MED) ? 1 : 0;
+    ic[cic].clflag.cl_ced   = (clear & ST_F_OTP1_ED) ? 1 : 0;
+    ic[cic].clflag.cl_vduv  = (clear & ST_F_VD_UV) ? 1 : 0;
+    ic[cic].clflag.cl_vdov  = (clear & ST_F_VD_OV) ? 1 : 0;
+    ic[cic].clflag.cl_vauv  = (clear & ST_F_VA_UV) ? 1 : 0;
+    ic[cic].clflag.cl_vaov  = (clear & ST_F_VA_OV) ? 1 : 0;
+    ic[cic].clflag.cl_oscchk = (clear & ST_F_OSCCHK) ? 1 : 0;
+    ic[cic].clflag.cl_tmode = (clear & ST_F_TMODCHK) ? 1 : 0;
+    ic[cic].clflag.cl_thsd  = (clear & ST_F_THSD) ? 1 : 0;
+    ic[cic].clflag.cl_vdel  = (clear & ST_F_VDEL) ? 1 : 0;
+    ic[cic].clflag.cl_vde   = (clear & ST_F_VDE) ? 1 : 0;
+  }
+  adBmsWriteData(tIC, &ic[0], &CLRFLAG);
+  for(uint8_t cic = 0; cic < tIC; cic++){ memset(&ic[cic].clflag, 0, sizeof(clrflag_)); }
+}
+
+/**
+*******************************************************************************
+* Function: adBmsStFinish
+* @brief Record the result of the running test.
+*
+* @details Ics with a pec error on any read of the run keep their previous
+*          result.
+*
+* Parameters:
+* @param [in]	tIC      Total IC
+*
+* @param [in]  *ic      cell_asic stucture pointer
+*
+* @return None
+*
+*******************************************************************************
+*/
+static void adBmsStFinish(uint8_t tIC, cell_asic *ic)
+{
+  st_result_ *result = &st_result[st.test];
+  uint32_t fail = st.fail & ~st.skip;
+  for(uint8_t cic = 0; cic < tIC; cic++)
+  {
+    if(st.skip & (1u << cic)){ continue; }
+    *adBmsStResultSlot(&ic[cic], st.test) = (fail & (1u << cic)) ? 0 : 1;
+  }
+  result->fail_mask = (result->fail_mask & st.skip) | fail;
+  result->last_ms = getTickMs();
+  result->run_count++;
+  if(result->fail_mask != 0){ result->fail_count++; }
+  st.phase = ST_PHASE_IDLE;
+}
+
+/**
+*******************************************************************************
+* Function: adBmsStNext
+* @brief Pick the next self test due, round robin after the last one.
+*
+* @return true if a test is due, st.test set
+*
+*******************************************************************************
+*/
+static bool adBmsStNext(void)
+{
+  uint32_t now = getTickMs();
+  ST_TEST test;
+  for(uint8_t n = 1; n <= ST_NB; n++)
+  {
+    test = (ST_TEST)((st.test + n) % ST_NB);
+    if(st_cfg.period_ms[test] == 0){ continue; }
+    if((st_result[test].run_count == 0) || ((now - st_result[test].last_ms) >= st_cfg.period_ms[test]))
+    {
+      st.test = test;
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+*******************************************************************************
+* Function: adBmsStConfig
+* @brief Set self test periods and settle time.
+*
+* Parameters:
+* @param [in]  *cfg     Settings
+*
+* @return None
+*
+*******************************************************************************
+*/
+void adBmsStConfig(const st_cfg_ *cfg)
+{
+  st_cfg = *cfg;
+}
+
+/**
+*******************************************************************************
+* Function: adBmsStStep
+* @brief Advance the self tests by one step.
+*
+* @details Call once per acquisition tick. One test runs at a time, in turn,
+*          each once per its period: set the FLAG_D bits (WRCFGA), wait
+*          settle_ms, read status C and check the forced flags, release the
+*          FLAG_D bits (WRCFGA), clear the flags (CLRFLAG), read status C
+*          again and check they cleared. The CSFLT test only reads status C
+*          with the ERR bit, every CSxFLT bit must read set. A call sends at
+*          most one command or one read and never waits, so the time taken
+*          from the caller is bounded by one status register transfer. The
+*          test does not use the adcs, acquisition goes on meanwhile.
+*
+* Parameters:
+* @param [in]	tIC      Total IC
+*
+* @param [in]  *ic      cell_asic stucture pointer
+*
+* @return true while a test is running
+*
+*******************************************************************************
+*/
+bool adBmsStStep(uint8_t tIC, cell_asic *ic)
+{
+  const st_desc_ *desc;
+  uint32_t good;
+  if(st.phase == ST_PHASE_IDLE)
+  {
+    if(!adBmsStNext()){ return false; }
+    st.fail = 0;
+    st.skip = 0;
+    st.phase = ST_PHASE_SET;
+  }
+  desc = &st_desc[st.test];
+  switch(st.phase)
+  {
+  case ST_PHASE_SET:
+    st.phase = ST_PHASE_READ;
+    st.start_ms = getTickMs();
+    if(desc->flag_d != 0)
+    {
+      adBmsStSetFlagD(tIC, ic, true);
+      break;
+    }
+    /* Nothing to force, read now */
+    /* fall through */
+  case ST_PHASE_READ:
+    if((desc->flag_d != 0) && ((getTickMs() - st.start_ms) < st_cfg.settle_ms)){ break; }
+    good = adBmsStRead(tIC, ic, desc->read);
+    for(uint8_t cic = 0; cic < tIC; cic++)
+    {
+      if((good & (1u << cic)) == 0){ continue; }
+      if(st.test == ST_CSFLT)
+      {
+        if(ic[cic].statc.cs_flt != ST_CSFLT_ALL){ st.fail |= (1u << cic); }
+      }
+      else if((adBmsStFlags(&ic[cic].statc) & desc->expect) != desc->expect)
+      {
+        st.fail |= (1u << cic);
+      }
+    }
+    if(desc->flag_d == 0)
+    {
+      adBmsStFinish(tIC, ic);
+      return false;
+    }
+    st.phase = ST_PHASE_RESTORE;
+    break;
+  case ST_PHASE_RESTORE:
+    adBmsStSetFlagD(tIC, ic, false);
+    st.phase = ST_PHASE_CLEAR;
+    break;
+  case ST_PHASE_CLEAR:
+    adBmsStClear(tIC, ic);
+    st.phase = ST_PHASE_VERIFY;
+    break;
+  default: /* ST_PHASE_VERIFY, a flag that stays set is latched */
+    good = adBmsStRead(tIC, ic, &RDSTATC);
+    for(uint8_t cic = 0; cic < tIC; cic++)
+    {
+      if((good & (1u << cic)) && (adBmsStFlags(&ic[cic].statc) & desc->clear)){ st.fail |= (1u << cic); }
+    }
+    adBmsStFinish(tIC, ic);
+    return false;
+  }
+  return true;
+}
+
+/**
+*******************************************************************************
+* Function: adBmsStRun
+* @brief Run one self test now, blocking.
+*
+* @details For the application menu. A test running in the background is
+*          dropped (its FLAG_D bits released) and the requested one runs
+*          through the same steps.
+*
+* Parameters:
+* @param [in]	tIC      Total IC
+*
+* @param [in]  *ic      cell_asic stucture pointer
+*
+* @param [in]  test     Self test
+*
+* @return Ic mask that failed, bit n = ic n
+*
+*******************************************************************************
+*/
+uint32_t adBmsStRun(uint8_t tIC, cell_asic *ic, ST_TEST test)
+{
+  if(test >= ST_NB){ return 0; }
+  if((st.phase == ST_PHASE_READ) || (st.phase == ST_PHASE_RESTORE)){ adBmsStSetFlagD(tIC, ic, false); }
+  st.test = test;
+  st.fail = 0;
+  st.skip = 0;
+  st.phase = ST_PHASE_SET;
+  while(adBmsStStep(tIC, ic))
+  {
+    if(st.phase == ST_PHASE_READ){ Delay_ms(1); }
+  }
+  return st_result[test].fail_mask;
+}
+
+/**
+*******************************************************************************
+* Function: adBmsStResult
+* @brief Result of one self test.
+*
+* Parameters:
+* @param [in]  test     Self test
+*
+* @return Pointer to the result
+*
+*******************************************************************************
+*/
+const st_result_ *adBmsStResult(ST_TEST test)
+{
+  return(&st_result[(test < ST_NB) ? test : ST_OSC]);
+}
+
+/**
+*******************************************************************************
+* Function: adBmsStAgeMs
+* @brief Time since a self test last completed.
+*
+* Parameters:
+* @param [in]  test     Self test
+*
+* @return Age (ms), ST_AGE_NEVER if the test never ran
+*
+*******************************************************************************
+*/
+uint32_t adBmsStAgeMs(ST_TEST test)
+{
+  if((test >= ST_NB) || (st_result[test].run_count == 0)){ return ST_AGE_NEVER; }
+  return(getTickMs() - st_result[test].last_ms);
+}
+
+/**
+*******************************************************************************
+* Function: adBmsStFailMask
+* @brief Ics that failed any self test.
+*
+* @return Ic mask, bit n set = ic n failed the last run of a test
+*
+*******************************************************************************
+*/
+uint32_t adBmsStFailMask(void)
+{
+  uint32_t mask = 0;
+  for(uint8_t test = 0; test < ST_NB; test++){ mask |= st_result[test].fail_mask; }
+  return mask;
+}
+
+/**
+*******************************************************************************
+* Function: adBmsStReset
+* @brief Restart the self tests.
+*
+* @details Clears results, every enabled test is due again. Settings are
+*          kept.
+*
+* @return None
+*
+*******************************************************************************
+*/
+void adBmsStReset(void)
+{
+  memset(&st, 0, sizeof(st));
+  memset(&st_result[0], 0, sizeof(st_result));
+  st.test = (ST_TEST)(ST_NB - 1); /* Round robin starts at ST_OSC */
+}
+
+/** @}*/
+/** @}*/
@@ -0,0 +1,258 @@
+/*******************************************************************************
+* @file:    adBms6830Stats.c
+* @brief:   Pack code statistics
+*****************************************************************************/
+/*! \addtogroup BMS_DRIVER
+*  @{
+*/
+
+/*! @addtogroup PACK_STATS PACK STATISTICS
+*  @{
+*/
+#include "common.h"
+#include "adbms_main.h"
+#include "adBms6830Stats.h"
+
+/* Two int16 codes per word, low halfword is the even index. On the Cortex-M4
+   the DSP extension does both lanes in one instruction; elsewhere the same
+   lane operations are done in C so the packed kernel can be compared against
+   the scalar one on the host. */
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+
+/* sum += lo + hi */
+#define PAIR_SUM(acc, x)   ((acc) = (int32_t)__SMLAD((x), 0x00010001u, (uint32_t)(acc)))
+
+/* Per lane: keep (v, iv) where x >= v, else take (x, ix). GE flags of the
+   SSUB16 drive both selects. */
+#define PAIR_MIN(v, iv, x, ix)  do { (void)__SSUB16((x), (v)); (v) = __SEL((v), (x)); (iv) = __SEL((iv), (ix)); } while(0)
+
+/* Per lane: keep (v, iv) where v >= x, else take (x, ix) */
+#define PAIR_MAX(v, iv, x, ix)  do { (void)__SSUB16((v), (x)); (v) = __SEL((v), (x)); (iv) = __SEL((iv), (ix)); } while(0)
+
+/* Both index lanes += 2 */
+#define PAIR_STEP(ix)      ((ix) = __UADD16((ix), 0x00020002u))
+
+#else
+
+static inline int16_t lane(uint32_t w, int n){ return (int16_t)(uint16_t)(w >> (16 * n)); }
+static inline uint32_t pack2(uint16_t lo, uint16_t hi){ return ((uint32_t)hi << 16) | lo; }
+
+static inline void pairSum(int32_t *acc, uint32_t x)
+{
+  *acc = (int32_t)((uint32_t)*acc + (uint32_t)((int32_t)lane(x, 0) + lane(x, 1)));
+}
+
+static inline void pairSel(uint32_t *v, uint32_t *iv, uint32_t x, uint32_t ix, bool keep_lo, bool keep_hi)
+{
+  *v  = pack2((uint16_t)(keep_lo ? *v  : x),  (uint16_t)((keep_hi ? *v  : x)  >> 16));
+  *iv = pack2((uint16_t)(keep_lo ? *iv : ix), (uint16_t)((keep_hi ? *iv : ix) >> 16));
+}
+
+#define PAIR_SUM(acc, x)        pairSum(&(acc), (x))
+#define PAIR_MIN(v, iv, x, ix)  pairSel(&(v), &(iv), (x), (ix), lane((x), 0) >= lane((v), 0), lane((x), 1) >= lane((v), 1))
+#define PAIR_MAX(v, iv, x, ix)  pairSel(&(v), &(iv), (x), (ix), lane((v), 0) >= lane((x), 0), lane((v), 1) >= lane((x), 1))
+#define PAIR_STEP(ix)           ((ix) = pack2((uint16_t)((ix) + 2), (uint16_t)(((ix) >> 16) + 2)))
+
+#endif
+
+/**
+*******************************************************************************
+* Function: adBmsCodeStats
+* @brief Sum, min, max and their first index over a run of codes.
+*
+* @details Packed kernel: two codes per iteration, the even and odd indexes
+*          each keep their own min/max and index, the two lanes are reduced
+*          at the end. Ties resolve to the lowest index, so the result is
+*          bit identical to adBmsCodeStatsScalar. The sum wraps modulo 2^32
+*          like the scalar version; it cannot overflow for count up to
+*          STATS_MAX_COUNT.
+*          Runs from SRAM (RAMFUNC), it is called for every ic on every
+*          acquisition tick.
+*
+* Parameters:
+* @param [in]  code     Codes, e.g. pack_store_ cell or aux array
+*
+* @param [in]  count    Number of codes, 0 to STATS_MAX_COUNT
+*
+* @param [out] stats    Statistics, all zero when count is 0
+*
+* @return None
+*
+*******************************************************************************
+*/
+RAMFUNC void adBmsCodeStats(const int16_t *code, uint16_t count, code_stats_ *stats)
+{
+  uint32_t x, vmin, vmax, imin, imax, idx;
+  int32_t sum = 0;
+  uint16_t i;
+  if(count < 2)
+  {
+    adBmsCodeStatsScalar(code, count, stats);
+    return;
+  }
+  memcpy(&x, &code[0], sizeof(x));
+  vmin = vmax = x;
+  imin = imax = idx = 0x00010000u;
+  for(i = 0; (uint16_t)(i + 1) < count; i += 2)
+  {
+    memcpy(&x, &code[i], sizeof(x));
+    PAIR_SUM(sum, x);
+    PAIR_MIN(vmin, imin, x, idx);
+    PAIR_MAX(vmax, imax, x, idx);
+    PAIR_STEP(idx);
+  }
+  /* Reduce lanes, equal values go to the lower index */
+  stats->min = (int16_t)vmin;
+  stats->argmin = (uint16_t)imin;
+  if(((int16_t)(vmin >> 16) < stats->min) ||
+     (((int16_t)(vmin >> 16) == stats->min) && ((uint16_t)(imin >> 16) < stats->argmin)))
+  {
+    stats->min = (int16_t)(vmin >> 16);
+    stats->argmin = (uint16_t)(imin >> 16);
+  }
+  stats->max = (int16_t)vmax;
+  stats->argmax = (uint16_t)imax;
+  if(((int16_t)(vmax >> 16) > stats->max) ||
+     (((int16_t)(vmax >> 16) == stats->max) && ((uint16_t)(imax >> 16) < stats->argmax)))
+  {
+    stats->max = (int16_t)(vmax >> 16);
+    stats->argmax = (uint16_t)(imax >> 16);
+  }
+  /* Odd tail, a later index only wins on a strict compare */
+  if(i < count)
+  {
+    sum = (int32_t)((uint32_t)sum + (uint32_t)(int32_t)code[i]);
+    if(code[i] < stats->min){ stats->min = code[i]; stats->argmin = i; }
+    if(code[i] > stats->max){ stats->max = code[i]; stats->argmax = i; }
+  }
+  stats->sum = sum;
+}
+
+/**
+*******************************************************************************
+* Function: adBmsCodeStatsScalar
+* @brief Reference version of adBmsCodeStats, one code per iteration.
+*
+* Parameters:
+* @param [in]  code     Codes
+*
+* @param [in]  count    Number of codes, 0 to STATS_MAX_COUNT
+*
+* @param [out] stats    Statistics, all zero when count is 0
+*
+* @return None
+*
+*******************************************************************************
+*/
+void adBmsCodeStatsScalar(const int16_t *code, uint16_t count, code_stats_ *stats)
+{
+  uint32_t sum = 0;
+  uint16_t i;
+  memset(stats, 0, sizeof(code_stats_));
+  if(count == 0){ return; }
+  stats->min = stats->max = code[0];
+  for(i = 0; i < count; i++)
+  {
+    sum += (uint32_t)(int32_t)code[i];
+    if(code[i] < stats->min){ stats->min = code[i]; stats->argmin = i; }
+    if(code[i] > stats->max){ stats->max = code[i]; stats->argmax = i; }
+  }
+  stats->sum = (int32_t)sum;
+}
+
+/**
+*******************************************************************************
+* Function: adBmsCodeStatsMerge
+* @brief Merge the statistics of a following run of codes.
+*
+* @details Used when the codes are not contiguous, e.g. the thermistor
+*          channels of each IC in the aux array. The part indexes are moved
+*          by offset; the part is taken to come after stats, so ties keep
+*          the existing index.
+*
+* Parameters:
+* @param [in,out] stats   Statistics so far
+*
+* @param [in]  part       Statistics of the next run
+*
+* @param [in]  offset     Index of the first code of the run
+*
+* @return None
+*
+*******************************************************************************
+*/
+void adBmsCodeStatsMerge(code_stats_ *stats, const code_stats_ *part, uint16_t offset)
+{
+  stats->sum = (int32_t)((uint32_t)stats->sum + (uint32_t)part->sum);
+  if(part->min < stats->min){ stats->min = part->min; stats->argmin = (uint16_t)(part->argmin + offset); }
+  if(part->max > stats->max){ stats->max = part->max; stats->argmax = (uint16_t)(part->argmax + offset); }
+}
+
+/**
+*******************************************************************************
+* Function: adBmsPackStatsUpdate
+* @brief Bring pack statistics up to date with the ics read since last call.
+*
+* @details The parsers set the register type bit in pack->dirty for every ic
+*          they write. Only those ics get their summary recomputed (one
+*          adBmsCodeStats over src->count codes), then the pack summary is
+*          reduced from the tIC ic summaries. A change of pack->tIC rebuilds
+*          every ic. Nothing is done when no ic is dirty, so the cost per
+*          call follows the data actually read. The dirty bit is cleared, one
+*          consumer per register type.
+*
+* Parameters:
+* @param [in,out] stats   Statistics of the code array
+*
+* @param [in,out] pack    Pack store the codes live in
+*
+* @param [in]  code       Code array of the pack store, e.g. pack->cell
+*
+* @param [in]  src        Layout of the codes in the array
+*
+* @return Number of ic summaries recomputed
+*
+*******************************************************************************
+*/
+uint8_t adBmsPackStatsUpdate(pack_stats_ *stats, pack_store_ *pack, const int16_t *code, const pack_stats_src_ *src)
+{
+  uint8_t cic, updated = 0;
+  bool rebuild = (stats->tIC != pack->tIC);
+  stats->tIC = pack->tIC;
+  for(cic = 0; cic < stats->tIC; cic++)
+  {
+    if(rebuild || (pack->dirty[cic] & src->bit))
+    {
+      adBmsCodeStats(&code[(cic * src->stride) + src->first], src->count, &stats->ic[cic]);
+      pack->dirty[cic] &= (uint8_t)~src->bit;
+      updated++;
+    }
+  }
+  if(updated == 0){ return 0; }
+  stats->pack = stats->ic[0];
+  for(cic = 1; cic < stats->tIC; cic++)
+  {
+    adBmsCodeStatsMerge(&stats->pack, &stats->ic[cic], (uint16_t)(cic * src->count));
+  }
+  return updated;
+}
+
+/**
+*******************************************************************************
+* Function: adBmsPackStatsReset
+* @brief Drop pack statistics, the next update rebuilds every ic.
+*
+* Parameters:
+* @param [out] stats    Statistics of the code array
+*
+* @return None
+*
+*******************************************************************************
+*/
+void adBmsPackStatsReset(pack_stats_ *stats)
+{
+  memset(stats, 0, sizeof(pack_stats_));
+}
+
+/** @}*/
+/** @}*/
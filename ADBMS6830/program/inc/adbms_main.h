@@ -26,6 +26,15 @@ and its licensor.
 #include "adBms6830Data.h"
 #include "adBms6830GenericType.h"
 #include "adBms6830ParseCreate.h"
+#include "adBms6830AdcSched.h"
+#include "adBms6830Stats.h"
+#include "adBms6830CfgShadow.h"
+#include "adBms6830CmdCntr.h"
+#include "adBms6830Retry.h"
+#include "adBms6830OwSched.h"
+#include "adBms6830SelfTest.h"
+#include "adBms6830CsCheck.h"
+#include "adBms6830Profile.h"
 #include "mcuWrapper.h"
 
 
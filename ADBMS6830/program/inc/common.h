@@ -26,4 +26,26 @@ and its licensor.
 #include "Timer.h"
 #endif
 
+/* Memory placement (STM32F405RGTX_FLASH.ld). CCM ram sits on the core D-bus
+   only: no wait states and no contention with the usb fifo or dma traffic on
+   SRAM, but the dma controller cannot reach it, so dma buffers must not be
+   placed there.
+   CCMRAM       zero initialised data, .ccmbss, zeroed by the startup
+   CCMRAM_DATA  initialised data, .ccmram, copied from flash by the startup
+   CCMRAM_CONST read only tables, copied to .ccmram like CCMRAM_DATA
+   RAMFUNC      code run from SRAM, copied with .data; noinline so a caller
+                in flash cannot pull the body back out of ram
+   Host and mbed builds have none of these sections, the macros are empty. */
+#if defined(__GNUC__) && defined(__ARM_ARCH) && !defined(MBED)
+#define CCMRAM          __attribute__((section(".ccmbss")))
+#define CCMRAM_DATA     __attribute__((section(".ccmram")))
+#define CCMRAM_CONST    __attribute__((section(".ccmram.const")))
+#define RAMFUNC         __attribute__((section(".RamFunc"), noinline))
+#else
+#define CCMRAM
+#define CCMRAM_DATA
+#define CCMRAM_CONST
+#define RAMFUNC
+#endif
+
 #endif
\ No newline at end of file
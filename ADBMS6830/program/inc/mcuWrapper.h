@@ -22,8 +22,26 @@ and its licensor.
 #define __ADBMSWRAPPER_H
 #include "common.h"
 
+/* Split read back into spi segments of at most this many bytes, chip select
+   held low across segments (0 = one segment per read) */
+#ifndef SPI_RX_CHUNK_SIZE
+#define SPI_RX_CHUNK_SIZE 0
+#endif
+
 #ifdef MBED
 
+#elif defined(SPI_MOCK)
+/* Host build: spi traffic is answered by a test responder, no hardware */
+typedef void (*spi_mock_responder_)
+(
+  const uint8_t *tx_data,                       /*Bytes clocked out on mosi*/
+  uint16_t tx_size,                             /*Number of bytes clocked out*/
+  uint8_t *rx_data,                             /*Bytes clocked in on miso (NULL for write only)*/
+  uint16_t rx_size                              /*Number of bytes clocked in*/
+);
+void spiMockSetResponder(spi_mock_responder_ responder);
+void spiMockCompleteDma(bool error);
+void spiMockSetTick(uint32_t tick_ms);
 #else
 #include "main.h"
 #include "stm32f4xx_hal.h"
@@ -45,6 +63,8 @@ extern TIM_HandleTypeDef htim2;         /* Mcu dependent TIM handler */
 #endif
 
 void Delay_ms(uint32_t delay);
+void Delay_us(uint32_t delay);
+uint32_t getTickMs(void);
 void adBmsCsLow(void);
 void adBmsCsHigh(void);
 void spiWriteBytes
@@ -59,10 +79,27 @@ void spiWriteReadBytes
   uint16_t size                             /*Option: number of bytes*/
 );
 void spiReadBytes(uint16_t size, uint8_t *rx_data);
+
+/* Dma transfer done callback, called from interrupt context */
+typedef void (*spi_done_cb_)(void);
+bool spiWriteReadBytesDma
+(
+  uint8_t *tx_cmd,                              /*4 byte command + pec*/
+  uint16_t size,                                /*Option: number of bytes to read back*/
+  spi_done_cb_ done_cb                          /*Optional completion callback*/
+);
+bool spiDmaBusy(void);
+bool spiDmaError(void);
+uint8_t *spiDmaRxData(void);
 void startTimer(void);
 void stopTimer(void);
 uint32_t getTimCount(void);
+uint32_t getTimUs(void);
+void cycleCounterInit(void);
+uint32_t getCycleCount(void);
 void adBmsWakeupIc(uint8_t total_ic);
+void adBmsWakeMarkSleep(void);
+uint32_t adBmsWakeCount(void);
 
 #endif
 /** @}*/
@@ -38,7 +38,7 @@ void diagnosticTestResultPrint(uint8_t result);
 void printOpenWireTestResult(uint8_t tIC, cell_asic *IC, TYPE type);
 void openWireResultPrint(uint8_t result);
 float getVoltage(int data);
-void printPollAdcConvTime(int count);
+void printPollAdcConvTime(ADC_CONV conv);
 void printMenu();
 
 #endif 
@@ -23,6 +23,7 @@ and its licensor.
 #include "serialPrintResult.h"
 #include "mcuWrapper.h"
 #include "adbms_main.h"
+#include "adbms_mainboard.h"
 #ifdef MBED
 extern Serial pc;
 #endif
@@ -48,14 +49,13 @@ RSTF    RESET_FILTER                    = RSTF_OFF;
 ERR     INJECT_ERR_SPI_READ             = WITHOUT_ERR;
 
 /* Set Under Voltage and Over Voltage Thresholds */
-const float OV_THRESHOLD = 4.2;                 /* Volt */
-const float UV_THRESHOLD = 3.0;                 /* Volt */
+const int32_t OV_THRESHOLD = 4200000;           /* Micro volt */
+const int32_t UV_THRESHOLD = 3000000;           /* Micro volt */
 const int OWC_Threshold = 2000;                 /* Cell Open wire threshold(mili volt) */
-const int OWA_Threshold = 50000;                /* Aux Open wire threshold(mili volt) */
+const int OWA_Threshold = 50000;                /* Aux Open wire threshold(micro volt) */
 const uint32_t LOOP_MEASUREMENT_COUNT = 1;      /* Loop measurment count */
 const uint16_t MEASUREMENT_LOOP_TIME  = 10;     /* milliseconds(mS)*/
 uint32_t loop_count = 0;
-uint32_t pladc_count;
 
 /*Loop Measurement Setup These Variables are ENABLED or DISABLED Remember ALL CAPS*/
 LOOP_MEASURMENT MEASURE_CELL            = ENABLED;        /*   This is ENABLED or DISABLED       */
@@ -66,19 +66,39 @@ LOOP_MEASURMENT MEASURE_AUX             = DISABLED;        /*   This is ENABLED
 LOOP_MEASURMENT MEASURE_RAUX            = DISABLED;        /*   This is ENABLED or DISABLED       */
 LOOP_MEASURMENT MEASURE_STAT            = DISABLED;        /*   This is ENABLED or DISABLED       */
 
+/*Loop Measurement Read Mode These Variables are READ_GROUP or READ_ALL Remember ALL CAPS*/
+/* Cell + S-Voltage both READ_ALL share one RDCSALL, Aux, RAux and Status in READ_ALL share one RDASALL */
+LOOP_READ_MODE READ_CELL                = READ_ALL;       /*   This is READ_GROUP or READ_ALL    */
+LOOP_READ_MODE READ_AVG_CELL            = READ_ALL;       /*   This is READ_GROUP or READ_ALL    */
+LOOP_READ_MODE READ_F_CELL              = READ_ALL;       /*   This is READ_GROUP or READ_ALL    */
+LOOP_READ_MODE READ_S_VOLTAGE           = READ_ALL;       /*   This is READ_GROUP or READ_ALL    */
+LOOP_READ_MODE READ_AUX                 = READ_ALL;       /*   This is READ_GROUP or READ_ALL    */
+LOOP_READ_MODE READ_RAUX                = READ_ALL;       /*   This is READ_GROUP or READ_ALL    */
+LOOP_READ_MODE READ_STAT                = READ_ALL;       /*   This is READ_GROUP or READ_ALL    */
+
+/* Register group reads used in READ_GROUP mode */
+static const cmd_desc_ *const RD_CELL_GRP[]   = { &RDCVA, &RDCVB, &RDCVC, &RDCVD, &RDCVE, &RDCVF };
+static const cmd_desc_ *const RD_AVG_GRP[]    = { &RDACA, &RDACB, &RDACC, &RDACD, &RDACE, &RDACF };
+static const cmd_desc_ *const RD_FCELL_GRP[]  = { &RDFCA, &RDFCB, &RDFCC, &RDFCD, &RDFCE, &RDFCF };
+static const cmd_desc_ *const RD_SVOLT_GRP[]  = { &RDSVA, &RDSVB, &RDSVC, &RDSVD, &RDSVE, &RDSVF };
+static const cmd_desc_ *const RD_AUX_GRP[]    = { &RDAUXA, &RDAUXB, &RDAUXC, &RDAUXD };
+static const cmd_desc_ *const RD_RAUX_GRP[]   = { &RDRAXA, &RDRAXB, &RDRAXC, &RDRAXD };
+static const cmd_desc_ *const RD_STAT_GRP[]   = { &RDSTATA, &RDSTATB, &RDSTATC, &RDSTATD, &RDSTATE };
+
 void adbms_main()
 {
   //printMenu();
   adBms6830_init_config(TOTAL_IC, &IC[0]);
 
   // SETUP 
-  adbms_main_setup();
+  adbms_mainboard_setup();
 
 
   while(1)
   {
     // LOOP
-    // tick timer group with adbms_main_loop is the 
+    // TIM3 releases the rate groups, run them here
+    adbms_mainboard_loop();
 
     /*
     int user_command;
@@ -164,15 +184,14 @@ void run_command(int cmd)
   case 16:
     loop_count = 0;
     adBmsWakeupIc(TOTAL_IC);
-    adBmsWriteData(TOTAL_IC, &IC[0], WRCFGA, Config, A);
-    adBmsWriteData(TOTAL_IC, &IC[0], WRCFGB, Config, B);
+    adBmsCfgWrite(TOTAL_IC, &IC[0]);
     adBmsWakeupIc(TOTAL_IC);
     adBms6830_Adcv(REDUNDANT_MEASUREMENT, CONTINUOUS, DISCHARGE_PERMITTED, RESET_FILTER, CELL_OPEN_WIRE_DETECTION);
-    Delay_ms(1); // ADCs are updated at their conversion rate is 1ms
+    adBmsAdcWait(ADC_CONV_C); // ADCs are updated at their conversion rate is 1ms
     adBms6830_Adcv(RD_ON, CONTINUOUS, DISCHARGE_PERMITTED, RESET_FILTER, CELL_OPEN_WIRE_DETECTION);
-    Delay_ms(1); // ADCs are updated at their conversion rate is 1ms
+    adBmsAdcWait(ADC_CONV_C); // ADCs are updated at their conversion rate is 1ms
     adBms6830_Adsv(CONTINUOUS, DISCHARGE_PERMITTED, CELL_OPEN_WIRE_DETECTION);
-    Delay_ms(8); // ADCs are updated at their conversion rate is 8ms
+    adBmsAdcWait(ADC_CONV_S); // ADCs are updated at their conversion rate is 8ms
     while(loop_count < LOOP_MEASUREMENT_COUNT)
     {
       measurement_loop();
@@ -198,6 +217,50 @@ void run_command(int cmd)
     adBms6830_clear_fcell_measurement(TOTAL_IC);
     break;
 
+  case 21:
+    adBms6830_cell_openwire_test(TOTAL_IC, &IC[0]);
+    break;
+
+  case 22:
+    adBms6830_redundant_cell_openwire_test(TOTAL_IC, &IC[0]);
+    break;
+
+  case 23:
+    adBms6830_aux_openwire_test(TOTAL_IC, &IC[0]);
+    break;
+
+  case 24:
+    adBms6830_run_osc_mismatch_self_test(TOTAL_IC, &IC[0]);
+    break;
+
+  case 25:
+    adBms6830_run_thermal_shutdown_self_test(TOTAL_IC, &IC[0]);
+    break;
+
+  case 26:
+    adBms6830_run_supply_error_detection_self_test(TOTAL_IC, &IC[0]);
+    break;
+
+  case 27:
+    adBms6830_run_fuse_ed_self_test(TOTAL_IC, &IC[0]);
+    break;
+
+  case 28:
+    adBms6830_run_fuse_med_self_test(TOTAL_IC, &IC[0]);
+    break;
+
+  case 29:
+    adBms6830_run_tmodchk_self_test(TOTAL_IC, &IC[0]);
+    break;
+
+  case 30:
+    adBms6830_check_latent_fault_csflt_status_bits(TOTAL_IC, &IC[0]);
+    break;
+
+  case 31:
+    adBms6830_check_rdstatc_err_bit_functionality(TOTAL_IC, &IC[0]);
+    break;
+
   case 0:
     printMenu();
     break;
@@ -239,23 +302,37 @@ void adBms6830_init_config(uint8_t tIC, cell_asic *ic)
 //    SetConfigB_DischargeTimeOutValue(tIC, &ic[cic], RANG_0_TO_63_MIN, TIME_1MIN_OR_0_26HR);
   }
   adBmsWakeupIc(tIC);
-  adBmsWriteData(tIC, &ic[0], WRCFGA, Config, A);
-  adBmsWriteData(tIC, &ic[0], WRCFGB, Config, B);
+  adBmsCfgInvalidate(); /* Ic state unknown, write both registers */
+  adBmsCfgWrite(tIC, &ic[0]);
 }
 
 /**
 *******************************************************************************
-* @brief Write and Read Configuration Register A/B
+* @brief Write Configuration Register A/B, verify with the command counter.
+*        The counters come back with any one register group read, the full
+*        configuration is only read back when a counter is off.
 *******************************************************************************
 */
 void adBms6830_write_read_config(uint8_t tIC, cell_asic *ic)
 {
   adBmsWakeupIc(tIC);
-  adBmsWriteData(tIC, &ic[0], WRCFGA, Config, A);
-  adBmsWriteData(tIC, &ic[0], WRCFGB, Config, B);
-  adBmsReadData(tIC, &ic[0], RDCFGA, Config, A);
-  adBmsReadData(tIC, &ic[0], RDCFGB, Config, B);
+  adBmsCcClearMismatch();
+  adBmsWriteData(tIC, &ic[0], &WRCFGA);
+  adBmsWriteData(tIC, &ic[0], &WRCFGB);
+  adBmsReadData(tIC, &ic[0], &RDSTATA);
   printWriteConfig(tIC, &ic[0], Config, ALL_GRP);
+  if(adBmsCcMismatch() == 0)
+  {
+#ifdef MBED
+    pc.printf("Config write verified by command counter\n");
+#else
+    printf("Config write verified by command counter\n");
+#endif
+    return;
+  }
+  adBmsCcClearMismatch();
+  adBmsReadData(tIC, &ic[0], &RDCFGA);
+  adBmsReadData(tIC, &ic[0], &RDCFGB);
   printReadConfig(tIC, &ic[0], Config, ALL_GRP);
 }
 
@@ -267,8 +344,8 @@ void adBms6830_write_read_config(uint8_t tIC, cell_asic *ic)
 void adBms6830_read_config(uint8_t tIC, cell_asic *ic)
 {
   adBmsWakeupIc(tIC);
-  adBmsReadData(tIC, &ic[0], RDCFGA, Config, A);
-  adBmsReadData(tIC, &ic[0], RDCFGB, Config, B);
+  adBmsReadData(tIC, &ic[0], &RDCFGA);
+  adBmsReadData(tIC, &ic[0], &RDCFGB);
   printReadConfig(tIC, &ic[0], Config, ALL_GRP);
 }
 
@@ -281,13 +358,13 @@ void adBms6830_start_adc_cell_voltage_measurment(uint8_t tIC)
 {
   adBmsWakeupIc(tIC);
   adBms6830_Adcv(REDUNDANT_MEASUREMENT, CONTINUOUS_MEASUREMENT, DISCHARGE_PERMITTED, RESET_FILTER, CELL_OPEN_WIRE_DETECTION);
-  pladc_count = adBmsPollAdc(PLADC);
+  adBmsAdcWait(ADC_CONV_C);
 #ifdef MBED
   pc.printf("Cell conversion completed\n");
 #else
   printf("Cell conversion completed\n");
 #endif
-  printPollAdcConvTime(pladc_count);
+  printPollAdcConvTime(ADC_CONV_C);
 }
 
 /**
@@ -298,12 +375,12 @@ void adBms6830_start_adc_cell_voltage_measurment(uint8_t tIC)
 void adBms6830_read_cell_voltages(uint8_t tIC, cell_asic *ic)
 {
   adBmsWakeupIc(tIC);
-  adBmsReadData(tIC, &ic[0], RDCVA, Cell, A);
-  adBmsReadData(tIC, &ic[0], RDCVB, Cell, B);
-  adBmsReadData(tIC, &ic[0], RDCVC, Cell, C);
-  adBmsReadData(tIC, &ic[0], RDCVD, Cell, D);
-  adBmsReadData(tIC, &ic[0], RDCVE, Cell, E);
-  adBmsReadData(tIC, &ic[0], RDCVF, Cell, F);
+  adBmsReadData(tIC, &ic[0], &RDCVA);
+  adBmsReadData(tIC, &ic[0], &RDCVB);
+  adBmsReadData(tIC, &ic[0], &RDCVC);
+  adBmsReadData(tIC, &ic[0], &RDCVD);
+  adBmsReadData(tIC, &ic[0], &RDCVE);
+  adBmsReadData(tIC, &ic[0], &RDCVF);
   printVoltages(tIC, &ic[0], Cell);
 }
 
@@ -316,13 +393,13 @@ void adBms6830_start_adc_s_voltage_measurment(uint8_t tIC)
 {
   adBmsWakeupIc(tIC);
   adBms6830_Adsv(CONTINUOUS_MEASUREMENT, DISCHARGE_PERMITTED, CELL_OPEN_WIRE_DETECTION);
-  pladc_count = adBmsPollAdc(PLADC);
+  adBmsAdcWait(ADC_CONV_S);
 #ifdef MBED
   pc.printf("S-Voltage conversion completed\n");
 #else
   printf("S-Voltage conversion completed\n");
 #endif
-  printPollAdcConvTime(pladc_count);
+  printPollAdcConvTime(ADC_CONV_S);
 }
 
 /**
@@ -333,12 +410,12 @@ void adBms6830_start_adc_s_voltage_measurment(uint8_t tIC)
 void adBms6830_read_s_voltages(uint8_t tIC, cell_asic *ic)
 {
   adBmsWakeupIc(tIC);
-  adBmsReadData(tIC, &ic[0], RDSVA, S_volt, A);
-  adBmsReadData(tIC, &ic[0], RDSVB, S_volt, B);
-  adBmsReadData(tIC, &ic[0], RDSVC, S_volt, C);
-  adBmsReadData(tIC, &ic[0], RDSVD, S_volt, D);
-  adBmsReadData(tIC, &ic[0], RDSVE, S_volt, E);
-  adBmsReadData(tIC, &ic[0], RDSVF, S_volt, F);
+  adBmsReadData(tIC, &ic[0], &RDSVA);
+  adBmsReadData(tIC, &ic[0], &RDSVB);
+  adBmsReadData(tIC, &ic[0], &RDSVC);
+  adBmsReadData(tIC, &ic[0], &RDSVD);
+  adBmsReadData(tIC, &ic[0], &RDSVE);
+  adBmsReadData(tIC, &ic[0], &RDSVF);
   printVoltages(tIC, &ic[0], S_volt);
 }
 
@@ -351,13 +428,13 @@ void adBms6830_start_avgcell_voltage_measurment(uint8_t tIC)
 {
   adBmsWakeupIc(tIC);
   adBms6830_Adcv(RD_ON, CONTINUOUS_MEASUREMENT, DISCHARGE_PERMITTED, RESET_FILTER, CELL_OPEN_WIRE_DETECTION);
-  pladc_count = adBmsPollAdc(PLADC);
+  adBmsAdcWait(ADC_CONV_C);
 #ifdef MBED
   pc.printf("Avg Cell voltage conversion completed\n");
 #else
   printf("Avg Cell voltage conversion completed\n");
 #endif
-  printPollAdcConvTime(pladc_count);
+  printPollAdcConvTime(ADC_CONV_C);
 }
 
 /**
@@ -368,12 +445,12 @@ void adBms6830_start_avgcell_voltage_measurment(uint8_t tIC)
 void adBms6830_read_avgcell_voltages(uint8_t tIC, cell_asic *ic)
 {
   adBmsWakeupIc(tIC);
-  adBmsReadData(tIC, &ic[0], RDACA, AvgCell, A);
-  adBmsReadData(tIC, &ic[0], RDACB, AvgCell, B);
-  adBmsReadData(tIC, &ic[0], RDACC, AvgCell, C);
-  adBmsReadData(tIC, &ic[0], RDACD, AvgCell, D);
-  adBmsReadData(tIC, &ic[0], RDACE, AvgCell, E);
-  adBmsReadData(tIC, &ic[0], RDACF, AvgCell, F);
+  adBmsReadData(tIC, &ic[0], &RDACA);
+  adBmsReadData(tIC, &ic[0], &RDACB);
+  adBmsReadData(tIC, &ic[0], &RDACC);
+  adBmsReadData(tIC, &ic[0], &RDACD);
+  adBmsReadData(tIC, &ic[0], &RDACE);
+  adBmsReadData(tIC, &ic[0], &RDACF);
   printVoltages(tIC, &ic[0], AvgCell);
 }
 
@@ -386,13 +463,13 @@ void adBms6830_start_fcell_voltage_measurment(uint8_t tIC)
 {
   adBmsWakeupIc(tIC);
   adBms6830_Adcv(REDUNDANT_MEASUREMENT, CONTINUOUS_MEASUREMENT, DISCHARGE_PERMITTED, RESET_FILTER, CELL_OPEN_WIRE_DETECTION);
-  pladc_count = adBmsPollAdc(PLADC);
+  adBmsAdcWait(ADC_CONV_C);
 #ifdef MBED
   pc.printf("F Cell voltage conversion completed\n");
 #else
   printf("F Cell voltage conversion completed\n");
 #endif
-  printPollAdcConvTime(pladc_count);
+  printPollAdcConvTime(ADC_CONV_C);
 }
 
 /**
@@ -403,12 +480,12 @@ void adBms6830_start_fcell_voltage_measurment(uint8_t tIC)
 void adBms6830_read_fcell_voltages(uint8_t tIC, cell_asic *ic)
 {
   adBmsWakeupIc(tIC);
-  adBmsReadData(tIC, &ic[0], RDFCA, F_volt, A);
-  adBmsReadData(tIC, &ic[0], RDFCB, F_volt, B);
-  adBmsReadData(tIC, &ic[0], RDFCC, F_volt, C);
-  adBmsReadData(tIC, &ic[0], RDFCD, F_volt, D);
-  adBmsReadData(tIC, &ic[0], RDFCE, F_volt, E);
-  adBmsReadData(tIC, &ic[0], RDFCF, F_volt, F);
+  adBmsReadData(tIC, &ic[0], &RDFCA);
+  adBmsReadData(tIC, &ic[0], &RDFCB);
+  adBmsReadData(tIC, &ic[0], &RDFCC);
+  adBmsReadData(tIC, &ic[0], &RDFCD);
+  adBmsReadData(tIC, &ic[0], &RDFCE);
+  adBmsReadData(tIC, &ic[0], &RDFCF);
   printVoltages(tIC, &ic[0], F_volt);
 }
 
@@ -426,15 +503,15 @@ void adBms6830_start_aux_voltage_measurment(uint8_t tIC, cell_asic *ic)
     ic[cic].tx_cfga.gpo = 0X3FF; /* All GPIO pull down off */
   }
   adBmsWakeupIc(tIC);
-  adBmsWriteData(tIC, &ic[0], WRCFGA, Config, A);
+  adBmsCfgWrite(tIC, &ic[0]);
   adBms6830_Adax(AUX_OPEN_WIRE_DETECTION, OPEN_WIRE_CURRENT_SOURCE, AUX_CH_TO_CONVERT);
-  pladc_count = adBmsPollAdc(PLADC);
+  adBmsAdcWait(ADC_CONV_AUX);
 #ifdef MBED
   pc.printf("Aux voltage conversion completed\n");
 #else
   printf("Aux voltage conversion completed\n");
 #endif
-  printPollAdcConvTime(pladc_count);
+  printPollAdcConvTime(ADC_CONV_AUX);
 }
 
 /**
@@ -445,10 +522,10 @@ void adBms6830_start_aux_voltage_measurment(uint8_t tIC, cell_asic *ic)
 void adBms6830_read_aux_voltages(uint8_t tIC, cell_asic *ic)
 {
   adBmsWakeupIc(tIC);
-  adBmsReadData(tIC, &ic[0], RDAUXA, Aux, A);
-  adBmsReadData(tIC, &ic[0], RDAUXB, Aux, B);
-  adBmsReadData(tIC, &ic[0], RDAUXC, Aux, C);
-  adBmsReadData(tIC, &ic[0], RDAUXD, Aux, D);
+  adBmsReadData(tIC, &ic[0], &RDAUXA);
+  adBmsReadData(tIC, &ic[0], &RDAUXB);
+  adBmsReadData(tIC, &ic[0], &RDAUXC);
+  adBmsReadData(tIC, &ic[0], &RDAUXD);
   printVoltages(tIC, &ic[0], Aux);
 }
 
@@ -466,15 +543,15 @@ void adBms6830_start_raux_voltage_measurment(uint8_t tIC,  cell_asic *ic)
     ic[cic].tx_cfga.gpo = 0X3FF; /* All GPIO pull down off */
   }
   adBmsWakeupIc(tIC);
-  adBmsWriteData(tIC, &ic[0], WRCFGA, Config, A);
+  adBmsCfgWrite(tIC, &ic[0]);
   adBms6830_Adax2(AUX_CH_TO_CONVERT);
-  pladc_count = adBmsPollAdc(PLADC);
+  adBmsAdcWait(ADC_CONV_AUX2);
 #ifdef MBED
   pc.printf("RAux voltage conversion completed\n");
 #else
   printf("RAux voltage conversion completed\n");
 #endif
-  printPollAdcConvTime(pladc_count);
+  printPollAdcConvTime(ADC_CONV_AUX2);
 }
 
 /**
@@ -485,10 +562,10 @@ void adBms6830_start_raux_voltage_measurment(uint8_t tIC,  cell_asic *ic)
 void adBms6830_read_raux_voltages(uint8_t tIC, cell_asic *ic)
 {
   adBmsWakeupIc(tIC);
-  adBmsReadData(tIC, &ic[0], RDRAXA, RAux, A);
-  adBmsReadData(tIC, &ic[0], RDRAXB, RAux, B);
-  adBmsReadData(tIC, &ic[0], RDRAXC, RAux, C);
-  adBmsReadData(tIC, &ic[0], RDRAXD, RAux, D);
+  adBmsReadData(tIC, &ic[0], &RDRAXA);
+  adBmsReadData(tIC, &ic[0], &RDRAXB);
+  adBmsReadData(tIC, &ic[0], &RDRAXC);
+  adBmsReadData(tIC, &ic[0], &RDRAXD);
   printVoltages(tIC, &ic[0], RAux);
 }
 
@@ -500,22 +577,42 @@ void adBms6830_read_raux_voltages(uint8_t tIC, cell_asic *ic)
 void adBms6830_read_status_registers(uint8_t tIC, cell_asic *ic)
 {
   adBmsWakeupIc(tIC);
-  adBmsWriteData(tIC, &ic[0], WRCFGA, Config, A);
-  adBmsWriteData(tIC, &ic[0], WRCFGB, Config, B);
+  adBmsCfgWrite(tIC, &ic[0]);
   adBms6830_Adax(AUX_OPEN_WIRE_DETECTION, OPEN_WIRE_CURRENT_SOURCE, AUX_CH_TO_CONVERT);
-  pladc_count = adBmsPollAdc(PLADC);
+  adBmsAdcWait(ADC_CONV_AUX);
   adBms6830_Adcv(REDUNDANT_MEASUREMENT, CONTINUOUS_MEASUREMENT, DISCHARGE_PERMITTED, RESET_FILTER, CELL_OPEN_WIRE_DETECTION);
-  pladc_count = pladc_count + adBmsPollAdc(PLADC);
-
-  adBmsReadData(tIC, &ic[0], RDSTATA, Status, A);
-  adBmsReadData(tIC, &ic[0], RDSTATB, Status, B);
-  adBmsReadData(tIC, &ic[0], RDSTATC, Status, C);
-  adBmsReadData(tIC, &ic[0], RDSTATD, Status, D);
-  adBmsReadData(tIC, &ic[0], RDSTATE, Status, E);
-  printPollAdcConvTime(pladc_count);
+  adBmsAdcWait(ADC_CONV_C);
+
+  adBmsReadData(tIC, &ic[0], &RDSTATA);
+  adBmsReadData(tIC, &ic[0], &RDSTATB);
+  adBmsReadData(tIC, &ic[0], &RDSTATC);
+  adBmsReadData(tIC, &ic[0], &RDSTATD);
+  adBmsReadData(tIC, &ic[0], &RDSTATE);
+  printPollAdcConvTime(ADC_CONV_AUX);
+  printPollAdcConvTime(ADC_CONV_C);
   printStatus(tIC, &ic[0], Status, ALL_GRP);
 }
 
+/**
+*******************************************************************************
+* @brief Read a measurement in the selected read mode.
+*******************************************************************************
+*/
+static void measurement_read(LOOP_READ_MODE mode, const cmd_desc_ *all, const cmd_desc_ *const *grp, uint8_t grp_count)
+{
+  if(mode == READ_ALL)
+  {
+    adBmsReadData(TOTAL_IC, &IC[0], all);
+  }
+  else
+  {
+    for(uint8_t g = 0; g < grp_count; g++)
+    {
+      adBmsReadData(TOTAL_IC, &IC[0], grp[g]);
+    }
+  }
+}
+
 /**
 *******************************************************************************
 * @brief Loop measurment.
@@ -523,82 +620,91 @@ void adBms6830_read_status_registers(uint8_t tIC, cell_asic *ic)
 */
 void measurement_loop()
 {
+  xfer_stats_ start = *adBmsGetXferStats();
+  const xfer_stats_ *end;
+  uint32_t transactions, bytes;
+  bool read_cs_all = (MEASURE_CELL == ENABLED) && (MEASURE_S_VOLTAGE == ENABLED) && (READ_CELL == READ_ALL) && (READ_S_VOLTAGE == READ_ALL);
+  bool read_as_done = false;
+
   if(MEASURE_CELL == ENABLED)
   {
-    adBmsReadData(TOTAL_IC, &IC[0], RDCVA, Cell, A);
-    adBmsReadData(TOTAL_IC, &IC[0], RDCVB, Cell, B);
-    adBmsReadData(TOTAL_IC, &IC[0], RDCVC, Cell, C);
-    adBmsReadData(TOTAL_IC, &IC[0], RDCVD, Cell, D);
-    adBmsReadData(TOTAL_IC, &IC[0], RDCVE, Cell, E);
-    adBmsReadData(TOTAL_IC, &IC[0], RDCVF, Cell, F);
+    measurement_read(READ_CELL, (read_cs_all ? &RDCSALL : &RDCVALL), RD_CELL_GRP, 6);
     printVoltages(TOTAL_IC, &IC[0], Cell);
   }
 
   if(MEASURE_AVG_CELL == ENABLED)
   {
-    adBmsReadData(TOTAL_IC, &IC[0], RDACA, AvgCell, A);
-    adBmsReadData(TOTAL_IC, &IC[0], RDACB, AvgCell, B);
-    adBmsReadData(TOTAL_IC, &IC[0], RDACC, AvgCell, C);
-    adBmsReadData(TOTAL_IC, &IC[0], RDACD, AvgCell, D);
-    adBmsReadData(TOTAL_IC, &IC[0], RDACE, AvgCell, E);
-    adBmsReadData(TOTAL_IC, &IC[0], RDACF, AvgCell, F);
+    measurement_read(READ_AVG_CELL, &RDACALL, RD_AVG_GRP, 6);
     printVoltages(TOTAL_IC, &IC[0], AvgCell);
   }
 
   if(MEASURE_F_CELL == ENABLED)
   {
-    adBmsReadData(TOTAL_IC, &IC[0], RDFCA, F_volt, A);
-    adBmsReadData(TOTAL_IC, &IC[0], RDFCB, F_volt, B);
-    adBmsReadData(TOTAL_IC, &IC[0], RDFCC, F_volt, C);
-    adBmsReadData(TOTAL_IC, &IC[0], RDFCD, F_volt, D);
-    adBmsReadData(TOTAL_IC, &IC[0], RDFCE, F_volt, E);
-    adBmsReadData(TOTAL_IC, &IC[0], RDFCF, F_volt, F);
+    measurement_read(READ_F_CELL, &RDFCALL, RD_FCELL_GRP, 6);
     printVoltages(TOTAL_IC, &IC[0], F_volt);
   }
 
   if(MEASURE_S_VOLTAGE == ENABLED)
   {
-    adBmsReadData(TOTAL_IC, &IC[0], RDSVA, S_volt, A);
-    adBmsReadData(TOTAL_IC, &IC[0], RDSVB, S_volt, B);
-    adBmsReadData(TOTAL_IC, &IC[0], RDSVC, S_volt, C);
-    adBmsReadData(TOTAL_IC, &IC[0], RDSVD, S_volt, D);
-    adBmsReadData(TOTAL_IC, &IC[0], RDSVE, S_volt, E);
-    adBmsReadData(TOTAL_IC, &IC[0], RDSVF, S_volt, F);
+    if(!read_cs_all) /* Else already read with the cell voltages */
+    {
+      measurement_read(READ_S_VOLTAGE, &RDSALL, RD_SVOLT_GRP, 6);
+    }
     printVoltages(TOTAL_IC, &IC[0], S_volt);
   }
 
+  /* Start aux conversions first, RDASALL returns aux, raux and status at once */
   if(MEASURE_AUX == ENABLED)
   {
     adBms6830_Adax(AUX_OPEN_WIRE_DETECTION, OPEN_WIRE_CURRENT_SOURCE, AUX_CH_TO_CONVERT);
-    adBmsPollAdc(PLAUX1);
-    adBmsReadData(TOTAL_IC, &IC[0], RDAUXA, Aux, A);
-    adBmsReadData(TOTAL_IC, &IC[0], RDAUXB, Aux, B);
-    adBmsReadData(TOTAL_IC, &IC[0], RDAUXC, Aux, C);
-    adBmsReadData(TOTAL_IC, &IC[0], RDAUXD, Aux, D);
-    printVoltages(TOTAL_IC, &IC[0], Aux);
+    adBmsAdcWait(ADC_CONV_AUX);
   }
 
   if(MEASURE_RAUX == ENABLED)
   {
     adBmsWakeupIc(TOTAL_IC);
     adBms6830_Adax2(AUX_CH_TO_CONVERT);
-    adBmsPollAdc(PLAUX2);
-    adBmsReadData(TOTAL_IC, &IC[0], RDRAXA, RAux, A);
-    adBmsReadData(TOTAL_IC, &IC[0], RDRAXB, RAux, B);
-    adBmsReadData(TOTAL_IC, &IC[0], RDRAXC, RAux, C);
-    adBmsReadData(TOTAL_IC, &IC[0], RDRAXD, RAux, D);
+    adBmsAdcWait(ADC_CONV_AUX2);
+  }
+
+  if(MEASURE_AUX == ENABLED)
+  {
+    if(!(read_as_done && (READ_AUX == READ_ALL)))
+    {
+      measurement_read(READ_AUX, &RDASALL, RD_AUX_GRP, 4);
+      read_as_done |= (READ_AUX == READ_ALL);
+    }
+    printVoltages(TOTAL_IC, &IC[0], Aux);
+  }
+
+  if(MEASURE_RAUX == ENABLED)
+  {
+    if(!(read_as_done && (READ_RAUX == READ_ALL)))
+    {
+      measurement_read(READ_RAUX, &RDASALL, RD_RAUX_GRP, 4);
+      read_as_done |= (READ_RAUX == READ_ALL);
+    }
     printVoltages(TOTAL_IC, &IC[0], RAux);
   }
 
   if(MEASURE_STAT == ENABLED)
   {
-    adBmsReadData(TOTAL_IC, &IC[0], RDSTATA, Status, A);
-    adBmsReadData(TOTAL_IC, &IC[0], RDSTATB, Status, B);
-    adBmsReadData(TOTAL_IC, &IC[0], RDSTATC, Status, C);
-    adBmsReadData(TOTAL_IC, &IC[0], RDSTATD, Status, D);
-    adBmsReadData(TOTAL_IC, &IC[0], RDSTATE, Status, E);
+    if(!(read_as_done && (READ_STAT == READ_ALL)))
+    {
+      measurement_read(READ_STAT, &RDASALL, RD_STAT_GRP, 5);
+    }
     printStatus(TOTAL_IC, &IC[0], Status, ALL_GRP);
   }
+
+  end = adBmsGetXferStats();
+  transactions = (end->cmd_count - start.cmd_count) + (end->read_count - start.read_count)
+               + (end->write_count - start.write_count) + (end->poll_count - start.poll_count);
+  bytes = (end->tx_bytes - start.tx_bytes) + (end->rx_bytes - start.rx_bytes);
+#ifdef MBED
+  pc.printf("Loop isoSPI transactions = %lu, bus bytes = %lu\n", (unsigned long)transactions, (unsigned long)bytes);
+#else
+  printf("Loop isoSPI transactions = %lu, bus bytes = %lu\n", (unsigned long)transactions, (unsigned long)bytes);
+#endif
 }
 
 /**
@@ -609,7 +715,7 @@ void measurement_loop()
 void adBms6830_clear_cell_measurement(uint8_t tIC)
 {
   adBmsWakeupIc(tIC);
-  spiSendCmd(CLRCELL);
+  spiSendCmd(&CLRCELL);
 #ifdef MBED
   pc.printf("Cell Registers Cleared\n\n");
 #else
@@ -625,7 +731,7 @@ void adBms6830_clear_cell_measurement(uint8_t tIC)
 void adBms6830_clear_aux_measurement(uint8_t tIC)
 {
   adBmsWakeupIc(tIC);
-  spiSendCmd(CLRAUX);
+  spiSendCmd(&CLRAUX);
 #ifdef MBED
   pc.printf("Aux Registers Cleared\n\n");
 #else
@@ -641,7 +747,7 @@ void adBms6830_clear_aux_measurement(uint8_t tIC)
 void adBms6830_clear_spin_measurement(uint8_t tIC)
 {
   adBmsWakeupIc(tIC);
-  spiSendCmd(CLRSPIN);
+  spiSendCmd(&CLRSPIN);
 #ifdef MBED
   pc.printf("Spin Registers Cleared\n\n");
 #else
@@ -657,7 +763,7 @@ void adBms6830_clear_spin_measurement(uint8_t tIC)
 void adBms6830_clear_fcell_measurement(uint8_t tIC)
 {
   adBmsWakeupIc(tIC);
-  spiSendCmd(CLRFC);
+  spiSendCmd(&CLRFC);
 #ifdef MBED
   pc.printf("Fcell Registers Cleared\n\n");
 #else
@@ -665,5 +771,214 @@ void adBms6830_clear_fcell_measurement(uint8_t tIC)
 #endif
 }
 
+/**
+*******************************************************************************
+* @brief Cell open wire test (C-ADC), current on even then odd channels.
+*******************************************************************************
+*/
+void adBms6830_cell_openwire_test(uint8_t tIC, cell_asic *ic)
+{
+  adBmsWakeupIc(tIC);
+  adBms6830_cell_ow_volatge_collect(tIC, &ic[0], Cell, OW_ON_EVEN_CH);
+  adBms6830_cell_ow_volatge_collect(tIC, &ic[0], Cell, OW_ON_ODD_CH);
+  adBms6830_open_wire_detection_condtion_check(tIC, &ic[0], Cell);
+  printOpenWireTestResult(tIC, &ic[0], Cell);
+}
+
+/**
+*******************************************************************************
+* @brief Redundant cell open wire test (S-ADC), current on even then odd channels.
+*******************************************************************************
+*/
+void adBms6830_redundant_cell_openwire_test(uint8_t tIC, cell_asic *ic)
+{
+  adBmsWakeupIc(tIC);
+  adBms6830_cell_ow_volatge_collect(tIC, &ic[0], S_volt, OW_ON_EVEN_CH);
+  adBms6830_cell_ow_volatge_collect(tIC, &ic[0], S_volt, OW_ON_ODD_CH);
+  adBms6830_open_wire_detection_condtion_check(tIC, &ic[0], S_volt);
+  printOpenWireTestResult(tIC, &ic[0], S_volt);
+}
+
+/**
+*******************************************************************************
+* @brief Convert the cells once with open wire current on and keep the codes.
+*        Cell uses the C-ADC, S_volt the S-ADC.
+*******************************************************************************
+*/
+void adBms6830_cell_ow_volatge_collect(uint8_t tIC, cell_asic *ic, TYPE type, OW_C_S ow_c_s)
+{
+  adBmsWakeupIc(tIC);
+  if(type == S_volt)
+  {
+    adBms6830_Adsv(SINGLE, DCP_OFF, ow_c_s);
+    adBmsAdcWait(ADC_CONV_S);
+    adBmsReadData(tIC, &ic[0], &RDSALL);
+  }
+  else
+  {
+    adBms6830_Adcv(RD_OFF, SINGLE, DCP_OFF, RSTF_OFF, ow_c_s);
+    adBmsAdcWait(ADC_CONV_C);
+    adBmsReadData(tIC, &ic[0], &RDCVALL);
+  }
+  adBmsOwCellStore(tIC, &ic[0], type, ow_c_s);
+}
+
+/**
+*******************************************************************************
+* @brief Aux open wire test, gpio pull-up then pull-down current.
+*******************************************************************************
+*/
+void adBms6830_aux_openwire_test(uint8_t tIC, cell_asic *ic)
+{
+  adBmsWakeupIc(tIC);
+  adBms6830_gpio_pup_up_down_volatge_collect(tIC, &ic[0], PUP_UP);
+  adBms6830_gpio_pup_up_down_volatge_collect(tIC, &ic[0], PUP_DOWN);
+  adBms6830_open_wire_detection_condtion_check(tIC, &ic[0], Aux);
+  printOpenWireTestResult(tIC, &ic[0], Aux);
+}
+
+/**
+*******************************************************************************
+* @brief Convert the gpios once with pull-up or pull-down current and keep the codes.
+*******************************************************************************
+*/
+void adBms6830_gpio_pup_up_down_volatge_collect(uint8_t tIC, cell_asic *ic, PUP pup)
+{
+  adBmsWakeupIc(tIC);
+  adBms6830_Adax(AUX_OW_ON, pup, AUX_ALL);
+  adBmsAdcWait(ADC_CONV_AUX);
+  adBmsReadData(tIC, &ic[0], &RDASALL);
+  adBmsOwAuxStore(tIC, &ic[0], pup);
+}
+
+/**
+*******************************************************************************
+* @brief Flag open wires from the collected codes, OWC_Threshold for the
+*        cells (Cell, S_volt), OWA_Threshold for the gpios (Aux).
+*******************************************************************************
+*/
+void adBms6830_open_wire_detection_condtion_check(uint8_t tIC, cell_asic *ic, TYPE type)
+{
+  if(type == Aux)
+  {
+    adBmsOwAuxCheck(tIC, &ic[0], OWA_Threshold, READ_IC_ALL);
+  }
+  else
+  {
+    adBmsOwCellCheck(tIC, &ic[0], type, (OWC_Threshold * 1000), READ_IC_ALL);
+  }
+}
+
+/**
+*******************************************************************************
+* @brief Oscillator mismatch self test: force the oscillator counter fast
+*        (FLAG_D0), OSCCHK must set.
+*******************************************************************************
+*/
+void adBms6830_run_osc_mismatch_self_test(uint8_t tIC, cell_asic *ic)
+{
+  adBmsWakeupIc(tIC);
+  adBmsStRun(tIC, &ic[0], ST_OSC);
+  printDiagnosticTestResult(tIC, &ic[0], OSC_MISMATCH);
+}
+
+/**
+*******************************************************************************
+* @brief Thermal shutdown self test: force THSD (FLAG_D4), THSD must set.
+*******************************************************************************
+*/
+void adBms6830_run_thermal_shutdown_self_test(uint8_t tIC, cell_asic *ic)
+{
+  adBmsWakeupIc(tIC);
+  adBmsStRun(tIC, &ic[0], ST_THSD);
+  printDiagnosticTestResult(tIC, &ic[0], THSD);
+}
+
+/**
+*******************************************************************************
+* @brief Supply error self test: force a supply error (FLAG_D2) with UV
+*        selected, then with OV selected (FLAG_D3); VA/VD UV then OV must set.
+*******************************************************************************
+*/
+void adBms6830_run_supply_error_detection_self_test(uint8_t tIC, cell_asic *ic)
+{
+  adBmsWakeupIc(tIC);
+  adBmsStRun(tIC, &ic[0], ST_SUPPLY_UV);
+  adBmsStRun(tIC, &ic[0], ST_SUPPLY_OV);
+  printDiagnosticTestResult(tIC, &ic[0], SUPPLY_ERROR);
+}
+
+/**
+*******************************************************************************
+* @brief Fuse ED self test: force fuse ED (FLAG_D5), OTP1/OTP2 ED must set.
+*******************************************************************************
+*/
+void adBms6830_run_fuse_ed_self_test(uint8_t tIC, cell_asic *ic)
+{
+  adBmsWakeupIc(tIC);
+  adBmsStRun(tIC, &ic[0], ST_FUSE_ED);
+  printDiagnosticTestResult(tIC, &ic[0], FUSE_ED);
+}
+
+/**
+*******************************************************************************
+* @brief Fuse MED self test: force fuse MED (FLAG_D6), OTP1/OTP2 MED must set.
+*******************************************************************************
+*/
+void adBms6830_run_fuse_med_self_test(uint8_t tIC, cell_asic *ic)
+{
+  adBmsWakeupIc(tIC);
+  adBmsStRun(tIC, &ic[0], ST_FUSE_MED);
+  printDiagnosticTestResult(tIC, &ic[0], FUSE_MED);
+}
+
+/**
+*******************************************************************************
+* @brief Test mode check self test: force TMODCHK (FLAG_D7), TMODCHK must set.
+*******************************************************************************
+*/
+void adBms6830_run_tmodchk_self_test(uint8_t tIC, cell_asic *ic)
+{
+  adBmsWakeupIc(tIC);
+  adBmsStRun(tIC, &ic[0], ST_TMODCHK);
+  printDiagnosticTestResult(tIC, &ic[0], TMODCHK);
+}
+
+/**
+*******************************************************************************
+* @brief CSFLT latent fault test: status C read with the ERR bit, every
+*        CSxFLT bit must read set.
+*******************************************************************************
+*/
+void adBms6830_check_latent_fault_csflt_status_bits(uint8_t tIC, cell_asic *ic)
+{
+  adBmsWakeupIc(tIC);
+  adBmsStRun(tIC, &ic[0], ST_CSFLT);
+  printDiagnosticTestResult(tIC, &ic[0], CS_FLT);
+}
+
+/**
+*******************************************************************************
+* @brief RDSTATC ERR bit test: the ERR read must set every CSxFLT bit and the
+*        normal read right after must not, the ERR bit only acts on the read.
+*******************************************************************************
+*/
+void adBms6830_check_rdstatc_err_bit_functionality(uint8_t tIC, cell_asic *ic)
+{
+  uint16_t cs_flt_err[MAX_IC];
+  uint32_t pec;
+  adBmsWakeupIc(tIC);
+  adBmsReadData(tIC, &ic[0], &RDSTATCERR);
+  pec = adBmsReadPecMask(tIC, &ic[0], &RDSTATCERR);
+  for(uint8_t cic = 0; cic < tIC; cic++){ cs_flt_err[cic] = ic[cic].statc.cs_flt; }
+  adBmsReadData(tIC, &ic[0], &RDSTATC);
+  pec |= adBmsReadPecMask(tIC, &ic[0], &RDSTATC);
+  for(uint8_t cic = 0; cic < tIC; cic++)
+  {
+    ic[cic].diag_result.cs_flt = ((pec & (1u << cic)) == 0) && (cs_flt_err[cic] == 0xFFFF) && (ic[cic].statc.cs_flt != 0xFFFF);
+  }
+  printDiagnosticTestResult(tIC, &ic[0], CS_FLT);
+}
+
 /** @}*/
 /** @}*/
@@ -18,7 +18,33 @@ and its licensor.
 */
 #include "common.h"
 #include "mcuWrapper.h"
-#define WAKEUP_DELAY 4                          /* BMS ic wakeup delay  */
+#include "adBms6830Data.h"
+#include "adBms6830Profile.h"
+#define T_READY_US 10                           /* tREADY: isoSpi idle to ready (max) */
+#define T_WAKE_US 500                           /* tWAKE: core sleep to standby (max) */
+#define T_IDLE_MS 4                             /* tIDLE 4.3ms (min) less tick resolution */
+#define T_SLEEP_MS 1700                         /* tSLEEP 1.8s (min) less margin */
+#define SPI_DMA_SIZE (4 + (MAX_IC * MAX_RX_SIZE)) /* Command + read back of all ic */
+
+/* Dma buffers live in SRAM1 (the dma controller has no access to CCM ram),
+   tools/map_report.py fails the build if they move */
+static uint8_t spi_dma_tx[SPI_DMA_SIZE];
+static uint8_t spi_dma_rx[SPI_DMA_SIZE];
+static uint16_t spi_dma_size;                  /* Command + read back bytes  */
+static uint16_t spi_dma_pos;                   /* Bytes already clocked      */
+static uint16_t spi_dma_len;                   /* Current dma segment length */
+static volatile bool spi_dma_busy = false;
+static volatile bool spi_dma_error = false;
+static spi_done_cb_ spi_dma_cb = NULL;
+
+static bool spiDmaPrepare(uint8_t *tx_cmd, uint16_t size, spi_done_cb_ done_cb);
+static void spiDmaComplete(bool error);
+static bool spiDmaNextChunk(void);
+
+/* isoSpi wake tracker, stamped on every chip select release */
+static volatile uint32_t wake_stamp_ms;
+static bool wake_chain_awake = false;          /* Chain assumed asleep at power up */
+static uint32_t wake_count;                    /* Wake sequences issued */
 
 #ifdef MBED
 extern Serial pc;
@@ -45,6 +71,36 @@ void Delay_ms(uint32_t delay)
   wait_ms((int)delay);
 }
 
+/**
+ *******************************************************************************
+ * Function: Delay_us
+ * @brief Delay micro second
+ *
+ * @param [in]  delay   Delay_us
+ *
+ * @return None
+ *
+ *******************************************************************************
+*/
+void Delay_us(uint32_t delay)
+{
+  wait_us((int)delay);
+}
+
+/**
+ *******************************************************************************
+ * Function: getTickMs
+ * @brief Get mili second tick
+ *
+ * @return Free running mili second tick
+ *
+ *******************************************************************************
+*/
+uint32_t getTickMs(void)
+{
+  return(us_ticker_read() / 1000);
+}
+
 /**
  *******************************************************************************
  * Function: adBmsCsLow
@@ -77,6 +133,7 @@ void adBmsCsHigh()
 {
   chip_select = 1;
   spi.unlock();
+  wake_stamp_ms = getTickMs();
 }
 
 /**
@@ -153,7 +210,7 @@ uint16_t size                           /*Option: number of bytes*/
 void spiReadBytes(uint16_t size, uint8_t *rx_data)
 {   
   uint8_t tx_data[size];
-  for(uint8_t i=0; i < size; i++)
+  for(uint16_t i=0; i < size; i++)
   {
     tx_data[i] = 0xFF;
   }
@@ -210,6 +267,241 @@ uint32_t getTimCount()
   timer.reset();
   return(count);
 }
+
+/**
+ *******************************************************************************
+ * Function: getTimUs()
+ * @brief Get free running micro second count
+ *
+ * @return Timer value (us), the timer is not reset
+ *
+ *******************************************************************************
+*/
+uint32_t getTimUs(void)
+{
+  return((uint32_t)timer.read_us());
+}
+
+/**
+ *******************************************************************************
+ * Function: cycleCounterInit()
+ * @brief Start the profiling cycle counter
+ *
+ * @details Mbed has no portable cycle counter, the profiling count is the
+ *          free running micro second timer.
+ *
+ * @return None
+ *
+ *******************************************************************************
+*/
+void cycleCounterInit(void)
+{
+}
+
+/**
+ *******************************************************************************
+ * Function: getCycleCount()
+ * @brief Get profiling cycle count
+ *
+ * @return Micro second count
+ *
+ *******************************************************************************
+*/
+uint32_t getCycleCount(void)
+{
+  return((uint32_t)timer.read_us());
+}
+
+/**
+ *******************************************************************************
+ * Function: spiWriteReadBytesDma
+ * @brief Write command and read back a set number of bytes.
+ *
+ * @details Mbed has no dma backend, the transfer is done blocking and the
+ *          completion callback is called before return.
+ *
+ * @param [in]  *tx_cmd     Command + pec (4 byte)
+ *
+ * @param [in]  size        Read back data size
+ *
+ * @param [in]  done_cb     Completion callback (optional)
+ *
+ * @return false if a transfer is pending or size exceed the dma buffer
+ *
+ *******************************************************************************
+*/
+bool spiWriteReadBytesDma(uint8_t *tx_cmd, uint16_t size, spi_done_cb_ done_cb)
+{
+  if(!spiDmaPrepare(tx_cmd, size, done_cb)){ return false; }
+  spi.write((char *)spi_dma_tx, spi_dma_size, (char *)spi_dma_rx, spi_dma_size);
+  spiDmaComplete(false);
+  return true;
+}
+#elif defined(SPI_MOCK)
+
+static spi_mock_responder_ mock_responder = NULL; /* Test responder */
+static uint32_t mock_time_us;                     /* Test clock */
+
+/**
+ *******************************************************************************
+ * Function: spiMockSetResponder
+ * @brief Install the mock spi responder.
+ *
+ * @details Every transfer is passed to the responder, which fills the read
+ *          back bytes. Without responder the miso line reads 0xFF.
+ *
+ * @param [in]  responder   Responder function (NULL to remove)
+ *
+ * @return None
+ *
+ *******************************************************************************
+*/
+void spiMockSetResponder(spi_mock_responder_ responder)
+{
+  mock_responder = responder;
+}
+
+/**
+ *******************************************************************************
+ * Function: spiMockSetTick
+ * @brief Set the mock mili second tick.
+ *
+ * @param [in]  tick_ms     Tick value
+ *
+ * @return None
+ *
+ *******************************************************************************
+*/
+void spiMockSetTick(uint32_t tick_ms)
+{
+  mock_time_us = (tick_ms * 1000);
+}
+
+void Delay_ms(uint32_t delay)
+{
+  mock_time_us += (delay * 1000);
+}
+
+void Delay_us(uint32_t delay)
+{
+  mock_time_us += delay;
+}
+
+uint32_t getTickMs(void)
+{
+  return(mock_time_us / 1000);
+}
+
+uint32_t getTimUs(void)
+{
+  return(mock_time_us);
+}
+
+void cycleCounterInit(void)
+{
+}
+
+uint32_t getCycleCount(void)
+{
+  return(mock_time_us);
+}
+
+void adBmsCsLow()
+{
+}
+
+void adBmsCsHigh()
+{
+  wake_stamp_ms = getTickMs();
+}
+
+void spiWriteBytes
+(
+uint16_t size,                     /*Option: Number of bytes to be written on the SPI port*/
+uint8_t *tx_Data                       /*Array of bytes to be written on the SPI port*/
+)
+{
+  if(mock_responder != NULL){ mock_responder(tx_Data, size, NULL, 0); }
+}
+
+void spiWriteReadBytes
+(
+uint8_t *tx_data,                   /*array of data to be written on SPI port*/
+uint8_t *rx_data,                   /*Input: array that will store the data read by the SPI port*/
+uint16_t size                           /*Option: number of bytes*/
+)
+{
+  memset(rx_data, 0xFF, size);
+  if(mock_responder != NULL){ mock_responder(tx_data, 4, rx_data, size); }
+}
+
+void spiReadBytes(uint16_t size, uint8_t *rx_data)
+{
+  memset(rx_data, 0xFF, size);
+  if(mock_responder != NULL){ mock_responder(NULL, 0, rx_data, size); }
+}
+
+/**
+ *******************************************************************************
+ * Function: spiWriteReadBytesDma
+ * @brief Write command and read back a set number of bytes.
+ *
+ * @details The mock transfer stays pending until spiMockCompleteDma is called
+ *          once per dma segment, like the hardware transfer stays pending
+ *          until the dma interrupt.
+ *
+ * @param [in]  *tx_cmd     Command + pec (4 byte)
+ *
+ * @param [in]  size        Read back data size
+ *
+ * @param [in]  done_cb     Completion callback (optional)
+ *
+ * @return false if a transfer is pending or size exceed the dma buffer
+ *
+ *******************************************************************************
+*/
+bool spiWriteReadBytesDma(uint8_t *tx_cmd, uint16_t size, spi_done_cb_ done_cb)
+{
+  return(spiDmaPrepare(tx_cmd, size, done_cb));
+}
+
+/**
+ *******************************************************************************
+ * Function: spiMockCompleteDma
+ * @brief Complete the pending mock dma segment.
+ *
+ * @details This function runs the completion path of the dma interrupt; after
+ *          the last segment the responder fills the read back bytes.
+ *
+ * @param [in]  error       Complete with transfer error
+ *
+ * @return None
+ *
+ *******************************************************************************
+*/
+void spiMockCompleteDma(bool error)
+{
+  if(!spi_dma_busy){ return; }
+  if(!error && spiDmaNextChunk()){ return; } /* Next segment pending */
+  if(!error && (mock_responder != NULL))
+  {
+    mock_responder(&spi_dma_tx[0], 4, &spi_dma_rx[4], (spi_dma_size - 4));
+  }
+  spiDmaComplete(error);
+}
+
+void startTimer()
+{
+}
+
+void stopTimer()
+{
+}
+
+uint32_t getTimCount()
+{
+  return(0);
+}
 #else
 
 #define SPI_TIME_OUT HAL_MAX_DELAY              /* SPI Time out delay   */
@@ -241,6 +533,49 @@ void Delay_ms(uint32_t delay)
   HAL_Delay(delay);
 }
 
+/**
+ *******************************************************************************
+ * Function: Delay_us
+ * @brief Delay micro second
+ *
+ * @details This function insert delay in us, counted on the DWT cycle counter
+ *          (enabled on first use).
+ *
+ * Parameters:
+ * @param [in]  delay   Delay_us
+ *
+ * @return None
+ *
+ *******************************************************************************
+*/
+void Delay_us(uint32_t delay)
+{
+  uint32_t start, cycles;
+  if((DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk) == 0)
+  {
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+  }
+  start = DWT->CYCCNT;
+  cycles = delay * (SystemCoreClock / 1000000U);
+  while((DWT->CYCCNT - start) < cycles);
+}
+
+/**
+ *******************************************************************************
+ * Function: getTickMs
+ * @brief Get mili second tick
+ *
+ * @return SysTick mili second count
+ *
+ *******************************************************************************
+*/
+uint32_t getTickMs(void)
+{
+  return(HAL_GetTick());
+}
+
 /**
  *******************************************************************************
  * Function: adBmsCsLow
@@ -271,6 +606,7 @@ void adBmsCsLow()
 void adBmsCsHigh()
 {
   HAL_GPIO_WritePin(GPIO_PORT, CS_PIN, GPIO_PIN_SET);
+  wake_stamp_ms = getTickMs();
 }
 
 /**
@@ -322,7 +658,14 @@ uint16_t size                           /*Option: number of bytes*/
 )
 {
   HAL_SPI_Transmit(hspi, tx_data, 4, SPI_TIME_OUT);
+#if SPI_RX_CHUNK_SIZE > 0
+  for (uint16_t pos = 0; pos < size; pos += SPI_RX_CHUNK_SIZE)
+  {
+    HAL_SPI_Receive(hspi, &rx_data[pos], (((size - pos) > SPI_RX_CHUNK_SIZE) ? SPI_RX_CHUNK_SIZE : (size - pos)), SPI_TIME_OUT);
+  }
+#else
   HAL_SPI_Receive(hspi, rx_data, size, SPI_TIME_OUT);
+#endif
 }
 
 /**
@@ -345,6 +688,83 @@ void spiReadBytes(uint16_t size, uint8_t *rx_data)
   HAL_SPI_Receive(hspi, rx_data, size, SPI_TIME_OUT);
 }
 
+/**
+ *******************************************************************************
+ * Function: spiWriteReadBytesDma
+ * @brief Start dma write command and read back a set number of bytes.
+ *
+ * @details This function pulls chip select low and starts a full duplex dma
+ *          transfer of command + read back bytes, then returns immediately.
+ *          Chip select is released and done_cb called from the dma interrupt.
+ *
+ * @param [in]  *tx_cmd     Command + pec (4 byte)
+ *
+ * @param [in]  size        Read back data size
+ *
+ * @param [in]  done_cb     Completion callback (optional)
+ *
+ * @return false if a transfer is pending, size exceed the dma buffer or the
+ *         dma could not be started
+ *
+ *******************************************************************************
+*/
+bool spiWriteReadBytesDma(uint8_t *tx_cmd, uint16_t size, spi_done_cb_ done_cb)
+{
+  if(!spiDmaPrepare(tx_cmd, size, done_cb)){ return false; }
+  if(HAL_SPI_TransmitReceive_DMA(hspi, &spi_dma_tx[0], &spi_dma_rx[0], spi_dma_len) != HAL_OK)
+  {
+    adBmsCsHigh();
+    PROF_END(PROF_SPI);
+    spi_dma_cb = NULL;
+    spi_dma_error = true;
+    spi_dma_busy = false;
+    return false;
+  }
+  return true;
+}
+
+/**
+ *******************************************************************************
+ * Function: HAL_SPI_TxRxCpltCallback
+ * @brief Spi dma transfer complete callback (interrupt context).
+ *
+ * @details Starts the next segment of a chunked read, chip select stays low.
+ *
+ * @param [in]  *spi_handle  Spi handler
+ *
+ * @return None
+ *
+ *******************************************************************************
+*/
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *spi_handle)
+{
+  if(spi_handle != hspi){ return; }
+  if(!spiDmaNextChunk())
+  {
+    spiDmaComplete(false);
+  }
+  else if(HAL_SPI_TransmitReceive_DMA(hspi, &spi_dma_tx[spi_dma_pos], &spi_dma_rx[spi_dma_pos], spi_dma_len) != HAL_OK)
+  {
+    spiDmaComplete(true);
+  }
+}
+
+/**
+ *******************************************************************************
+ * Function: HAL_SPI_ErrorCallback
+ * @brief Spi dma transfer error callback (interrupt context).
+ *
+ * @param [in]  *spi_handle  Spi handler
+ *
+ * @return None
+ *
+ *******************************************************************************
+*/
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *spi_handle)
+{
+  if(spi_handle == hspi){ spiDmaComplete(true); }
+}
+
 /**
  *******************************************************************************
  * Function: startTimer()
@@ -396,6 +816,57 @@ uint32_t getTimCount()
   return(count);
 }
 
+/**
+ *******************************************************************************
+ * Function: getTimUs()
+ * @brief Get free running micro second count
+ *
+ * @details TIM2 runs free at 1MHz (32 bit, wraps after ~71 minutes), the
+ *          counter is not reset so differences stay valid across wrap.
+ *
+ * @return Timer value (us)
+ *
+ *******************************************************************************
+*/
+uint32_t getTimUs(void)
+{
+  return(__HAL_TIM_GetCounter(htim));
+}
+
+/**
+ *******************************************************************************
+ * Function: cycleCounterInit()
+ * @brief Start the profiling cycle counter
+ *
+ * @details Enables the DWT unit (trace enable in DEMCR) and its free running
+ *          core cycle counter. The count follows the core clock, a clock
+ *          profile switch changes the cycle time.
+ *
+ * @return None
+ *
+ *******************************************************************************
+*/
+void cycleCounterInit(void)
+{
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+/**
+ *******************************************************************************
+ * Function: getCycleCount()
+ * @brief Get profiling cycle count
+ *
+ * @return DWT core cycle count
+ *
+ *******************************************************************************
+*/
+uint32_t getCycleCount(void)
+{
+  return(DWT->CYCCNT);
+}
+
 #endif
 
 /**
@@ -403,7 +874,14 @@ uint32_t getTimCount()
  * Function: adBmsWakeupIc
  * @brief Wakeup bms ic using chip select
  *
- * @details This function wakeup thr bms ic using chip select.
+ * @details This function wakeup the bms ic using chip select, only when the
+ *          chain may have left the READY state. Every chip select release
+ *          stamps the isoSpi activity time:
+ *          - less than tIDLE ago: chain is READY, nothing to do.
+ *          - less than tSLEEP ago: isoSpi ports are IDLE, one pulse per ic
+ *            spaced by tREADY.
+ *          - otherwise (or marked asleep): cores are in SLEEP, one pulse per
+ *            ic spaced by tWAKE.
  *
  * @param [in]  total_ic    Total_ic
  *
@@ -413,13 +891,178 @@ uint32_t getTimCount()
 */
 void adBmsWakeupIc(uint8_t total_ic)
 {
+  uint32_t elapsed = getTickMs() - wake_stamp_ms;
+  uint32_t pulse_us;
+  if(wake_chain_awake && (elapsed < T_IDLE_MS)){ return; }
+  pulse_us = (wake_chain_awake && (elapsed < T_SLEEP_MS)) ? T_READY_US : T_WAKE_US;
   for (uint8_t ic = 0; ic < total_ic; ic++)
   {
     adBmsCsLow();
-    Delay_ms(WAKEUP_DELAY);
+    Delay_us(T_READY_US);
     adBmsCsHigh();
-    Delay_ms(WAKEUP_DELAY);
+    Delay_us(pulse_us);
   }
+  wake_chain_awake = true;
+  wake_count++;
+}
+
+/**
+ *******************************************************************************
+ * Function: adBmsWakeMarkSleep
+ * @brief Mark the chain asleep
+ *
+ * @details The next adBmsWakeupIc issues the full tWAKE sequence. Call after
+ *          SRST or any event that puts the chain to sleep.
+ *
+ * @return None
+ *
+ *******************************************************************************
+*/
+void adBmsWakeMarkSleep(void)
+{
+  wake_chain_awake = false;
+}
+
+/**
+ *******************************************************************************
+ * Function: adBmsWakeCount
+ * @brief Number of wake sequences issued.
+ *
+ * @return Wake sequence count
+ *
+ *******************************************************************************
+*/
+uint32_t adBmsWakeCount(void)
+{
+  return(wake_count);
+}
+
+/**
+ *******************************************************************************
+ * Function: spiDmaPrepare
+ * @brief Claim the dma buffers for a new transfer.
+ *
+ * @details This function fill the tx buffer with command + 0xFF dummy bytes
+ *          and pulls chip select low.
+ *
+ * @param [in]  *tx_cmd     Command + pec (4 byte)
+ *
+ * @param [in]  size        Read back data size
+ *
+ * @param [in]  done_cb     Completion callback (optional)
+ *
+ * @return false if a transfer is pending or size exceed the dma buffer
+ *
+ *******************************************************************************
+*/
+static bool spiDmaPrepare(uint8_t *tx_cmd, uint16_t size, spi_done_cb_ done_cb)
+{
+  if(spi_dma_busy || (size > (SPI_DMA_SIZE - 4))){ return false; }
+  spi_dma_size = (4 + size);
+  spi_dma_pos = 0;
+  spi_dma_len = spi_dma_size;
+#if SPI_RX_CHUNK_SIZE > 0
+  if(spi_dma_len > SPI_RX_CHUNK_SIZE){ spi_dma_len = SPI_RX_CHUNK_SIZE; }
+#endif
+  memcpy(&spi_dma_tx[0], &tx_cmd[0], 4); /* dst, src, size */
+  memset(&spi_dma_tx[4], 0xFF, size);
+  spi_dma_cb = done_cb;
+  spi_dma_error = false;
+  spi_dma_busy = true;
+  PROF_BEGIN(PROF_SPI);
+  adBmsCsLow();
+  return true;
+}
+
+/**
+ *******************************************************************************
+ * Function: spiDmaNextChunk
+ * @brief Advance to the next dma segment.
+ *
+ * @details With SPI_RX_CHUNK_SIZE set, one read is clocked as several dma
+ *          segments of at most SPI_RX_CHUNK_SIZE bytes with chip select held
+ *          low. Without it the whole frame is one segment.
+ *
+ * @return true if another segment has to be started
+ *
+ *******************************************************************************
+*/
+static bool spiDmaNextChunk(void)
+{
+  spi_dma_pos += spi_dma_len;
+  if(spi_dma_pos >= spi_dma_size){ return false; }
+  spi_dma_len = (spi_dma_size - spi_dma_pos);
+#if SPI_RX_CHUNK_SIZE > 0
+  if(spi_dma_len > SPI_RX_CHUNK_SIZE){ spi_dma_len = SPI_RX_CHUNK_SIZE; }
+#endif
+  return true;
+}
+
+/**
+ *******************************************************************************
+ * Function: spiDmaComplete
+ * @brief Finish the dma transfer.
+ *
+ * @details This function release chip select, publish the transfer result and
+ *          call the completion callback.
+ *
+ * @param [in]  error       Transfer error
+ *
+ * @return None
+ *
+ *******************************************************************************
+*/
+static void spiDmaComplete(bool error)
+{
+  spi_done_cb_ done_cb = spi_dma_cb;
+  adBmsCsHigh();
+  PROF_END(PROF_SPI);
+  spi_dma_cb = NULL;
+  spi_dma_error = error;
+  spi_dma_busy = false;
+  if(done_cb != NULL){ done_cb(); }
+}
+
+/**
+ *******************************************************************************
+ * Function: spiDmaBusy
+ * @brief Dma transfer pending.
+ *
+ * @return true while a dma transfer is pending
+ *
+ *******************************************************************************
+*/
+bool spiDmaBusy(void)
+{
+  return(spi_dma_busy);
+}
+
+/**
+ *******************************************************************************
+ * Function: spiDmaError
+ * @brief Last dma transfer ended with error.
+ *
+ * @return true if the last dma transfer failed
+ *
+ *******************************************************************************
+*/
+bool spiDmaError(void)
+{
+  return(spi_dma_error);
+}
+
+/**
+ *******************************************************************************
+ * Function: spiDmaRxData
+ * @brief Read back data of the last dma transfer.
+ *
+ * @return Pointer to the read back bytes (after the 4 command bytes)
+ *
+ *******************************************************************************
+*/
+uint8_t *spiDmaRxData(void)
+{
+  return(&spi_dma_rx[4]);
 }
 
 /** @}*/
@@ -819,6 +819,13 @@ void printDiagnosticTestResult(uint8_t tIC, cell_asic *IC, DIAGNOSTIC_TYPE type)
       pc.printf("IC%d:",(ic+1));
       diagnosticTestResultPrint(IC[ic].diag_result.supply_error);
     }
+    pc.printf("\n");
+    pc.printf("Force Supply OV Detection Test:\n");
+    for(uint8_t ic = 0; ic < tIC; ic++)
+    {
+      pc.printf("IC%d:",(ic+1));
+      diagnosticTestResultPrint(IC[ic].diag_result.supply_ovuv);
+    }
     pc.printf("\n\n");
   }
 
@@ -865,6 +872,17 @@ void printDiagnosticTestResult(uint8_t tIC, cell_asic *IC, DIAGNOSTIC_TYPE type)
     }
     pc.printf("\n\n");
   }
+
+  else if(type == CS_FLT)
+  {
+    pc.printf("CSFLT Latent Fault Test:\n");
+    for(uint8_t ic = 0; ic < tIC; ic++)
+    {
+      pc.printf("IC%d:",(ic+1));
+      diagnosticTestResultPrint(IC[ic].diag_result.cs_flt);
+    }
+    pc.printf("\n\n");
+  }
   else{pc.printf("Wrong Diagnostic Selected\n");}
 }
 
@@ -990,15 +1008,20 @@ void openWireResultPrint(uint8_t result)
  * Function: printPollAdcConvTime
  * @brief Print Poll adc conversion Time.
  *
- * @details This function print poll adc conversion Time.
+ * @details This function print the measured conversion time statistics of
+ *          the converter (last, min and max).
+ *
+ * @param [in]  conv    Converter
  *
  * @return None
  *
  *******************************************************************************
 */
-void printPollAdcConvTime(int count)
+void printPollAdcConvTime(ADC_CONV conv)
 {
-  pc.printf("Adc Conversion Time = %fms\n", (float)(count/1000.0));
+  const adc_conv_stats_ *stats = adBmsAdcStats(conv);
+  pc.printf("Adc Conversion Time = %fms (min %fms, max %fms, %lu probes)\n", (float)(stats->last_us/1000.0),
+         (float)(stats->min_us/1000.0), (float)(stats->max_us/1000.0), (unsigned long)stats->probe_count);
 }
 
 /**
@@ -1035,6 +1058,17 @@ void printMenu()
   pc.printf("Clear Aux registers: 18              \n");
   pc.printf("Clear Spin registers: 19             \n");
   pc.printf("Clear Fcell registers: 20            \n");
+  pc.printf("Cell Open Wire Test: 21             \n");
+  pc.printf("Redundant Cell Open Wire Test: 22   \n");
+  pc.printf("Aux Open Wire Test: 23              \n");
+  pc.printf("Osc Mismatch Self Test: 24          \n");
+  pc.printf("Thermal Shutdown Self Test: 25      \n");
+  pc.printf("Supply Error Self Test: 26          \n");
+  pc.printf("Fuse ED Self Test: 27               \n");
+  pc.printf("Fuse MED Self Test: 28              \n");
+  pc.printf("TMODCHK Self Test: 29               \n");
+  pc.printf("CSFLT Latent Fault Test: 30         \n");
+  pc.printf("RDSTATC ERR Bit Test: 31            \n");
   pc.printf("\n");
   pc.printf("Print '0' for menu\n");
   pc.printf("Please enter command: \n");
@@ -1840,6 +1874,13 @@ void printDiagnosticTestResult(uint8_t tIC, cell_asic *IC, DIAGNOSTIC_TYPE type)
       printf("IC%d:",(ic+1));
       diagnosticTestResultPrint(IC[ic].diag_result.supply_error);
     }
+    printf("\n");
+    printf("Force Supply OV Detection Test:\n");
+    for(uint8_t ic = 0; ic < tIC; ic++)
+    {
+      printf("IC%d:",(ic+1));
+      diagnosticTestResultPrint(IC[ic].diag_result.supply_ovuv);
+    }
     printf("\n\n");
   }
 
@@ -1886,6 +1927,17 @@ void printDiagnosticTestResult(uint8_t tIC, cell_asic *IC, DIAGNOSTIC_TYPE type)
     }
     printf("\n\n");
   }
+
+  else if(type == CS_FLT)
+  {
+    printf("CSFLT Latent Fault Test:\n");
+    for(uint8_t ic = 0; ic < tIC; ic++)
+    {
+      printf("IC%d:",(ic+1));
+      diagnosticTestResultPrint(IC[ic].diag_result.cs_flt);
+    }
+    printf("\n\n");
+  }
   else{printf("Wrong Diagnostic Selected\n");}
 }
 
@@ -2011,15 +2063,20 @@ void openWireResultPrint(uint8_t result)
  * Function: printPollAdcConvTime
  * @brief Print Poll adc conversion Time.
  *
- * @details This function print poll adc conversion Time.
+ * @details This function print the measured conversion time statistics of
+ *          the converter (last, min and max).
+ *
+ * @param [in]  conv    Converter
  *
  * @return None
  *
  *******************************************************************************
 */
-void printPollAdcConvTime(int count)
+void printPollAdcConvTime(ADC_CONV conv)
 {
-  printf("Adc Conversion Time = %fms\n", (float)(count/64000.0));
+  const adc_conv_stats_ *stats = adBmsAdcStats(conv);
+  printf("Adc Conversion Time = %fms (min %fms, max %fms, %lu probes)\n", (float)(stats->last_us/1000.0),
+         (float)(stats->min_us/1000.0), (float)(stats->max_us/1000.0), (unsigned long)stats->probe_count);
 }
 
 /**
@@ -2056,6 +2113,17 @@ void printMenu()
   printf("Clear Aux registers: 18 \n");
   printf("Clear Spin registers: 19 \n");
   printf("Clear Fcell registers: 20 \n");
+  printf("Cell Open Wire Test: 21 \n");
+  printf("Redundant Cell Open Wire Test: 22 \n");
+  printf("Aux Open Wire Test: 23 \n");
+  printf("Osc Mismatch Self Test: 24 \n");
+  printf("Thermal Shutdown Self Test: 25 \n");
+  printf("Supply Error Self Test: 26 \n");
+  printf("Fuse ED Self Test: 27 \n");
+  printf("Fuse MED Self Test: 28 \n");
+  printf("TMODCHK Self Test: 29 \n");
+  printf("CSFLT Latent Fault Test: 30 \n");
+  printf("RDSTATC ERR Bit Test: 31 \n");
 
   printf("\n");
   printf("Print '0' for menu\n");
@@ -2081,7 +2149,7 @@ void printMenu()
 float getVoltage(int data)
 {
     float voltage_float; //voltage in Volts
-    voltage_float = ((data + 10000) * 0.000150);
+    voltage_float = (CODE_TO_UV(data) / 1000000.0f);
     return voltage_float;
 }
 
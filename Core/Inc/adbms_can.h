@@ -0,0 +1,31 @@
+#ifndef ADBMS_CAN_H
+#define ADBMS_CAN_H
+
+#include "adbms_sched.h"
+#include "adbms_update_values.h"
+
+// data can frames, 8 byte payload, little endian
+#define ADBMS_CAN_ID_VOLTAGE 0x600 // pack 0.1 V, max/min/avg cell mV
+#define ADBMS_CAN_ID_TEMP 0x601    // max/min/avg ntc, die, all 0.01 degC
+#define ADBMS_CAN_ID_CELL 0x610    // + n: cells 4n..4n+3 in mV
+#define ADBMS_CAN_CELLS_PER_FRAME 4
+#define ADBMS_CAN_CELL_FRAMES ((MAX_IC * CELL) / ADBMS_CAN_CELLS_PER_FRAME) // 0x610..0x64f at 16 ics
+#define ADBMS_CAN_ID_SELFTEST 0x660 // + test: fail ic mask, age s, runs, failed runs
+#define ADBMS_CAN_ID_DEADLINE 0x6A0       // + group: budget overruns, release overruns, max/budget us
+#define ADBMS_CAN_ID_DEADLINE_WORST 0x6AF // group, fsm state, run us, tick s, escalations
+#define ADBMS_CAN_ID_PROFILE_REQ 0x680 // received: dump the profile table
+#define ADBMS_CAN_ID_PROFILE 0x690     // + scope: count, min/mean/max us
+
+void ADBMS_CanPackVoltage(const adbms_ *adbms, uint8_t data[8]);
+void ADBMS_CanPackTemp(const adbms_ *adbms, uint8_t data[8]);
+uint8_t ADBMS_CanPackCells(const adbms_ *adbms, uint16_t frame, uint8_t data[8]);
+uint8_t ADBMS_CanPackSelfTest(uint16_t test, uint8_t data[8]);
+uint16_t ADBMS_FormatSelfTest(char *buf, uint16_t size);
+void ADBMS_CanPackDeadline(const sched_group_ *group, uint8_t data[8]);
+void ADBMS_CanPackDeadlineWorst(uint8_t data[8]);
+#if PROFILE_ENABLE
+uint8_t ADBMS_CanPackProfile(uint16_t scope, uint32_t core_hz, uint8_t data[8]);
+uint16_t ADBMS_FormatProfile(char *buf, uint16_t size, uint32_t core_hz);
+#endif
+
+#endif
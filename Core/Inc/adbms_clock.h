@@ -0,0 +1,38 @@
+#ifndef ADBMS_CLOCK_H
+#define ADBMS_CLOCK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// clock profiles. full: 168 MHz from the hse pll, low: 16 MHz hsi. the pll
+// keeps running in both, usb takes its 48 MHz from pll q
+typedef enum
+{
+    CLOCK_FULL = 0,
+    CLOCK_LOW,
+    CLOCK_PROFILE_COUNT
+} clock_profile_;
+
+// bus limits the peripherals are rescaled to on every switch
+#define ADBMS_CLOCK_SPI_MAX_HZ 8000000u // isospi sck, the rate the board was brought up with
+#define ADBMS_CLOCK_CAN_BIT_NS 3000u    // 333.3 kbit/s on both buses
+#define ADBMS_CLOCK_TIM_TICK_HZ 1000000u // TIM2 timebase and TIM3 scheduler count, 1 us
+#define ADBMS_CLOCK_CAN_WAIT_MS 10u      // wait for the can mailboxes, then abort what is left
+
+typedef struct
+{
+    uint16_t prescaler;
+    uint8_t bs1; // time quanta, sync segment not included
+    uint8_t bs2;
+} can_timing_;
+
+uint16_t ADBMS_ClockSpiDivider(uint32_t pclk_hz, uint32_t max_hz);
+bool ADBMS_ClockCanTiming(uint32_t pclk_hz, uint32_t bit_ns, can_timing_ *timing);
+
+void ADBMS_ClockRequest(clock_profile_ profile);
+bool ADBMS_ClockService(void);
+clock_profile_ ADBMS_ClockProfile(void);
+uint32_t ADBMS_ClockSwitchCount(void);
+uint32_t ADBMS_ClockAbortCount(void); // can buses aborted to let a switch through
+
+#endif
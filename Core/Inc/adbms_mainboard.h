@@ -1,8 +1,12 @@
+#ifndef ADBMS_MAINBOARD_H
+#define ADBMS_MAINBOARD_H
+
 #include "adBms_Application.h"
 #include "adbms_update_values.h"
+#include "adbms_can.h"
 #include "fsm.h"
 
-fsm_t *g_fsm;
+extern fsm_t *g_fsm;
 
 typedef struct fsm_context
 {
@@ -12,4 +16,9 @@ typedef struct fsm_context
 // placeholder
 
 void adbms_mainboard_setup();
-void adbms_mainboard_loop();
\ No newline at end of file
+void adbms_mainboard_loop();
+#if PROFILE_ENABLE
+void adbms_mainboard_profile_request(void);
+#endif
+
+#endif
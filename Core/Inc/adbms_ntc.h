@@ -0,0 +1,32 @@
+#ifndef ADBMS_NTC_H
+#define ADBMS_NTC_H
+
+#include <stdint.h>
+
+// thermistor reading state
+typedef enum
+{
+    NTC_OK = 0,
+    NTC_LOW,   // colder than the table, clamped to its first temperature
+    NTC_HIGH,  // hotter than the table, clamped to its last temperature
+    NTC_OPEN,  // gpio at vref2: sensor or wire open
+    NTC_SHORT, // gpio at ground: sensor or wire shorted
+} ntc_state_;
+
+// divider ratio table of one sensor type, ntc to ground with a pull-up to vref2
+typedef struct
+{
+    const uint16_t *ratio; // gpio / vref2 in Q16 at each table temperature, falling
+    uint8_t count;         // table entries
+    int16_t first_cdeg;    // temperature of ratio[0]
+    int16_t step_cdeg;     // temperature step between entries
+    uint16_t open_ratio;   // at or above: open
+    uint16_t short_ratio;  // at or below: short
+} ntc_type_;
+
+extern const ntc_type_ NTC_10K_PU10K;
+
+uint16_t NTC_Ratio(int32_t gpio_uv, int32_t vref2_uv);
+ntc_state_ NTC_ToCentiDeg(const ntc_type_ *type, uint16_t ratio, int16_t *cdeg);
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef ADBMS_SCHED_H
+#define ADBMS_SCHED_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// rate group scheduler: a timer interrupt calls ADBMS_SchedTick once per tick
+// and releases the groups due, the main loop runs them with
+// ADBMS_SchedRunNext. no hal dependency, tests/test_sched.c drives the tick
+// by hand
+
+typedef void (*sched_task_)(void);
+
+// deadline monitor, optional. run times are measured with now_us and checked
+// against each group's budget; the tick checks that group 0 keeps starting
+typedef struct
+{
+    uint32_t (*now_us)(void);   // free running us clock
+    uint32_t (*tag)(void);      // recorded with the worst budget overrun, e.g. the fsm state
+    uint32_t loop_limit;        // ticks group 0 may go without starting, 0 = no limit
+    void (*escalate)(void);     // called from the tick once the limit is hit
+} sched_monitor_;
+
+// longest budget overrun so far
+typedef struct
+{
+    uint8_t group;
+    uint32_t exec_us;
+    uint32_t tick;
+    uint32_t tag;
+} sched_worst_;
+
+typedef struct
+{
+    const char *name;
+    sched_task_ task;
+    uint16_t period; // ticks between releases
+    uint16_t phase;  // release tick modulo period, spreads groups over ticks
+    uint32_t budget_us; // worst case run time, 0 = not checked
+
+    // written by the scheduler
+    volatile uint8_t pending; // released, not started yet
+    volatile uint8_t running;
+    volatile uint32_t release_tick;
+    uint32_t run_count;
+    uint32_t overrun_count; // releases dropped, the previous one had not finished
+    uint32_t max_lag;       // most ticks from release to start
+    uint32_t start_tick;
+    uint32_t exec_max_us;          // with a monitor only
+    uint32_t budget_overrun_count; // runs longer than budget_us
+    uint32_t budget_overrun_tick;  // tick of the last one
+} sched_group_;
+
+bool ADBMS_SchedInit(sched_group_ *groups, uint8_t count);
+bool ADBMS_SchedPhasesOk(const sched_group_ *groups, uint8_t count);
+void ADBMS_SchedMonitor(const sched_monitor_ *monitor);
+void ADBMS_SchedTick(void);
+bool ADBMS_SchedRunNext(void);
+uint32_t ADBMS_SchedNow(void);
+const sched_worst_ *ADBMS_SchedWorst(void);
+uint32_t ADBMS_SchedEscalations(void);
+
+#endif
@@ -1,36 +1,67 @@
+#ifndef ADBMS_UPDATE_VALUES_H
+#define ADBMS_UPDATE_VALUES_H
+
 #include "adBms6830CmdList.h"
 #include "adBms6830GenericType.h"
+#include "adbms_ntc.h"
+
+// thermistors on GPIO1-GPIO10, aux codes 0..9 of each ic
+#define NTC_FIRST 0
+#define NTC_COUNT 10
+
+// fault bits of adbms_.faults
+#define ADBMS_FAULT_OV 0x01 // a cell above OV_THRESHOLD, or the ic flagged it
+#define ADBMS_FAULT_UV 0x02 // a cell below UV_THRESHOLD, or the ic flagged it
+#define ADBMS_FAULT_NTC 0x04 // a thermistor open, shorted or off its table
+#define ADBMS_FAULT_COMM 0x08 // an ic keeps failing its reads, its codes are stale
+#define ADBMS_FAULT_OW 0x10 // open cell sense or gpio wire
+#define ADBMS_FAULT_SELFTEST 0x20 // an ic failed a latent fault self test
+#define ADBMS_FAULT_CS 0x40 // c-adc and s-adc disagree on a cell
+#define ADBMS_FAULT_DEADLINE 0x80 // the fault path missed its hard deadline, latched
 
-const float OV_THRESHOLD = 4.2;  /* Volt */
-const float UV_THRESHOLD = 3.0;  /* Volt */
-const int OWC_Threshold = 2000;  /* Cell Open wire threshold(mili volt) */
-const int OWA_Threshold = 50000; /* Aux Open wire threshold(mili volt) */
-OW_C_S CELL_OPEN_WIRE_DETECTION = OW_ON_ALL_CH;
-OW_AUX AUX_OPEN_WIRE_DETECTION = AUX_OW_ON;
-CH AUX_CH_TO_CONVERT = AUX_ALL;
-PUP OPEN_WIRE_CURRENT_SOURCE = PUP_UP;
 typedef struct
 {
     uint8_t TOTAL_IC;
     cell_asic *IC;
+    pack_store_ *pack; // dense per-pack codes, written by the driver on every read
 } cell;
 
+// all values are fixed point: voltages in uV, temperatures in 0.01 degC
 typedef struct
 {
     cell system;
-    float total_v;
-    float max_v;
-    float min_v;
-    float avg_v;
-
-    float total_temp;
-    float max_temp;
-    float min_temp;
-    float avg_temp;
+    int32_t total_uv; // sum of all cells, fits int32 up to MAX_IC * CELL cells of 5 V
+    int32_t max_uv;
+    int32_t min_uv;
+    int32_t avg_uv;
+    uint16_t min_v_cell; // pack cell index (ic * CELL + cell) of min_uv
+    uint16_t max_v_cell; // pack cell index of max_uv
+    uint32_t cell_read;  // bit per ic, cells read good since init; OV/UV wait for all
+
+    // thermistor temperatures (GPIO1-GPIO10), index ic * NTC_COUNT + channel
+    int16_t temp_cdeg[MAX_IC * NTC_COUNT]; // clamped to the table on a bad sensor
+    uint16_t ntc_bad[MAX_IC];              // bit per channel, state not NTC_OK
+    int16_t max_temp;
+    int16_t min_temp;
+    int16_t avg_temp;
+    uint16_t min_temp_ch; // thermistor index of min_temp
+    uint16_t max_temp_ch; // thermistor index of max_temp
+
+    int16_t max_die_cdeg; // hottest ic die temperature
+
+    uint8_t faults; // ADBMS_FAULT_x
+
+    // running statistics, only ics read since the last tick are recomputed
+    pack_stats_ cell_stats;
+    pack_stats_ temp_stats;
 } adbms_;
 
+// returns a chain with no ics (IC NULL) when ic_count is 0 or above MAX_IC
 cell ADBMS_Initialize(uint8_t ic_count);
 
 void ADBMS_UpdateValues(adbms_ *adbms);
 void ADBMS_CalculateValues(adbms_ *adbms);
-void ADBMS_delete(adbms_ *adbms);
\ No newline at end of file
+uint8_t ADBMS_CheckFaults(adbms_ *adbms);
+void ADBMS_delete(adbms_ *adbms);
+
+#endif
@@ -0,0 +1,223 @@
+#include "adbms_can.h"
+#include <stdio.h>
+
+// the id blocks sent on hcan1 must stay apart at the longest chain
+_Static_assert(ADBMS_CAN_ID_CELL + ADBMS_CAN_CELL_FRAMES <= ADBMS_CAN_ID_SELFTEST, "cell frames run into the self test ids");
+_Static_assert(ADBMS_CAN_ID_SELFTEST + ST_NB <= ADBMS_CAN_ID_PROFILE_REQ, "self test frames run into the profile ids");
+_Static_assert(ADBMS_CAN_ID_PROFILE + PROF_NB <= ADBMS_CAN_ID_DEADLINE, "profile frames run into the deadline ids");
+_Static_assert(MAX_IC <= 16, "self test frames carry a 16 bit fail ic mask");
+
+// values are already fixed point, packing only rescales with integer divides
+
+static void put_u16(uint8_t *data, uint16_t value)
+{
+    data[0] = (uint8_t)value;
+    data[1] = (uint8_t)(value >> 8);
+}
+
+static uint16_t uv_to_mv(int32_t uv)
+{
+    // cell voltages are always positive, clamp a bad code to 0
+    return (uv > 0) ? (uint16_t)(uv / 1000) : 0;
+}
+
+void ADBMS_CanPackVoltage(const adbms_ *adbms, uint8_t data[8])
+{
+    PROF_BEGIN(PROF_CAN_PACK);
+    put_u16(&data[0], (adbms->total_uv > 0) ? (uint16_t)(adbms->total_uv / 100000) : 0);
+    put_u16(&data[2], uv_to_mv(adbms->max_uv));
+    put_u16(&data[4], uv_to_mv(adbms->min_uv));
+    put_u16(&data[6], uv_to_mv(adbms->avg_uv));
+    PROF_END(PROF_CAN_PACK);
+}
+
+void ADBMS_CanPackTemp(const adbms_ *adbms, uint8_t data[8])
+{
+    PROF_BEGIN(PROF_CAN_PACK);
+    put_u16(&data[0], (uint16_t)adbms->max_temp);
+    put_u16(&data[2], (uint16_t)adbms->min_temp);
+    put_u16(&data[4], (uint16_t)adbms->avg_temp);
+    put_u16(&data[6], (uint16_t)adbms->max_die_cdeg);
+    PROF_END(PROF_CAN_PACK);
+}
+
+// packs frame n of the per cell stream straight from the dense code array,
+// returns the number of cells packed (0 past the last cell)
+uint8_t ADBMS_CanPackCells(const adbms_ *adbms, uint16_t frame, uint8_t data[8])
+{
+    const int16_t *code = adbms->system.pack->cell;
+    const int cell_count = adbms->system.TOTAL_IC * CELL;
+    int first = frame * ADBMS_CAN_CELLS_PER_FRAME;
+    uint8_t count = 0;
+
+    PROF_BEGIN(PROF_CAN_PACK);
+    memset(data, 0, 8);
+    for (int i = first; (i < cell_count) && (count < ADBMS_CAN_CELLS_PER_FRAME); i++, count++)
+    {
+        put_u16(&data[count * 2], uv_to_mv(CODE_TO_UV(code[i])));
+    }
+    PROF_END(PROF_CAN_PACK);
+    return count;
+}
+
+static uint16_t sat_u16(uint32_t value)
+{
+    return (value > 0xFFFF) ? 0xFFFF : (uint16_t)value;
+}
+
+// result of self test n, age in s (0xFFFF never run), returns 0 past the
+// last test
+uint8_t ADBMS_CanPackSelfTest(uint16_t test, uint8_t data[8])
+{
+    const st_result_ *result;
+    uint32_t age;
+
+    memset(data, 0, 8);
+    if (test >= ST_NB)
+    {
+        return 0;
+    }
+    result = adBmsStResult((ST_TEST)test);
+    age = adBmsStAgeMs((ST_TEST)test);
+    put_u16(&data[0], (uint16_t)result->fail_mask);
+    put_u16(&data[2], (age == ST_AGE_NEVER) ? 0xFFFF : sat_u16(age / 1000));
+    put_u16(&data[4], sat_u16(result->run_count));
+    put_u16(&data[6], sat_u16(result->fail_count));
+    return 1;
+}
+
+// deadline counters of one rate group, all saturated to 16 bit
+void ADBMS_CanPackDeadline(const sched_group_ *group, uint8_t data[8])
+{
+    put_u16(&data[0], sat_u16(group->budget_overrun_count));
+    put_u16(&data[2], sat_u16(group->overrun_count));
+    put_u16(&data[4], sat_u16(group->exec_max_us));
+    put_u16(&data[6], sat_u16(group->budget_us));
+}
+
+// longest run over budget: group, fsm state, run time, when, and how often
+// the loop limit escalated
+void ADBMS_CanPackDeadlineWorst(uint8_t data[8])
+{
+    const sched_worst_ *worst = ADBMS_SchedWorst();
+
+    data[0] = worst->group;
+    data[1] = (uint8_t)worst->tag;
+    put_u16(&data[2], sat_u16(worst->exec_us));
+    put_u16(&data[4], sat_u16(worst->tick / 1000)); // 1 ms ticks
+    put_u16(&data[6], sat_u16(ADBMS_SchedEscalations()));
+}
+
+// same report as text for the usb cdc link, one line per test, returns the
+// length written (truncated to size)
+uint16_t ADBMS_FormatSelfTest(char *buf, uint16_t size)
+{
+    static const char *const NAME[ST_NB] = {"osc", "thsd", "supply_uv", "supply_ov",
+                                            "fuse_ed", "fuse_med", "tmodchk", "csflt"};
+    uint16_t len = 0;
+    uint32_t age;
+    int n;
+
+    if (size == 0)
+    {
+        return 0;
+    }
+    buf[0] = '\0';
+    for (int test = 0; test < ST_NB; test++)
+    {
+        age = adBmsStAgeMs((ST_TEST)test);
+        if (age == ST_AGE_NEVER)
+        {
+            n = snprintf(&buf[len], size - len, "%s: never run\r\n", NAME[test]);
+        }
+        else
+        {
+            n = snprintf(&buf[len], size - len, "%s: %s fail 0x%04lx age %lu ms\r\n", NAME[test],
+                         (adBmsStResult((ST_TEST)test)->fail_mask != 0) ? "FAIL" : "PASS",
+                         (unsigned long)adBmsStResult((ST_TEST)test)->fail_mask, (unsigned long)age);
+        }
+        if ((n < 0) || (n >= (size - len)))
+        {
+            return (uint16_t)(size - 1);
+        }
+        len += (uint16_t)n;
+    }
+    return len;
+}
+
+#if PROFILE_ENABLE
+// scope n durations in us at core_hz: count, min, mean, max, all saturated
+// to 16 bit, returns 0 past the last scope
+uint8_t ADBMS_CanPackProfile(uint16_t scope, uint32_t core_hz, uint8_t data[8])
+{
+    const prof_scope_ *p;
+    uint32_t per_us = core_hz / 1000000;
+
+    memset(data, 0, 8);
+    if ((scope >= PROF_NB) || (per_us == 0))
+    {
+        return 0;
+    }
+    p = adBmsProfScope((PROF_SCOPE)scope);
+    put_u16(&data[0], sat_u16(p->count));
+    put_u16(&data[2], sat_u16(p->min / per_us));
+    put_u16(&data[4], sat_u16(adBmsProfMean((PROF_SCOPE)scope) / per_us));
+    put_u16(&data[6], sat_u16(p->max / per_us));
+    return 1;
+}
+
+// adds the n chars snprintf just wrote at buf[*len], false once the text
+// no longer fits
+static bool advance(int n, uint16_t size, uint16_t *len)
+{
+    if ((n < 0) || (n >= (size - *len)))
+    {
+        return false;
+    }
+    *len += (uint16_t)n;
+    return true;
+}
+
+// scope table as text, cycles plus the non empty log2 histogram bins
+// ("b:n" = n scopes of 2^b to 2^(b+1)-1 cycles), returns the length written
+// (truncated to size)
+uint16_t ADBMS_FormatProfile(char *buf, uint16_t size, uint32_t core_hz)
+{
+    const prof_scope_ *p;
+    uint16_t len = 0;
+
+    if (size == 0)
+    {
+        return 0;
+    }
+    buf[0] = '\0';
+    if (!advance(snprintf(buf, size, "profile, cycles at %lu Hz\r\n", (unsigned long)core_hz), size, &len))
+    {
+        return (uint16_t)(size - 1);
+    }
+    for (int scope = 0; scope < PROF_NB; scope++)
+    {
+        p = adBmsProfScope((PROF_SCOPE)scope);
+        if (!advance(snprintf(&buf[len], size - len, "%s: n %lu min %lu mean %lu max %lu |",
+                              adBmsProfName((PROF_SCOPE)scope), (unsigned long)p->count, (unsigned long)p->min,
+                              (unsigned long)adBmsProfMean((PROF_SCOPE)scope), (unsigned long)p->max),
+                     size, &len))
+        {
+            return (uint16_t)(size - 1);
+        }
+        for (int bin = 0; bin < PROF_HIST_BINS; bin++)
+        {
+            if ((p->hist[bin] != 0) &&
+                !advance(snprintf(&buf[len], size - len, " %d:%lu", bin, (unsigned long)p->hist[bin]), size, &len))
+            {
+                return (uint16_t)(size - 1);
+            }
+        }
+        if (!advance(snprintf(&buf[len], size - len, "\r\n"), size, &len))
+        {
+            return (uint16_t)(size - 1);
+        }
+    }
+    return len;
+}
+#endif
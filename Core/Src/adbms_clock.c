@@ -0,0 +1,259 @@
+#include "adbms_clock.h"
+#include "main.h"
+#include "mcuWrapper.h"
+
+extern CAN_HandleTypeDef hcan1;
+extern CAN_HandleTypeDef hcan2;
+extern SPI_HandleTypeDef hspi1;
+extern TIM_HandleTypeDef htim2;
+extern TIM_HandleTypeDef htim3;
+
+typedef struct
+{
+    uint32_t sysclk_source;
+    uint32_t apb1_div; // RCC_HCLK_DIVx
+    uint32_t apb2_div;
+    uint32_t flash_latency;
+    bool prefetch; // the prefetch buffer only pays off with wait states
+} clock_cfg_;
+
+// SystemClock_Config boots into CLOCK_FULL. the pll is not touched here:
+// 25 MHz hse / 25 * 336 / 2 = 168 MHz, / 7 = 48 MHz for usb.
+// full: ahb 168, apb1 42 (timers 84), apb2 84 MHz, 5 wait states at 3.3 V
+// low: ahb = apb1 = apb2 = 16 MHz hsi, 0 wait states
+static const clock_cfg_ clock_cfg[CLOCK_PROFILE_COUNT] = {
+    [CLOCK_FULL] = {RCC_SYSCLKSOURCE_PLLCLK, RCC_HCLK_DIV4, RCC_HCLK_DIV2, FLASH_LATENCY_5, true},
+    [CLOCK_LOW] = {RCC_SYSCLKSOURCE_HSI, RCC_HCLK_DIV1, RCC_HCLK_DIV1, FLASH_LATENCY_0, false},
+};
+
+static const uint32_t spi_br[8] = {
+    SPI_BAUDRATEPRESCALER_2,  SPI_BAUDRATEPRESCALER_4,  SPI_BAUDRATEPRESCALER_8,   SPI_BAUDRATEPRESCALER_16,
+    SPI_BAUDRATEPRESCALER_32, SPI_BAUDRATEPRESCALER_64, SPI_BAUDRATEPRESCALER_128, SPI_BAUDRATEPRESCALER_256,
+};
+
+static clock_profile_ clock_current = CLOCK_FULL;
+static volatile clock_profile_ clock_requested = CLOCK_FULL;
+static uint32_t clock_switch_count;
+static bool clock_waiting;       // switch requested, waiting for the buses
+static uint32_t clock_wait_start; // HAL_GetTick when the wait began
+static uint32_t clock_abort_count;
+
+// smallest spi divider (2..256) keeping sck at or below max_hz, 0 if none does
+uint16_t ADBMS_ClockSpiDivider(uint32_t pclk_hz, uint32_t max_hz)
+{
+    for (uint16_t div = 2; div <= 256; div *= 2)
+    {
+        if ((pclk_hz / div) <= max_hz)
+        {
+            return div;
+        }
+    }
+    return 0;
+}
+
+// exact bit time with the most time quanta (16 down to 8), sample point near
+// 87.5 %. false when pclk gives no exact bit time
+bool ADBMS_ClockCanTiming(uint32_t pclk_hz, uint32_t bit_ns, can_timing_ *timing)
+{
+    uint64_t clocks_ns = (uint64_t)pclk_hz * bit_ns;
+    if ((clocks_ns % 1000000000u) != 0)
+    {
+        return false;
+    }
+    uint32_t clocks = (uint32_t)(clocks_ns / 1000000000u);
+    for (uint8_t tq = 16; tq >= 8; tq--)
+    {
+        if (((clocks % tq) != 0) || ((clocks / tq) > 1024))
+        {
+            continue;
+        }
+        timing->prescaler = (uint16_t)(clocks / tq);
+        timing->bs2 = (uint8_t)((tq + 4) / 8);
+        timing->bs1 = (uint8_t)(tq - 1 - timing->bs2);
+        return true;
+    }
+    return false;
+}
+
+// apb timers run at twice the bus clock when the bus is divided
+static uint32_t tim_clock(uint32_t pclk_hz, uint32_t apb_div)
+{
+    return (apb_div == RCC_HCLK_DIV1) ? pclk_hz : 2 * pclk_hz;
+}
+
+// new prescaler without losing the count: the prescaler only loads on an
+// update event, which also clears the counter. URS keeps the forced update
+// from raising the TIM3 interrupt
+static void tim_rescale(TIM_HandleTypeDef *htim, uint32_t tim_hz)
+{
+    uint32_t psc = (tim_hz / ADBMS_CLOCK_TIM_TICK_HZ) - 1;
+    uint32_t count = __HAL_TIM_GET_COUNTER(htim);
+
+    htim->Instance->CR1 |= TIM_CR1_URS;
+    __HAL_TIM_SET_PRESCALER(htim, psc);
+    htim->Instance->EGR = TIM_EGR_UG;
+    __HAL_TIM_SET_COUNTER(htim, count);
+    htim->Instance->CR1 &= ~TIM_CR1_URS;
+    htim->Init.Prescaler = psc;
+}
+
+static void can_rescale(CAN_HandleTypeDef *hcan, const can_timing_ *timing)
+{
+    bool started = (hcan->State == HAL_CAN_STATE_LISTENING);
+
+    if (started)
+    {
+        HAL_CAN_Stop(hcan);
+    }
+    hcan->Init.Prescaler = timing->prescaler;
+    hcan->Init.SyncJumpWidth = CAN_SJW_1TQ;
+    hcan->Init.TimeSeg1 = (uint32_t)(timing->bs1 - 1) << CAN_BTR_TS1_Pos;
+    hcan->Init.TimeSeg2 = (uint32_t)(timing->bs2 - 1) << CAN_BTR_TS2_Pos;
+    if (HAL_CAN_Init(hcan) != HAL_OK)
+    {
+        Error_Handler();
+    }
+    if (started)
+    {
+        HAL_CAN_Start(hcan);
+    }
+}
+
+static void spi_rescale(uint32_t pclk_hz)
+{
+    uint16_t div = ADBMS_ClockSpiDivider(pclk_hz, ADBMS_CLOCK_SPI_MAX_HZ);
+    uint8_t n = 0;
+
+    while ((2u << n) < div)
+    {
+        n++;
+    }
+    hspi1.Init.BaudRatePrescaler = spi_br[n];
+    if (HAL_SPI_Init(&hspi1) != HAL_OK)
+    {
+        Error_Handler();
+    }
+}
+
+static void clock_apply(clock_profile_ profile)
+{
+    const clock_cfg_ *cfg = &clock_cfg[profile];
+    RCC_ClkInitTypeDef clk = {0};
+    can_timing_ timing;
+    uint32_t primask;
+
+    // hal raises the wait states before a faster clock and lowers them
+    // after a slower one, and reloads systick
+    clk.ClockType = RCC_CLOCKTYPE_HCLK | RCC_CLOCKTYPE_SYSCLK | RCC_CLOCKTYPE_PCLK1 | RCC_CLOCKTYPE_PCLK2;
+    clk.SYSCLKSource = cfg->sysclk_source;
+    clk.AHBCLKDivider = RCC_SYSCLK_DIV1;
+    clk.APB1CLKDivider = cfg->apb1_div;
+    clk.APB2CLKDivider = cfg->apb2_div;
+    if (HAL_RCC_ClockConfig(&clk, cfg->flash_latency) != HAL_OK)
+    {
+        Error_Handler();
+    }
+    // the timers ran off scale for the few us since the switch
+    primask = __get_PRIMASK();
+    __disable_irq();
+    tim_rescale(&htim2, tim_clock(HAL_RCC_GetPCLK1Freq(), cfg->apb1_div));
+    tim_rescale(&htim3, tim_clock(HAL_RCC_GetPCLK1Freq(), cfg->apb1_div));
+    __set_PRIMASK(primask);
+
+    // instruction and data caches stay on in both profiles
+    if (cfg->prefetch)
+    {
+        __HAL_FLASH_PREFETCH_BUFFER_ENABLE();
+    }
+    else
+    {
+        __HAL_FLASH_PREFETCH_BUFFER_DISABLE();
+    }
+
+    spi_rescale(HAL_RCC_GetPCLK2Freq());
+    if (!ADBMS_ClockCanTiming(HAL_RCC_GetPCLK1Freq(), ADBMS_CLOCK_CAN_BIT_NS, &timing))
+    {
+        Error_Handler();
+    }
+    can_rescale(&hcan1, &timing);
+    can_rescale(&hcan2, &timing);
+
+    clock_current = profile;
+    clock_switch_count++;
+}
+
+// takes effect on the next ADBMS_ClockService, safe from any context
+void ADBMS_ClockRequest(clock_profile_ profile)
+{
+    if (profile < CLOCK_PROFILE_COUNT)
+    {
+        clock_requested = profile;
+    }
+}
+
+// a frame nobody acks stays in its mailbox for good. after the wait the
+// frames still queued are aborted, they would go out at the old bit time
+// anyway and the data is resent on the next release
+static bool can_idle(CAN_HandleTypeDef *hcan, bool abort)
+{
+    if (HAL_CAN_GetTxMailboxesFreeLevel(hcan) == 3)
+    {
+        return true;
+    }
+    if (abort)
+    {
+        HAL_CAN_AbortTxRequest(hcan, CAN_TX_MAILBOX0 | CAN_TX_MAILBOX1 | CAN_TX_MAILBOX2);
+        clock_abort_count++;
+    }
+    return false;
+}
+
+// main loop, between tasks. switches to the requested profile once no spi
+// dma transfer and no can frame is in flight, returns true when the clock
+// runs the requested profile
+bool ADBMS_ClockService(void)
+{
+    clock_profile_ profile = clock_requested;
+    bool abort, can1_idle, can2_idle;
+
+    if (profile == clock_current)
+    {
+        clock_waiting = false;
+        return true;
+    }
+    if (!clock_waiting)
+    {
+        clock_waiting = true;
+        clock_wait_start = HAL_GetTick();
+    }
+    if (spiDmaBusy())
+    {
+        return false;
+    }
+    abort = (HAL_GetTick() - clock_wait_start) >= ADBMS_CLOCK_CAN_WAIT_MS;
+    // both buses are checked every time so both get their frames aborted
+    can1_idle = can_idle(&hcan1, abort);
+    can2_idle = can_idle(&hcan2, abort);
+    if (!can1_idle || !can2_idle)
+    {
+        return false;
+    }
+    clock_waiting = false;
+    clock_apply(profile);
+    return true;
+}
+
+clock_profile_ ADBMS_ClockProfile(void)
+{
+    return clock_current;
+}
+
+uint32_t ADBMS_ClockSwitchCount(void)
+{
+    return clock_switch_count;
+}
+
+uint32_t ADBMS_ClockAbortCount(void)
+{
+    return clock_abort_count;
+}
@@ -1,63 +1,314 @@
 #include "adbms_mainboard.h"
+#include "adbms_clock.h"
+#include "adbms_sched.h"
+#include "usbd_cdc_if.h"
 #define FSM_IMPL
-adbms_ adbms;
+CCMRAM adbms_ adbms;
+fsm_t *g_fsm;
 
-void adbms_mainbaord_setup()
+extern CAN_HandleTypeDef hcan1; // data bus
+extern CAN_HandleTypeDef hcan2; // drive bus
+
+void UpdateValues();
+void CheckFaults();
+void data_can_loop();
+void drive_can_loop();
+static void fault_task(void);
+static void diag_task(void);
+
+// TIM3 ticks at 1 kHz. groups in priority order; phases are picked so no two
+// groups slower than 1 kHz are ever released on the same tick. budgets are
+// worst case run times at 168 MHz, a run over budget is counted. the table is
+// scheduler state, written on every tick, so it sits in ccm ram
+CCMRAM_DATA static sched_group_ groups[] = {
+    {"fault", fault_task, 1, 0, 200},       // 1 kHz fault path
+    {"acq", UpdateValues, 10, 1, 3000},     // 100 Hz acquisition, isospi reads and retries
+    {"drive", drive_can_loop, 10, 6, 200},  // 100 Hz drive can
+    {"data", data_can_loop, 100, 3, 500},   // 10 Hz data can
+    {"diag", diag_task, 1000, 8, 2000},     // 1 Hz diagnostics, usb text
+};
+#define GROUP_COUNT (sizeof(groups) / sizeof(groups[0]))
+_Static_assert(ADBMS_CAN_ID_DEADLINE + GROUP_COUNT <= ADBMS_CAN_ID_DEADLINE_WORST, "deadline frames run into the worst case id");
+
+// the fault path must start at least every DEADLINE_LOOP_LIMIT ticks, a
+// stuck main loop (blocking retry, wake delays) latches the deadline fault
+#define DEADLINE_LOOP_LIMIT 20
+static volatile bool deadline_fault;
+static uint32_t fsm_state_tag(void);
+static void deadline_escalate(void);
+static const sched_monitor_ monitor = {getTimUs, fsm_state_tag, DEADLINE_LOOP_LIMIT, deadline_escalate};
+
+static uint32_t can_drop_count; // frames dropped, no free tx mailbox
+// diag frames on the data bus, next one to send. diag_task starts a round,
+// data_can_loop streams it ahead of the cells
+#define DIAG_FRAME_IDLE 0xFFFF
+static uint16_t diag_frame = DIAG_FRAME_IDLE;
+#if PROFILE_ENABLE
+static volatile bool profile_dump; // set by a usb or can request, cleared by diag_task
+static bool diag_profile;          // the diag round carries the profile table
+#endif
+
+void adbms_mainboard_setup()
 {
     // initialize the contactors;
     // initialize ad chip;
 
-    // initialize CAN; // do later
-    // add the CAN to the timer group with a different timer (one for drive, one for data)
+    // initialize CAN
+#if PROFILE_ENABLE
+    // data bus: accept every frame into fifo 0, data_can_loop picks out the
+    // profile request
+    CAN_FilterTypeDef filter = {0};
+    filter.FilterBank = 0;
+    filter.FilterMode = CAN_FILTERMODE_IDMASK;
+    filter.FilterScale = CAN_FILTERSCALE_32BIT;
+    filter.FilterFIFOAssignment = CAN_RX_FIFO0;
+    filter.FilterActivation = ENABLE;
+    filter.SlaveStartFilterBank = 14;
+    HAL_CAN_ConfigFilter(&hcan1, &filter);
+    adBmsProfReset();
+#endif
+    HAL_CAN_Start(&hcan1);
+    HAL_CAN_Start(&hcan2);
     // initialize Charger; // do later
 
     // FMS Init
 
     adbms.system = ADBMS_Initialize(1);
+    if (adbms.system.IC == NULL)
+    {
+        Error_Handler(); // chain does not fit the driver buffers, nothing is monitored
+    }
     fsm_context_t context = {0};
     g_fsm = FSM_CREATE(&context);
     // FSMAddStates();
     // FSMAddTransitions();
 
-    // initialize the timer group with adbms_mainboard_loop
+    // the timer only releases groups once the table is set up
+    if (!ADBMS_SchedInit(groups, GROUP_COUNT))
+    {
+        Error_Handler();
+    }
+    ADBMS_SchedMonitor(&monitor);
+}
+
+// fsm state index for the deadline record, 0xFF before any state is added.
+// fields read directly: the fsm.h accessors are plain inline, no external
+// definition to link against at -O0
+static uint32_t fsm_state_tag(void)
+{
+    return (g_fsm->__state_count != 0) ? (uint32_t)g_fsm->__current_state_idx : 0xFF;
+}
+
+// tick interrupt, the main loop is stuck: the fault path cannot run, so the
+// safe state is taken from here
+static void deadline_escalate(void)
+{
+    deadline_fault = true;
+    // open (turn off) all contactors;
 }
 
-// Loop that gets ticked
+#if PROFILE_ENABLE
+// usb or can request, the table goes out with the next diag_task
+void adbms_mainboard_profile_request(void)
+{
+    profile_dump = true;
+}
+#endif
+
+// main loop: run the released groups, highest rate first. a clock profile
+// switch waits for a gap between tasks with the buses idle
 void adbms_mainboard_loop()
+{
+    ADBMS_ClockService();
+    ADBMS_SchedRunNext();
+}
+
+static void fault_task(void)
 {
     // feed watchdog;
-    UpdateValues();
     CheckFaults();
-    fsm_run();
+    PROF_BEGIN(PROF_FSM_RUN);
+    fsm_run(g_fsm);
+    PROF_END(PROF_FSM_RUN);
 }
 
 void UpdateValues()
 {
     // ADBMS values
-    ADBMS_UpdateValues();
-    ADBMS_CalculateValues();
+    PROF_BEGIN(PROF_UPDATE_VALUES);
+    ADBMS_UpdateValues(&adbms);
+    PROF_END(PROF_UPDATE_VALUES);
+    PROF_BEGIN(PROF_CALC_VALUES);
+    ADBMS_CalculateValues(&adbms);
+    PROF_END(PROF_CALC_VALUES);
     // update STM32 Pin values;
     // reads: shutdown_contactors, IMD_Status, Current_ADC, 6822_State
     // writes: BMS_Status, GPIO_LEDs
 }
 
-// CAN Loops - Do later
+// CAN Loops, never wait for a mailbox: a frame that does not fit is dropped
+// and counted, the next release sends fresh values
+static bool can_send(CAN_HandleTypeDef *hcan, uint16_t id, const uint8_t data[8])
+{
+    CAN_TxHeaderTypeDef header = {0};
+    uint32_t mailbox;
+
+    if (HAL_CAN_GetTxMailboxesFreeLevel(hcan) == 0)
+    {
+        can_drop_count++;
+        return false;
+    }
+    header.StdId = id;
+    header.IDE = CAN_ID_STD;
+    header.RTR = CAN_RTR_DATA;
+    header.DLC = 8;
+    return HAL_CAN_AddTxMessage(hcan, &header, (uint8_t *)data, &mailbox) == HAL_OK;
+}
+
+// frame k of a diag round: self tests, deadline per group, worst case and
+// on request the profile table. false past the last frame
+static bool diag_frame_pack(uint16_t k, uint16_t *id, uint8_t data[8])
+{
+    if (k < ST_NB)
+    {
+        ADBMS_CanPackSelfTest(k, data);
+        *id = ADBMS_CAN_ID_SELFTEST + k;
+        return true;
+    }
+    k -= ST_NB;
+    if (k < GROUP_COUNT)
+    {
+        ADBMS_CanPackDeadline(&groups[k], data);
+        *id = ADBMS_CAN_ID_DEADLINE + k;
+        return true;
+    }
+    if (k == GROUP_COUNT)
+    {
+        ADBMS_CanPackDeadlineWorst(data);
+        *id = ADBMS_CAN_ID_DEADLINE_WORST;
+        return true;
+    }
+#if PROFILE_ENABLE
+    k -= GROUP_COUNT + 1;
+    if (diag_profile && (ADBMS_CanPackProfile(k, HAL_RCC_GetHCLKFreq(), data) != 0))
+    {
+        *id = ADBMS_CAN_ID_PROFILE + k;
+        return true;
+    }
+    diag_profile = false;
+#endif
+    return false;
+}
+
 void data_can_loop()
 {
-    // Send out
-    // voltages: pack voltage, max cell voltage, min cell voltage, avg cell voltage
-    // temp: max temp, avg temp
+    static uint16_t cell_frame;
+    uint8_t data[8];
+    uint16_t id;
+
+    // diag round first, packed when sent, then the cells in what is left
+    while ((diag_frame != DIAG_FRAME_IDLE) && (HAL_CAN_GetTxMailboxesFreeLevel(&hcan1) != 0))
+    {
+        if (!diag_frame_pack(diag_frame, &id, data))
+        {
+            diag_frame = DIAG_FRAME_IDLE;
+            break;
+        }
+        can_send(&hcan1, id, data);
+        diag_frame++;
+    }
+    // per cell stream, as many frames as there are free mailboxes, picks up
+    // where the last release stopped
+    while (HAL_CAN_GetTxMailboxesFreeLevel(&hcan1) != 0)
+    {
+        if (ADBMS_CanPackCells(&adbms, cell_frame, data) == 0)
+        {
+            cell_frame = 0;
+            break;
+        }
+        can_send(&hcan1, ADBMS_CAN_ID_CELL + cell_frame, data);
+        cell_frame++;
+    }
     // misc: BMS_state, IMD_state
+
+#if PROFILE_ENABLE
+    CAN_RxHeaderTypeDef rx_header;
+    while (HAL_CAN_GetRxFifoFillLevel(&hcan1, CAN_RX_FIFO0) != 0)
+    {
+        if ((HAL_CAN_GetRxMessage(&hcan1, CAN_RX_FIFO0, &rx_header, data) == HAL_OK) &&
+            (rx_header.IDE == CAN_ID_STD) && (rx_header.StdId == ADBMS_CAN_ID_PROFILE_REQ))
+        {
+            profile_dump = true;
+        }
+    }
+#endif
 }
 void drive_can_loop()
 {
-    // send out everything
+    uint8_t data[8];
+
+    // voltages: pack voltage, max cell voltage, min cell voltage, avg cell voltage
+    ADBMS_CanPackVoltage(&adbms, data);
+    can_send(&hcan2, ADBMS_CAN_ID_VOLTAGE, data);
+    // temp: max temp, min temp, avg temp, die temp
+    ADBMS_CanPackTemp(&adbms, data);
+    can_send(&hcan2, ADBMS_CAN_ID_TEMP, data);
+}
+
+// self test results on the data bus and the usb link, with the scheduler
+// overruns. the can frames are more than the 3 mailboxes take at once, so
+// this only starts a round and data_can_loop streams it; a round still
+// going keeps its place
+static void diag_task(void)
+{
+    static char text[1024];
+    uint16_t len;
+    int n;
+
+    if (diag_frame == DIAG_FRAME_IDLE)
+    {
+        diag_frame = 0;
+    }
+#if PROFILE_ENABLE
+    // on request the profile table rides on the can round and replaces this
+    // second's usb report
+    if (profile_dump)
+    {
+        profile_dump = false;
+        diag_profile = true;
+        len = ADBMS_FormatProfile(text, sizeof(text), HAL_RCC_GetHCLKFreq());
+        CDC_Transmit_FS((uint8_t *)text, len);
+        return;
+    }
+#endif
+    len = ADBMS_FormatSelfTest(text, sizeof(text));
+    for (uint8_t i = 0; i < GROUP_COUNT; i++)
+    {
+        n = snprintf(&text[len], sizeof(text) - len, "%s: overrun %lu lag %lu budget %lu/%lu us over %lu\r\n",
+                     groups[i].name, (unsigned long)groups[i].overrun_count, (unsigned long)groups[i].max_lag,
+                     (unsigned long)groups[i].exec_max_us, (unsigned long)groups[i].budget_us,
+                     (unsigned long)groups[i].budget_overrun_count);
+        if ((n < 0) || (n >= (int)(sizeof(text) - len)))
+        {
+            len = sizeof(text) - 1;
+            break;
+        }
+        len += (uint16_t)n;
+    }
+    CDC_Transmit_FS((uint8_t *)text, len); // busy link: this report is skipped
 }
 
 void CheckFaults()
 {
-    // check overvoltage fault;
-    // check undervoltage fault;
+    // check overvoltage and undervoltage fault;
+    PROF_BEGIN(PROF_CHECK_FAULTS);
+    ADBMS_CheckFaults(&adbms);
+    PROF_END(PROF_CHECK_FAULTS);
+    // latched, the loop recovering does not clear it
+    if (deadline_fault)
+    {
+        adbms.faults |= ADBMS_FAULT_DEADLINE;
+    }
     // check overcurrent fault;
     // check overtemperature fault;
     // check undertemperature fault;
@@ -73,18 +324,21 @@ void CheckFaults()
 void idle_on_enter()
 {
     printf("entering idle...");
+    ADBMS_ClockRequest(CLOCK_LOW);
     // open contactors;
     // send idle msg;
 }
 void precharge_on_enter()
 {
     printf("entering precharge...");
+    ADBMS_ClockRequest(CLOCK_FULL);
     // turn on P contactor
     // turn on Pre contactor;
 }
 void active_on_enter()
 {
     printf("entering active...");
+    ADBMS_ClockRequest(CLOCK_FULL);
     // turn on N contactor;
     // delay(0.1 sec);
     // turn off Pre contactor;
@@ -93,11 +347,13 @@ void active_on_enter()
 void charge_on_enter()
 {
     printf("entering charge...");
+    ADBMS_ClockRequest(CLOCK_FULL);
     // send initial/start msg to charger;
 }
 void fault_on_enter()
 {
     printf("entering fault...");
+    ADBMS_ClockRequest(CLOCK_FULL);
     // open (turn off) all contactors;
     // send fault msg;
 }
@@ -0,0 +1,85 @@
+#include "adbms_ntc.h"
+
+// 10k ntc (Steinhart-Hart A 1.009249522e-3, B 2.378405444e-4, C 2.019202697e-7)
+// with a 10k pull-up, -40 to 125 degC in 5 degC steps. 5 degC steps keep the
+// linear interpolation within 0.14 degC of the equation
+static const uint16_t NTC_10K_PU10K_RATIO[] = {
+    62500, 61594, 60478, 59123, 57507, 55613, 53435, 50979,
+    48267, 45336, 42238, 39032, 35786, 32565, 29429, 26432,
+    23612, 20997, 18601, 16431, 14482, 12746, 11208, 9851,
+    8660, 7617, 6705, 5908, 5213, 4606, 4077, 3614,
+    3210, 2857,
+};
+
+const ntc_type_ NTC_10K_PU10K = {
+    NTC_10K_PU10K_RATIO,
+    sizeof(NTC_10K_PU10K_RATIO) / sizeof(NTC_10K_PU10K_RATIO[0]),
+    -4000,
+    500,
+    64880, // 0.99: ntc above 1M
+    655,   // 0.01: ntc below 100R
+};
+
+// gpio / vref2 in Q16, both in uV. the shifts keep the division in 32 bits:
+// gpio < 16.7 V and vref2 keeps 14 significant bits
+uint16_t NTC_Ratio(int32_t gpio_uv, int32_t vref2_uv)
+{
+    uint32_t ratio;
+
+    if (gpio_uv <= 0)
+    {
+        return 0;
+    }
+    if ((vref2_uv >> 8) <= 0)
+    {
+        return UINT16_MAX;
+    }
+    ratio = ((uint32_t)gpio_uv << 8) / ((uint32_t)vref2_uv >> 8);
+    return (ratio > UINT16_MAX) ? UINT16_MAX : (uint16_t)ratio;
+}
+
+// binary search of the falling table, then linear interpolation in the segment
+ntc_state_ NTC_ToCentiDeg(const ntc_type_ *type, uint16_t ratio, int16_t *cdeg)
+{
+    const uint16_t *table = type->ratio;
+    uint8_t lo = 0;
+    uint8_t hi = type->count - 1;
+
+    if (ratio >= type->open_ratio)
+    {
+        *cdeg = type->first_cdeg;
+        return NTC_OPEN;
+    }
+    if (ratio <= type->short_ratio)
+    {
+        *cdeg = type->first_cdeg + (hi * type->step_cdeg);
+        return NTC_SHORT;
+    }
+    if (ratio > table[0])
+    {
+        *cdeg = type->first_cdeg;
+        return NTC_LOW;
+    }
+    if (ratio < table[hi])
+    {
+        *cdeg = type->first_cdeg + (hi * type->step_cdeg);
+        return NTC_HIGH;
+    }
+
+    // table[lo] >= ratio >= table[hi]
+    while ((hi - lo) > 1)
+    {
+        uint8_t mid = (lo + hi) / 2;
+        if (table[mid] >= ratio)
+        {
+            lo = mid;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    *cdeg = (int16_t)(type->first_cdeg + (lo * type->step_cdeg) +
+                      (((int32_t)(table[lo] - ratio) * type->step_cdeg) / (table[lo] - table[hi])));
+    return NTC_OK;
+}
@@ -0,0 +1,211 @@
+#include "adbms_sched.h"
+#include "common.h"
+
+// touched by the TIM3 interrupt on every tick, kept in ccm ram
+CCMRAM static sched_group_ *sched_groups;
+CCMRAM static uint8_t sched_count;
+CCMRAM static volatile uint32_t sched_tick;
+CCMRAM static const sched_monitor_ *sched_monitor;
+CCMRAM static sched_worst_ sched_worst;
+CCMRAM static volatile bool sched_late;   // group 0 late, escalated once until it starts again
+CCMRAM static uint32_t sched_escalations;
+
+static uint16_t gcd16(uint16_t a, uint16_t b)
+{
+    while (b != 0)
+    {
+        uint16_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// two groups release on the same tick for some tick iff their phases are
+// equal modulo the gcd of their periods. a period 1 group runs every tick,
+// it is left out of the check
+bool ADBMS_SchedPhasesOk(const sched_group_ *groups, uint8_t count)
+{
+    for (uint8_t i = 0; i < count; i++)
+    {
+        if ((groups[i].period == 0) || (groups[i].phase >= groups[i].period))
+        {
+            return false;
+        }
+        for (uint8_t j = i + 1; j < count; j++)
+        {
+            if ((groups[i].period == 1) || (groups[j].period == 1))
+            {
+                continue;
+            }
+            uint16_t g = gcd16(groups[i].period, groups[j].period);
+            if ((groups[i].phase % g) == (groups[j].phase % g))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// groups in priority order, index 0 first. the table is kept and written by
+// the scheduler. returns false (and schedules nothing) on a bad phase plan
+bool ADBMS_SchedInit(sched_group_ *groups, uint8_t count)
+{
+    sched_count = 0;
+    sched_tick = 0;
+    if (!ADBMS_SchedPhasesOk(groups, count))
+    {
+        return false;
+    }
+    for (uint8_t i = 0; i < count; i++)
+    {
+        groups[i].pending = 0;
+        groups[i].running = 0;
+        groups[i].release_tick = 0;
+        groups[i].run_count = 0;
+        groups[i].overrun_count = 0;
+        groups[i].max_lag = 0;
+        groups[i].start_tick = 0;
+        groups[i].exec_max_us = 0;
+        groups[i].budget_overrun_count = 0;
+        groups[i].budget_overrun_tick = 0;
+    }
+    sched_worst = (sched_worst_){0};
+    sched_late = false;
+    sched_escalations = 0;
+    sched_groups = groups;
+    sched_count = count;
+    return true;
+}
+
+// the monitor is kept, NULL turns it off
+void ADBMS_SchedMonitor(const sched_monitor_ *monitor)
+{
+    sched_monitor = monitor;
+}
+
+// group 0 has not started for loop_limit ticks: the main loop is stuck in
+// a task (a blocking retry, a long wake) and the fault path is not running.
+// escalate from the tick, the main loop cannot be relied on to notice
+static void sched_check_loop(uint32_t now)
+{
+    const sched_monitor_ *m = sched_monitor;
+
+    if ((m == NULL) || (m->loop_limit == 0) || (sched_count == 0) || sched_late)
+    {
+        return;
+    }
+    if ((now - sched_groups[0].start_tick) >= m->loop_limit)
+    {
+        sched_late = true;
+        sched_escalations++;
+        if (m->escalate != NULL)
+        {
+            m->escalate();
+        }
+    }
+}
+
+// timer interrupt. a group still pending or running when it is due again has
+// overrun: the release is dropped so the group stays on its phase
+void ADBMS_SchedTick(void)
+{
+    uint32_t now = ++sched_tick;
+    for (uint8_t i = 0; i < sched_count; i++)
+    {
+        sched_group_ *g = &sched_groups[i];
+        if ((now % g->period) != g->phase)
+        {
+            continue;
+        }
+        if (g->pending || g->running)
+        {
+            g->overrun_count++;
+            continue;
+        }
+        g->release_tick = now;
+        g->pending = 1;
+    }
+    sched_check_loop(now);
+}
+
+// run time against the budget, the longest run over budget is kept with the
+// monitor tag
+static void sched_check_budget(uint8_t index, sched_group_ *g, uint32_t exec_us)
+{
+    if (exec_us > g->exec_max_us)
+    {
+        g->exec_max_us = exec_us;
+    }
+    if ((g->budget_us == 0) || (exec_us <= g->budget_us))
+    {
+        return;
+    }
+    g->budget_overrun_count++;
+    g->budget_overrun_tick = sched_tick;
+    if (exec_us > sched_worst.exec_us)
+    {
+        sched_worst.group = index;
+        sched_worst.exec_us = exec_us;
+        sched_worst.tick = sched_tick;
+        sched_worst.tag = (sched_monitor->tag != NULL) ? sched_monitor->tag() : 0;
+    }
+}
+
+// main loop: runs the first pending group to completion, returns false when
+// nothing was pending. tasks do not preempt each other, a higher rate group
+// released meanwhile runs on the next call
+bool ADBMS_SchedRunNext(void)
+{
+    for (uint8_t i = 0; i < sched_count; i++)
+    {
+        sched_group_ *g = &sched_groups[i];
+        if (!g->pending)
+        {
+            continue;
+        }
+        uint32_t lag = sched_tick - g->release_tick;
+        if (lag > g->max_lag)
+        {
+            g->max_lag = lag;
+        }
+        // running before pending clears, the tick never sees the group idle
+        g->running = 1;
+        g->pending = 0;
+        g->start_tick = sched_tick;
+        if (i == 0)
+        {
+            sched_late = false;
+        }
+        if (sched_monitor != NULL)
+        {
+            uint32_t start_us = sched_monitor->now_us();
+            g->task();
+            sched_check_budget(i, g, sched_monitor->now_us() - start_us);
+        }
+        else
+        {
+            g->task();
+        }
+        g->run_count++;
+        g->running = 0;
+        return true;
+    }
+    return false;
+}
+
+uint32_t ADBMS_SchedNow(void)
+{
+    return sched_tick;
+}
+
+const sched_worst_ *ADBMS_SchedWorst(void)
+{
+    return &sched_worst;
+}
+
+uint32_t ADBMS_SchedEscalations(void)
+{
+    return sched_escalations;
+}
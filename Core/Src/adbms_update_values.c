@@ -1,80 +1,320 @@
 #include "adbms_update_values.h"
 
+// cell over/under voltage limits, uV
+static const int32_t OV_THRESHOLD = 4200000;
+static const int32_t UV_THRESHOLD = 3000000;
+
+// nominal vref2, used until status A has been read
+#define VREF2_NOMINAL_UV 3000000
+#define VREF2_MIN_UV 2900000
+#define VREF2_MAX_UV 3100000
+
+// normal conversions run without open wire current, the open wire sequence
+// gets its own conversions every OW_PERIOD_MS
+static OW_C_S CELL_OPEN_WIRE_DETECTION = OW_OFF_ALL_CH;
+static OW_AUX AUX_OPEN_WIRE_DETECTION = AUX_OW_OFF;
+static CH AUX_CH_TO_CONVERT = AUX_ALL;
+static PUP OPEN_WIRE_CURRENT_SOURCE = PUP_DOWN;
+
+// open wire sequence period and even/odd, pull-up/down difference limits, uV
+static const ow_cfg_ OW_CFG = {1000, 2000000, 50000};
+
+// self test periods in ms (osc, thsd, supply uv, supply ov, fuse ed, fuse med,
+// tmodchk, csflt) and the wait between forcing a fault and reading it back
+static const st_cfg_ ST_CFG = {{1000, 5000, 5000, 5000, 10000, 10000, 10000, 1000}, 2};
+
+// c-adc vs s-adc difference of a bad cell, uV, and the consecutive reads it
+// takes to set or clear it
+static const cs_cfg_ CS_CFG = {10000, 3};
+
+// layout of the codes the statistics run over
+static const pack_stats_src_ CELL_STATS_SRC = {PACK_PEC_CELL, CELL, 0, CELL};
+static const pack_stats_src_ TEMP_STATS_SRC = {PACK_PEC_AUX, NTC_COUNT, 0, NTC_COUNT};
+
+// the aux codes are read by dma as the last transfer of a tick and parsed on
+// the next one, the fault and can groups run while the frame is clocked
+static bool aux_read_pending = false;
+
 void ADBMS_UpdateValues(adbms_ *adbms)
 {
+    uint32_t failing;
+    bool ow_busy;
+
+    // the dma read of the last tick still holds the bus, try again next tick
+    if (!adBmsReadDataFinish())
+    {
+        return;
+    }
+
     // chip wakeup
     adBmsWakeupIc(adbms->system.TOTAL_IC);
 
-    // start cell aux conversion, enable open wire check
-    adBms6830_Adax(AUX_OPEN_WIRE_DETECTION, OPEN_WIRE_CURRENT_SOURCE, AUX_CH_TO_CONVERT);
+    // a read with a pec error is retried for the failing ics only, a few
+    // retries per tick at most; the rest keep their last good codes
+    adBmsRetryTick();
+    if (aux_read_pending)
+    {
+        aux_read_pending = false;
+        adBmsRetryFailing(adbms->system.TOTAL_IC, adbms->system.IC, &RDASALL);
+    }
 
-    // start cell voltage conversion, enable open wire check
-    adBms6830_Adsv(CONTINUOUS, DCP_OFF, CELL_OPEN_WIRE_DETECTION);
+    // config is only written when it changed. every read checks the command
+    // counter against the commands sent, only a lost write or an ic reset
+    // (counter back to 0) costs a full config read back
+    if (adBmsCcMismatch() != 0)
+    {
+        adBmsCcClearMismatch();
+        if (adBmsCfgVerify(adbms->system.TOTAL_IC, adbms->system.IC) != 0)
+        {
+            // an ic that went through a reset stopped its c-adc as well
+            adBms6830_Adcv(RD_OFF, CONTINUOUS, DCP_OFF, RSTF_OFF, CELL_OPEN_WIRE_DETECTION);
+        }
+    }
 
-    // get voltages from ADBMS
-    adBmsReadData(adbms->system.TOTAL_IC, adbms->system.IC, RDCVALL, Cell, NONE);
+    // every OW_CFG.period_ms the open wire sequence takes the S-ADC and aux
+    // adc for a few ticks, one conversion or read per tick; its codes never
+    // reach the pack store. the c-adc keeps converting meanwhile
+    ow_busy = adBmsOwStep(adbms->system.TOTAL_IC, adbms->system.IC);
 
-    // get temp from ADBMS
-    adBmsReadData(adbms->system.TOTAL_IC, adbms->system.IC, RDASALL, Aux, NONE);
+    // conversions run between ticks: read a result once it is done, then
+    // start the next conversion, never wait for the adc here
+    if (ow_busy)
+    {
+        // c-adc codes alone, nothing to cross check them against
+        adBmsReadRetry(adbms->system.TOTAL_IC, adbms->system.IC, &RDCVALL);
+    }
+    else
+    {
+        switch (adBmsAdcPoll(ADC_CONV_S))
+        {
+        case ADC_DONE:
+            // get voltages from ADBMS: c-adc and s-adc codes in one frame, the
+            // c-adc runs continuously since init. every ic read good gets its
+            // cells cross checked, no extra bus traffic
+            failing = adBmsReadRetry(adbms->system.TOTAL_IC, adbms->system.IC, &RDCSALL);
+            adBmsCsCheck(adbms->system.TOTAL_IC, adbms->system.IC, ~failing);
+            // fall through
+        case ADC_IDLE:
+            // start cell voltage conversion
+            adBms6830_Adsv(CONTINUOUS, DCP_OFF, CELL_OPEN_WIRE_DETECTION);
+            break;
+        default:
+            break;
+        }
+    }
 
-    // run open wire check -> have to look into
+    // latent fault self tests take turns, one status/config transfer per
+    // tick, they do not touch the adcs
+    adBmsStStep(adbms->system.TOTAL_IC, adbms->system.IC);
+
+    // the aux result is read last, by dma; the next aux conversion starts on
+    // the tick after, once the frame has been parsed
+    if (ow_busy)
+    {
+        return;
+    }
+    switch (adBmsAdcPoll(ADC_CONV_AUX))
+    {
+    case ADC_DONE:
+        // get temp from ADBMS
+        aux_read_pending = adBmsReadDataStart(adbms->system.TOTAL_IC, adbms->system.IC, &RDASALL, NULL);
+        if (aux_read_pending)
+        {
+            break;
+        }
+        adBmsReadRetry(adbms->system.TOTAL_IC, adbms->system.IC, &RDASALL);
+        // fall through
+    case ADC_IDLE:
+        // start cell aux conversion
+        adBms6830_Adax(AUX_OPEN_WIRE_DETECTION, OPEN_WIRE_CURRENT_SOURCE, AUX_CH_TO_CONVERT);
+        break;
+    default:
+        break;
+    }
 
     // calculate the SOC;  // ignore for now
 }
 
+// ntc divider ratio against the measured vref2 of the ic, so reference drift
+// cancels out
+static void ADBMS_ConvertTemps(adbms_ *adbms, int ic)
+{
+    const pack_store_ *pack = adbms->system.pack;
+    const int16_t *aux = &pack->aux[(ic * AUX) + NTC_FIRST];
+    int16_t *temp = &adbms->temp_cdeg[ic * NTC_COUNT];
+    int32_t vref2_uv = CODE_TO_UV((int16_t)pack->vref2[ic]);
+    uint16_t bad = 0;
+
+    if ((vref2_uv < VREF2_MIN_UV) || (vref2_uv > VREF2_MAX_UV))
+    {
+        vref2_uv = VREF2_NOMINAL_UV;
+    }
+    for (int j = 0; j < NTC_COUNT; j++)
+    {
+        if (NTC_ToCentiDeg(&NTC_10K_PU10K, NTC_Ratio(CODE_TO_UV(aux[j]), vref2_uv), &temp[j]) != NTC_OK)
+        {
+            bad |= (uint16_t)(1 << j);
+        }
+    }
+    adbms->ntc_bad[ic] = bad;
+}
+
 void ADBMS_CalculateValues(adbms_ *adbms)
 {
-    // calculate the total, max, and min voltage
-    adbms->total_v = 0;
-    adbms->max_v = 0;
-    adbms->min_v = 5;
-    for (int i = 0; i < adbms->system.TOTAL_IC; i++)
+    pack_store_ *pack = adbms->system.pack;
+    const code_stats_ *stats;
+
+    if (pack->tIC == 0)
     {
-        for (int j = 0; j < 16; j++)
+        return;
+    }
+
+    // ics whose cells have been read good at least once since init, the
+    // pack extremes mean nothing before every ic is in
+    for (int i = 0; i < pack->tIC; i++)
+    {
+        if (pack->dirty[i] & PACK_PEC_CELL)
         {
-            adbms->total_v += adbms->system.IC[i].cell.c_codes[j];
-            if (adbms->system.IC[i].cell.c_codes[j] > adbms->max_v)
-            {
-                adbms->max_v = adbms->system.IC[i].cell.c_codes[j];
-            }
-            if (adbms->system.IC[i].cell.c_codes[j] < adbms->min_v)
-            {
-                adbms->min_v = adbms->system.IC[i].cell.c_codes[j];
-            }
+            adbms->cell_read |= (1u << i);
         }
     }
 
-    // calculate the avg voltage
-    adbms->avg_v = adbms->total_v / (adbms->system.TOTAL_IC * 16);
+    // calculate the total, max, and min voltage, only ics read since the last
+    // tick are rescanned; codes only become uV here: uv = code * lsb + offset
+    if (adBmsPackStatsUpdate(&adbms->cell_stats, pack, pack->cell, &CELL_STATS_SRC) != 0)
+    {
+        const int cell_count = pack->tIC * CELL;
+        stats = &adbms->cell_stats.pack;
+        adbms->total_uv = (stats->sum * CODE_LSB_UV) + (cell_count * CODE_OFFSET_UV);
+        adbms->max_uv = CODE_TO_UV(stats->max);
+        adbms->min_uv = CODE_TO_UV(stats->min);
+        adbms->max_v_cell = stats->argmax;
+        adbms->min_v_cell = stats->argmin;
 
-    // calculate the total, max, and min temp
-    adbms->total_temp = 0;
-    adbms->max_temp = 0;
-    adbms->min_temp = 100;
+        // calculate the avg voltage
+        adbms->avg_uv = adbms->total_uv / cell_count;
+    }
+
+    // convert the thermistors of every ic with new aux or status (vref2) codes,
+    // then take them into the temperature statistics (aux dirty bit)
+    for (int i = 0; i < pack->tIC; i++)
+    {
+        if (pack->dirty[i] & (PACK_PEC_AUX | PACK_PEC_STAT))
+        {
+            ADBMS_ConvertTemps(adbms, i);
+            pack->dirty[i] = (pack->dirty[i] | PACK_PEC_AUX) & ~PACK_PEC_STAT;
+        }
+    }
+    if (adBmsPackStatsUpdate(&adbms->temp_stats, pack, adbms->temp_cdeg, &TEMP_STATS_SRC) != 0)
+    {
+        stats = &adbms->temp_stats.pack;
+        adbms->max_temp = stats->max;
+        adbms->min_temp = stats->min;
+        adbms->avg_temp = stats->sum / (pack->tIC * NTC_COUNT);
+        adbms->max_temp_ch = stats->argmax;
+        adbms->min_temp_ch = stats->argmin;
+    }
+
+    // hottest die
+    adbms->max_die_cdeg = ITMP_TO_CDEG(pack->itmp[0]);
+    for (int i = 1; i < pack->tIC; i++)
+    {
+        if (ITMP_TO_CDEG(pack->itmp[i]) > adbms->max_die_cdeg)
+        {
+            adbms->max_die_cdeg = ITMP_TO_CDEG(pack->itmp[i]);
+        }
+    }
+}
+
+uint8_t ADBMS_CheckFaults(adbms_ *adbms)
+{
+    const pack_store_ *pack = adbms->system.pack;
+    const uint32_t all_ics = (1u << adbms->system.TOTAL_IC) - 1;
+    uint8_t faults = 0;
+
+    // compare in uV against the pack extremes, no per cell conversion. the
+    // extremes are only valid once the cell statistics cover every ic with
+    // codes actually read, before that they start from 0
+    if ((pack->tIC != 0) && (adbms->cell_stats.tIC == pack->tIC) && ((adbms->cell_read & all_ics) == all_ics))
+    {
+        if (adbms->max_uv > OV_THRESHOLD)
+        {
+            faults |= ADBMS_FAULT_OV;
+        }
+        if (adbms->min_uv < UV_THRESHOLD)
+        {
+            faults |= ADBMS_FAULT_UV;
+        }
+    }
+
+    // the ic comparators run on every conversion, trust them as well
+    for (int i = 0; i < adbms->system.TOTAL_IC; i++)
+    {
+        if (pack->c_ov[i] != 0)
+        {
+            faults |= ADBMS_FAULT_OV;
+        }
+        if (pack->c_uv[i] != 0)
+        {
+            faults |= ADBMS_FAULT_UV;
+        }
+    }
     for (int i = 0; i < adbms->system.TOTAL_IC; i++)
     {
-        for (int j = 2; j < 12; j++)
+        if (adbms->ntc_bad[i] != 0)
         {
-            adbms->total_temp += adbms->system.IC[i].aux.a_codes[j];
-            if (adbms->system.IC[i].aux.a_codes[j] > adbms->max_temp)
-            {
-                adbms->max_temp = adbms->system.IC[i].aux.a_codes[j];
-            }
-            if (adbms->system.IC[i].aux.a_codes[j] < adbms->min_temp)
-            {
-                adbms->min_temp = adbms->system.IC[i].aux.a_codes[j];
-            }
+            faults |= ADBMS_FAULT_NTC;
         }
     }
-    // calculate the avg temp
-    adbms->avg_temp = adbms->total_temp / (adbms->system.TOTAL_IC * 10);
+
+    // an ic that failed its reads RETRY_FAULT_DEFAULT times in a row, its
+    // codes are stale
+    if (adBmsRetryFaults() != 0)
+    {
+        faults |= ADBMS_FAULT_COMM;
+    }
+
+    // a cell sense wire or thermistor wire open in the last sequence
+    if (adBmsOwOpenMask() != 0)
+    {
+        faults |= ADBMS_FAULT_OW;
+    }
+
+    // c-adc and s-adc disagree on a cell
+    if (adBmsCsFaultMask() != 0)
+    {
+        faults |= ADBMS_FAULT_CS;
+    }
+
+    // an ic failed a self test in its last run
+    if (adBmsStFailMask() != 0)
+    {
+        faults |= ADBMS_FAULT_SELFTEST;
+    }
+    adbms->faults = faults;
+    return faults;
 }
 
+// the chain and the pack store are read on every tick, they live in ccm ram
+CCMRAM static cell_asic ic_pool[MAX_IC];
+CCMRAM static pack_store_ pack_pool;
+
 cell ADBMS_Initialize(uint8_t ic_count)
 {
-    cell system;
+    cell system = {0};
+    // the chain lives in a static pool sized by MAX_IC, no heap. a longer
+    // chain is refused: running a shorter one would leave ics unmonitored
+    if ((ic_count == 0) || (ic_count > MAX_IC))
+    {
+        printf("ADBMS_Initialize: %u ics, 1 to %u supported\n", (unsigned)ic_count, (unsigned)MAX_IC);
+        return system;
+    }
+    memset(ic_pool, 0, sizeof(ic_pool));
+    memset(&pack_pool, 0, sizeof(pack_pool));
     system.TOTAL_IC = ic_count;
-    system.IC = malloc(ic_count * sizeof(cell_asic));
+    system.IC = ic_pool;
+    system.pack = &pack_pool;
+    adBmsSetPackStore(&pack_pool);
     for (uint8_t cic = 0; cic < ic_count; cic++)
     {
         /* Init config A */
@@ -84,11 +324,29 @@ cell ADBMS_Initialize(uint8_t ic_count)
         system.IC[cic].tx_cfgb.vuv = SetUnderVoltageThreshold(UV_THRESHOLD);
     }
     adBmsWakeupIc(ic_count);
-    adBmsWriteData(ic_count, &system.IC[0], WRCFGA, Config, A);
-    adBmsWriteData(ic_count, &system.IC[0], WRCFGB, Config, B);
+    adBmsCfgInvalidate(); // chain state unknown, write both registers
+    adBmsCcReset();       // counters sync on the first read back
+    adBmsRetryReset();
+    adBmsOwConfig(&OW_CFG);
+    adBmsOwReset(); // first sequence on the first tick
+    adBmsStConfig(&ST_CFG);
+    adBmsStReset(); // every test due, they run in turn
+    adBmsCsConfig(&CS_CFG);
+    adBmsCsReset();
+    adBmsCfgWrite(ic_count, &system.IC[0]);
+    // c-adc converts continuously from here on, s-adc and aux are started per tick
+    adBms6830_Adcv(RD_OFF, CONTINUOUS, DCP_OFF, RSTF_OFF, CELL_OPEN_WIRE_DETECTION);
+    return system;
 }
 
 void ADBMS_delete(adbms_ *adbms)
 {
-    free(adbms->system.IC);
+    // pool is static, just drop the reference
+    adBmsSetPackStore(NULL);
+    adBmsPackStatsReset(&adbms->cell_stats);
+    adBmsPackStatsReset(&adbms->temp_stats);
+    adbms->cell_read = 0;
+    adbms->system.TOTAL_IC = 0;
+    adbms->system.IC = NULL;
+    adbms->system.pack = NULL;
 }
\ No newline at end of file
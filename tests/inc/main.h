@@ -0,0 +1,7 @@
+#ifndef MAIN_H
+#define MAIN_H
+
+// host stand-in for the CubeMX main.h that adbms_main.h includes; the
+// SPI_MOCK build of the driver needs nothing from the hal
+
+#endif
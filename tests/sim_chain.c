@@ -0,0 +1,176 @@
+#include "sim_chain.h"
+#include "adBms6830CmdList.h"
+
+sim_chain_ sim;
+
+uint16_t sim_pec15(const uint8_t *data, int len)
+{
+    uint16_t remainder = 16;
+
+    for (int i = 0; i < len; i++)
+    {
+        remainder ^= (uint16_t)(data[i] << 7);
+        for (int bit = 0; bit < 8; bit++)
+        {
+            remainder = (remainder & 0x4000) ? (uint16_t)((remainder << 1) ^ 0x4599) : (uint16_t)(remainder << 1);
+        }
+    }
+    return (uint16_t)((remainder & 0x7FFF) << 1);
+}
+
+// the counter field is the 6 msbs of the byte after the data
+uint16_t sim_pec10(const uint8_t *data, int len, bool with_cntr, uint8_t cntr)
+{
+    uint16_t remainder = 16;
+
+    for (int i = 0; i < len; i++)
+    {
+        remainder ^= (uint16_t)(data[i] << 2);
+        for (int bit = 0; bit < 8; bit++)
+        {
+            remainder = (remainder & 0x200) ? (uint16_t)((remainder << 1) ^ 0x8F) : (uint16_t)(remainder << 1);
+        }
+    }
+    if (with_cntr)
+    {
+        remainder ^= (uint16_t)((cntr & 0xFC) << 2);
+        for (int bit = 0; bit < 6; bit++)
+        {
+            remainder = (remainder & 0x200) ? (uint16_t)((remainder << 1) ^ 0x8F) : (uint16_t)(remainder << 1);
+        }
+    }
+    return (uint16_t)(remainder & 0x3FF);
+}
+
+uint8_t sim_pattern(uint8_t ic, const uint8_t *cmd, uint8_t index)
+{
+    return (uint8_t)(ic * 37 + cmd[1] * 11 + index * 3);
+}
+
+static bool is_cmd(const uint8_t *tx, const cmd_desc_ *cmd)
+{
+    return (tx[0] == cmd->frame[0]) && (tx[1] == cmd->frame[1]);
+}
+
+// PLADC .. PLAUX2, they leave the counter alone
+static bool is_poll(const uint8_t *tx)
+{
+    return (tx[0] == 0x07) && (tx[1] >= 0x18) && (tx[1] <= 0x1F);
+}
+
+static void count_command(const uint8_t *tx)
+{
+    if (is_cmd(tx, &RSTCC))
+    {
+        memset(sim.cmd_cntr, 0, sizeof(sim.cmd_cntr));
+        return;
+    }
+    if (is_poll(tx))
+    {
+        return;
+    }
+    for (uint8_t ic = 0; ic < sim.ic_count; ic++)
+    {
+        sim.cmd_cntr[ic] = (sim.cmd_cntr[ic] >= 63) ? 1 : (uint8_t)(sim.cmd_cntr[ic] + 1);
+    }
+}
+
+// the first data block shifted in ends up in the last ic of the chain
+static void write_registers(const uint8_t *tx, uint16_t tx_size)
+{
+    uint8_t (*reg)[TX_DATA] = is_cmd(tx, &WRCFGA) ? sim.cfga : is_cmd(tx, &WRCFGB) ? sim.cfgb : NULL;
+    uint8_t blocks = (uint8_t)((tx_size - 4) / RX_DATA);
+
+    for (uint8_t b = 0; b < blocks; b++)
+    {
+        const uint8_t *block = &tx[4 + (b * RX_DATA)];
+        uint16_t pec = (uint16_t)(((block[TX_DATA] & 0x03) << 8) | block[TX_DATA + 1]);
+        uint8_t ic = (uint8_t)(blocks - 1 - b);
+
+        if ((pec != sim_pec10(block, TX_DATA, true, 0)) || ((block[TX_DATA] & 0xFC) != 0))
+        {
+            sim.write_pec_errors++;
+            continue;
+        }
+        if ((reg != NULL) && (ic < sim.ic_count))
+        {
+            memcpy(reg[ic], block, TX_DATA);
+        }
+    }
+}
+
+static void read_registers(const uint8_t *tx, uint8_t *rx, uint16_t rx_size)
+{
+    uint8_t size = (uint8_t)(rx_size / sim.ic_count);
+
+    for (uint8_t ic = 0; ic < sim.ic_count; ic++)
+    {
+        uint8_t *frame = &rx[ic * size];
+        uint8_t len = (uint8_t)(size - 2);
+        uint16_t pec;
+
+        if (is_cmd(tx, &RDCFGA))
+        {
+            memcpy(frame, sim.cfga[ic], TX_DATA);
+        }
+        else if (is_cmd(tx, &RDCFGB))
+        {
+            memcpy(frame, sim.cfgb[ic], TX_DATA);
+        }
+        else if (sim.fill != NULL)
+        {
+            sim.fill(ic, tx, frame, len);
+        }
+        else
+        {
+            for (uint8_t i = 0; i < len; i++)
+            {
+                frame[i] = sim_pattern(ic, tx, i);
+            }
+        }
+        pec = sim_pec10(frame, len, true, (uint8_t)(sim.cmd_cntr[ic] << 2));
+        frame[len] = (uint8_t)((sim.cmd_cntr[ic] << 2) | (pec >> 8));
+        frame[len + 1] = (uint8_t)pec;
+        if (((sim.corrupt_once | sim.corrupt_always) >> ic) & 1)
+        {
+            frame[ic % len] ^= 0x10;
+        }
+    }
+    sim.corrupt_once = 0;
+}
+
+static void sim_respond(const uint8_t *tx, uint16_t tx_size, uint8_t *rx, uint16_t rx_size)
+{
+    // wake-up and sdo poll clocks: miso idles high, the chain reads done
+    if (tx == NULL)
+    {
+        return;
+    }
+    sim.bytes += (uint32_t)tx_size + rx_size;
+    if (rx == NULL)
+    {
+        if (tx_size > 4)
+        {
+            sim.writes++;
+            write_registers(tx, tx_size);
+        }
+        else
+        {
+            sim.commands++;
+        }
+        count_command(tx);
+        return;
+    }
+    sim.reads++;
+    if (rx_size >= sim.ic_count * 3)
+    {
+        read_registers(tx, rx, rx_size);
+    }
+}
+
+void sim_chain_init(uint8_t ic_count)
+{
+    memset(&sim, 0, sizeof(sim));
+    sim.ic_count = ic_count;
+    spiMockSetResponder(sim_respond);
+}
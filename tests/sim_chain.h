@@ -0,0 +1,41 @@
+#ifndef SIM_CHAIN_H
+#define SIM_CHAIN_H
+
+#include "adbms_main.h"
+
+// simulated daisy chain behind the SPI_MOCK backend of mcuWrapper.c. every
+// ic answers every read with a good pec and its own command counter, keeps
+// what was written to its config registers and moves its counter on the
+// commands that move it on the part. the pecs are computed bit by bit here,
+// independent of the driver tables
+typedef void (*sim_fill_)(uint8_t ic, const uint8_t *cmd, uint8_t *data, uint8_t len);
+
+typedef struct
+{
+    uint8_t ic_count;
+    uint8_t cfga[MAX_IC][TX_DATA]; // last WRCFGA data of each ic
+    uint8_t cfgb[MAX_IC][TX_DATA]; // last WRCFGB data of each ic
+    uint8_t cmd_cntr[MAX_IC];
+    uint32_t corrupt_once;   // ics whose next read back gets a flipped bit
+    uint32_t corrupt_always; // ics whose every read back gets a flipped bit
+    sim_fill_ fill;          // register data of a read, NULL for a fixed pattern
+    uint32_t reads;          // read commands, *ALL reads included
+    uint32_t writes;         // write commands
+    uint32_t commands;       // command only and poll commands
+    uint32_t write_pec_errors; // write data blocks with a bad data pec
+    uint32_t bytes;          // bytes on the bus, command bytes included
+} sim_chain_;
+
+extern sim_chain_ sim;
+
+// reset the chain to ic_count ics and install it as the mock responder
+void sim_chain_init(uint8_t ic_count);
+
+// reference pecs, one bit per step like the data sheet
+uint16_t sim_pec15(const uint8_t *data, int len);
+uint16_t sim_pec10(const uint8_t *data, int len, bool with_cntr, uint8_t cntr);
+
+// fixed register pattern of the default fill
+uint8_t sim_pattern(uint8_t ic, const uint8_t *cmd, uint8_t index);
+
+#endif
@@ -0,0 +1,93 @@
+// the driver and the acquisition path run from static buffers only: a full
+// chain is initialised, read and written for a few seconds of ticks with
+// malloc, calloc, realloc and free wrapped, and no call may reach them
+#include <stdlib.h>
+
+#include "adBms6830CmdList.h"
+#include "adbms_update_values.h"
+#include "sim_chain.h"
+#include "test_util.h"
+
+static uint32_t alloc_count;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+void *__wrap_malloc(size_t size)
+{
+    alloc_count++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size)
+{
+    alloc_count++;
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    alloc_count++;
+    return __real_realloc(ptr, size);
+}
+
+void __wrap_free(void *ptr)
+{
+    alloc_count++;
+    __real_free(ptr);
+}
+
+static adbms_ adbms;
+
+int main(void)
+{
+    static const cmd_desc_ *const reads[] = {&RDCFGA, &RDCFGB, &RDCVA, &RDCVALL, &RDSALL, &RDCSALL, &RDASALL, &RDSTATC};
+
+    sim_chain_init(MAX_IC);
+    adbms.system = ADBMS_Initialize(MAX_IC);
+    CHECK(adbms.system.IC != NULL);
+    CHECK(adbms.system.TOTAL_IC == MAX_IC);
+
+    // 3 s of 1 ms acquisition ticks
+    for (int tick = 0; tick < 3000; tick++)
+    {
+        spiMockSetTick(getTickMs() + 1);
+        ADBMS_UpdateValues(&adbms);
+        // the aux read left by dma completes before the next tick
+        while (spiDmaBusy())
+        {
+            spiMockCompleteDma(false);
+        }
+        ADBMS_CalculateValues(&adbms);
+        ADBMS_CheckFaults(&adbms);
+    }
+    for (size_t i = 0; i < sizeof(reads) / sizeof(reads[0]); i++)
+    {
+        adBmsReadData(MAX_IC, adbms.system.IC, reads[i]);
+    }
+    adbms.system.IC[0].tx_cfga.gpo = 0x155;
+    adBmsWriteData(MAX_IC, adbms.system.IC, &WRCFGA);
+    adBmsReadData(MAX_IC, adbms.system.IC, &RDCFGA);
+
+    CHECK(alloc_count == 0);
+    CHECK(sim.reads > 100);
+    CHECK(sim.write_pec_errors == 0);
+    CHECK(adBmsGetXferStats()->busy_count == 0);
+    CHECK(adbms.system.IC[0].rx_cfga.gpo == 0x155);
+
+    // a chain the buffers cannot hold is refused, never cut short
+    uint32_t rejected = adBmsGetXferStats()->reject_count;
+    adBmsReadData(MAX_IC + 1, adbms.system.IC, &RDCVALL);
+    CHECK(adBmsGetXferStats()->reject_count == rejected + 1);
+    cell none = ADBMS_Initialize(MAX_IC + 1);
+    CHECK((none.IC == NULL) && (none.TOTAL_IC == 0));
+    none = ADBMS_Initialize(0);
+    CHECK((none.IC == NULL) && (none.TOTAL_IC == 0));
+    CHECK(alloc_count == 0);
+
+    printf("%u ics, %lu reads, %lu writes, %lu commands, %lu allocations\n", MAX_IC, (unsigned long)sim.reads,
+           (unsigned long)sim.writes, (unsigned long)sim.commands, (unsigned long)alloc_count);
+    return test_result("test_alloc");
+}
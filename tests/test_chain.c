@@ -0,0 +1,154 @@
+// a full MAX_IC chain through the static buffers: config written and read
+// back in chain order, *ALL reads blocking and by dma (segmented when built
+// with SPI_RX_CHUNK_SIZE), blocking transfers refused while the dma runs,
+// and a chain longer than MAX_IC refused without bus traffic
+#include "adBms6830CmdList.h"
+#include "sim_chain.h"
+#include "test_util.h"
+
+static cell_asic ic[MAX_IC];
+static int done_calls;
+
+static void done_cb(void)
+{
+    done_calls++;
+}
+
+static int16_t pattern_code(uint8_t cic, const cmd_desc_ *cmd, int byte)
+{
+    return (int16_t)(sim_pattern(cic, cmd->frame, (uint8_t)byte) | (sim_pattern(cic, cmd->frame, (uint8_t)(byte + 1)) << 8));
+}
+
+static void check_aux(void)
+{
+    for (uint8_t cic = 0; cic < MAX_IC; cic++)
+    {
+        for (int i = 0; i < 12; i++)
+        {
+            CHECK(ic[cic].aux.a_codes[i] == pattern_code(cic, &RDASALL, 2 * i));
+        }
+        for (int i = 0; i < 10; i++)
+        {
+            CHECK(ic[cic].raux.ra_codes[i] == pattern_code(cic, &RDASALL, 24 + 2 * i));
+        }
+        CHECK((ic[cic].cccrc.aux_pec == 0) && (ic[cic].cccrc.raux_pec == 0) && (ic[cic].cccrc.stat_pec == 0));
+        CHECK(ic[cic].cccrc.cmd_cntr == sim.cmd_cntr[cic]);
+    }
+}
+
+// clock every dma segment like the dma interrupt would, returns the count
+static int complete_dma(bool error)
+{
+    int segments = 0;
+
+    while (spiDmaBusy())
+    {
+        spiMockCompleteDma(error);
+        segments++;
+    }
+    return segments;
+}
+
+static void test_config(void)
+{
+    for (uint8_t cic = 0; cic < MAX_IC; cic++)
+    {
+        ic[cic].tx_cfga.gpo = (uint16_t)((cic * 37) & 0x3FF);
+        ic[cic].tx_cfga.refon = 1;
+        ic[cic].tx_cfgb.vov = (uint16_t)(0x800 + cic);
+        ic[cic].tx_cfgb.vuv = (uint16_t)(0x400 + cic);
+    }
+    adBmsWriteData(MAX_IC, ic, &WRCFGA);
+    adBmsWriteData(MAX_IC, ic, &WRCFGB);
+    CHECK(sim.write_pec_errors == 0);
+
+    // the first block shifted in must land in the last ic
+    for (uint8_t cic = 0; cic < MAX_IC; cic++)
+    {
+        CHECK(memcmp(sim.cfga[cic], ic[cic].configa.tx_data, TX_DATA) == 0);
+        CHECK(memcmp(sim.cfgb[cic], ic[cic].configb.tx_data, TX_DATA) == 0);
+    }
+
+    adBmsReadData(MAX_IC, ic, &RDCFGA);
+    adBmsReadData(MAX_IC, ic, &RDCFGB);
+    for (uint8_t cic = 0; cic < MAX_IC; cic++)
+    {
+        CHECK(ic[cic].rx_cfga.gpo == ic[cic].tx_cfga.gpo);
+        CHECK(ic[cic].rx_cfga.refon == 1);
+        CHECK(ic[cic].rx_cfgb.vov == ic[cic].tx_cfgb.vov);
+        CHECK(ic[cic].rx_cfgb.vuv == ic[cic].tx_cfgb.vuv);
+        CHECK(ic[cic].cccrc.cfgr_pec == 0);
+    }
+}
+
+static void test_dma(void)
+{
+    const xfer_stats_ *xfer = adBmsGetXferStats();
+    uint32_t reads, busy;
+    int segments;
+
+    memset(ic, 0, sizeof(ic));
+    CHECK(adBmsReadDataStart(MAX_IC, ic, &RDASALL, done_cb));
+    CHECK(!adBmsReadDataStart(MAX_IC, ic, &RDCVALL, NULL));
+    CHECK(!adBmsReadDataFinish());
+
+    // the bus belongs to the dma until it completes: blocking transfers are
+    // refused and counted, a refused read flags its ics and sends nothing
+    reads = sim.reads;
+    busy = xfer->busy_count;
+    adBmsReadData(MAX_IC, ic, &RDCVALL);
+    spiSendCmd(&RSTCC);
+    adBmsWriteData(MAX_IC, ic, &WRCFGA);
+    CHECK(!adBmsProbeAdc(&PLCADC));
+    CHECK(xfer->busy_count == busy + 4);
+    CHECK(sim.reads == reads);
+    for (uint8_t cic = 0; cic < MAX_IC; cic++)
+    {
+        CHECK(ic[cic].cccrc.cell_pec == 1);
+    }
+
+    segments = complete_dma(false);
+    CHECK(done_calls == 1);
+    CHECK(adBmsReadDataFinish());
+    check_aux();
+    CHECK(segments >= ((SPI_RX_CHUNK_SIZE > 0) ? ((4 + MAX_IC * RDASALL_SIZE) / SPI_RX_CHUNK_SIZE) : 1));
+    printf("RDASALL %u ics, %u byte frame, %d dma segment(s)\n", MAX_IC, 4 + MAX_IC * RDASALL_SIZE, segments);
+
+    // a failed transfer leaves the codes and flags the whole read
+    CHECK(adBmsReadDataStart(MAX_IC, ic, &RDASALL, done_cb));
+    complete_dma(true);
+    CHECK(spiDmaError());
+    CHECK(adBmsReadDataFinish());
+    for (uint8_t cic = 0; cic < MAX_IC; cic++)
+    {
+        CHECK((ic[cic].cccrc.aux_pec == 1) && (ic[cic].cccrc.raux_pec == 1));
+        CHECK(ic[cic].aux.a_codes[0] == pattern_code(cic, &RDASALL, 0));
+    }
+}
+
+static void test_reject(void)
+{
+    const xfer_stats_ *xfer = adBmsGetXferStats();
+    uint32_t rejected = xfer->reject_count;
+    uint32_t bytes = sim.bytes;
+
+    adBmsReadData(MAX_IC + 1, ic, &RDCVALL);
+    adBmsWriteData(MAX_IC + 1, ic, &WRCFGA);
+    CHECK(!adBmsReadDataStart(MAX_IC + 1, ic, &RDASALL, NULL));
+    CHECK(xfer->reject_count == rejected + 3);
+    CHECK(sim.bytes == bytes);
+    CHECK(!spiDmaBusy());
+}
+
+int main(void)
+{
+    sim_chain_init(MAX_IC);
+    adBmsSetPackStore(NULL);
+
+    test_config();
+    adBmsReadData(MAX_IC, ic, &RDASALL);
+    check_aux();
+    test_dma();
+    test_reject();
+    return test_result("test_chain");
+}
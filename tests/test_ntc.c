@@ -0,0 +1,157 @@
+// thermistor table conversion against the Steinhart-Hart equation the table
+// was built from: reference points through the adc code quantisation, a
+// 0.01 degC sweep of the whole range, the open / short / out of range clamps,
+// then the table lookup timed against the float equation
+#include <math.h>
+
+#include "adbms_ntc.h"
+#include "adbms_update_values.h"
+#include "test_util.h"
+
+#define SH_A 1.009249522e-3
+#define SH_B 2.378405444e-4
+#define SH_C 2.019202697e-7
+#define PULL_UP_OHM 10000.0
+#define VREF2_UV 3000000
+
+#define BENCH_RUNS 2000000
+
+// resistance at a temperature, the cubic of the equation solved for ln(r)
+static double sh_ohm(double deg)
+{
+    double x = (SH_A - 1.0 / (deg + 273.15)) / SH_C;
+    double y = sqrt(pow(SH_B / (3.0 * SH_C), 3) + (x * x) / 4.0);
+    return exp(cbrt(y - x / 2.0) - cbrt(y + x / 2.0));
+}
+
+static double sh_deg(double ohm)
+{
+    double l = log(ohm);
+    return 1.0 / (SH_A + SH_B * l + SH_C * l * l * l) - 273.15;
+}
+
+// gpio voltage of the divider as the adc reports it, uV on the code grid
+static int32_t gpio_uv(double deg, int32_t vref2_uv)
+{
+    double ohm = sh_ohm(deg);
+    double uv = vref2_uv * ohm / (ohm + PULL_UP_OHM);
+    return CODE_TO_UV(lround((uv - CODE_OFFSET_UV) / CODE_LSB_UV));
+}
+
+static ntc_state_ convert(int32_t gpio, int32_t vref2, int16_t *cdeg)
+{
+    return NTC_ToCentiDeg(&NTC_10K_PU10K, NTC_Ratio(gpio, vref2), cdeg);
+}
+
+static void test_points(void)
+{
+    // inside the table ends, the exact end points may round out of it
+    static const double points[] = {-39, -30, -20, -10, 0, 10, 25, 40, 55, 70, 85, 100, 115, 124};
+    static const int32_t vref2[] = {2950050, VREF2_UV, 3049950};
+    int16_t cdeg;
+
+    for (size_t v = 0; v < sizeof(vref2) / sizeof(vref2[0]); v++)
+    {
+        for (size_t p = 0; p < sizeof(points) / sizeof(points[0]); p++)
+        {
+            ntc_state_ state = convert(gpio_uv(points[p], vref2[v]), vref2[v], &cdeg);
+            CHECK(state == NTC_OK);
+            if (fabs(cdeg / 100.0 - points[p]) > 0.25)
+            {
+                printf("%.0f degC at vref2 %ld uV: %.2f\n", points[p], (long)vref2[v], cdeg / 100.0);
+                test_failures++;
+            }
+        }
+    }
+}
+
+// every 0.01 degC against the equation on the same quantised reading, so
+// only the table interpolation and the Q16 ratio are measured
+static void test_sweep(void)
+{
+    double worst = 0;
+    int16_t cdeg;
+
+    for (int k = -4000; k <= 12500; k++)
+    {
+        int32_t gpio = gpio_uv(k / 100.0, VREF2_UV);
+        if (convert(gpio, VREF2_UV, &cdeg) != NTC_OK)
+        {
+            // only the end points may round out of the table
+            CHECK((k < -3990) || (k > 12490));
+            continue;
+        }
+        double err = fabs(cdeg / 100.0 - sh_deg(PULL_UP_OHM * gpio / (double)(VREF2_UV - gpio)));
+        if (err > worst)
+        {
+            worst = err;
+        }
+    }
+    printf("-40 to 125 degC: max |table - steinhart-hart| %.3f degC\n", worst);
+    CHECK(worst < 0.2);
+}
+
+static void test_clamps(void)
+{
+    int16_t cdeg;
+
+    // open: gpio pulled up to vref2
+    CHECK(convert(VREF2_UV, VREF2_UV, &cdeg) == NTC_OPEN);
+    CHECK(cdeg == -4000);
+    // short: gpio at ground, or a negative reading
+    CHECK(convert(10000, VREF2_UV, &cdeg) == NTC_SHORT);
+    CHECK(cdeg == 12500);
+    CHECK(convert(-1000, VREF2_UV, &cdeg) == NTC_SHORT);
+    // between the table ends and the open / short limits
+    CHECK(convert(2900000, VREF2_UV, &cdeg) == NTC_LOW);
+    CHECK(cdeg == -4000);
+    CHECK(convert(100000, VREF2_UV, &cdeg) == NTC_HIGH);
+    CHECK(cdeg == 12500);
+    // a vref2 that reads 0 must not divide by zero
+    CHECK(convert(1500000, 0, &cdeg) == NTC_OPEN);
+}
+
+static void bench(void)
+{
+    int32_t gpio[NTC_COUNT];
+    volatile int32_t sink = 0;
+    uint64_t start;
+    double lut_ns, float_ns;
+    int16_t cdeg;
+
+    for (int j = 0; j < NTC_COUNT; j++)
+    {
+        gpio[j] = gpio_uv(-20 + j * 12, VREF2_UV);
+    }
+    start = test_now_ns();
+    for (int run = 0; run < BENCH_RUNS; run++)
+    {
+        for (int j = 0; j < NTC_COUNT; j++)
+        {
+            convert(gpio[j] + (run & 7), VREF2_UV, &cdeg);
+            sink += cdeg;
+        }
+    }
+    lut_ns = (double)(test_now_ns() - start) / BENCH_RUNS;
+    start = test_now_ns();
+    for (int run = 0; run < BENCH_RUNS; run++)
+    {
+        for (int j = 0; j < NTC_COUNT; j++)
+        {
+            float ohm = 10000.0f * (float)(gpio[j] + (run & 7)) / (float)(VREF2_UV - gpio[j] - (run & 7));
+            float l = logf(ohm);
+            sink += (int32_t)(100.0f * (1.0f / (1.009249522e-3f + 2.378405444e-4f * l + 2.019202697e-7f * l * l * l) - 273.15f));
+        }
+    }
+    float_ns = (double)(test_now_ns() - start) / BENCH_RUNS;
+    printf("%d sensors: table %.0f ns, float steinhart-hart %.0f ns (host)\n", NTC_COUNT, lut_ns, float_ns);
+}
+
+int main(void)
+{
+    test_points();
+    test_sweep();
+    test_clamps();
+    bench();
+    return test_result("test_ntc");
+}
@@ -0,0 +1,83 @@
+// table driven pec10 (byte and slice-by-4) and pec15 against the bitwise
+// reference on random frames of every length up to the largest read back,
+// then a host microbenchmark of the three pec10 variants on an *ALL frame
+#include "adbms_main.h"
+#include "sim_chain.h"
+#include "test_util.h"
+
+#define FRAMES 20000
+
+static uint8_t frame[MAX_RX_SIZE + 1];
+
+static void random_frame(int len)
+{
+    for (int i = 0; i <= len; i++)
+    {
+        frame[i] = (uint8_t)rand();
+    }
+}
+
+typedef uint16_t (*pec_fn_)(int len);
+
+static uint16_t pec_bitwise(int len)
+{
+    return sim_pec10(frame, len, true, frame[len]);
+}
+
+static uint16_t pec_table(int len)
+{
+    return pec10_calc(true, len, frame);
+}
+
+static uint16_t pec_slice4(int len)
+{
+    return pec10_calc_slice4(true, len, frame);
+}
+
+// ns per frame of len bytes
+static double bench(pec_fn_ pec, int len)
+{
+    volatile uint16_t sink = 0;
+    uint64_t start = test_now_ns();
+
+    for (int i = 0; i < FRAMES; i++)
+    {
+        frame[0] = (uint8_t)i;
+        sink ^= pec(len);
+    }
+    (void)sink;
+    return (double)(test_now_ns() - start) / FRAMES;
+}
+
+int main(void)
+{
+    srand(1);
+    for (int len = 0; len <= MAX_RX_SIZE - 2; len++)
+    {
+        for (int round = 0; round < 200; round++)
+        {
+            random_frame(len);
+            uint16_t ref = sim_pec10(frame, len, true, frame[len]);
+            CHECK(pec10_calc(true, len, frame) == ref);
+            CHECK(pec10_calc_slice4(true, len, frame) == ref);
+            CHECK(pec10_calc(false, len, frame) == sim_pec10(frame, len, false, 0));
+            CHECK(pec10_calc_slice4(false, len, frame) == sim_pec10(frame, len, false, 0));
+            CHECK(Pec15_Calc((uint8_t)len, frame) == sim_pec15(frame, len));
+        }
+    }
+    // only the 6 msbs of the counter byte are covered
+    random_frame(RX_DATA - 2);
+    frame[RX_DATA - 2] &= 0xFC;
+    uint16_t pec = pec10_calc(true, RX_DATA - 2, frame);
+    frame[RX_DATA - 2] |= 0x03;
+    CHECK(pec10_calc(true, RX_DATA - 2, frame) == pec);
+
+    int len = RDCSALL_SIZE - 2;
+    random_frame(len);
+    double ns_bitwise = bench(pec_bitwise, len);
+    double ns_table = bench(pec_table, len);
+    double ns_slice4 = bench(pec_slice4, len);
+    printf("pec10 over %d bytes (host): bitwise %.1f ns, table %.1f ns (x%.1f), slice-by-4 %.1f ns (x%.1f)\n", len,
+           ns_bitwise, ns_table, ns_bitwise / ns_table, ns_slice4, ns_bitwise / ns_slice4);
+    return test_result("test_pec");
+}
@@ -0,0 +1,131 @@
+// *ALL reads are parsed and pec checked in one pass over the frame: codes,
+// per segment pec flags and the command counter of every ic against the
+// simulated chain, then the parse throughput on a replayed frame
+#include "adBms6830CmdList.h"
+#include "sim_chain.h"
+#include "test_util.h"
+
+#define BENCH_READS 20000
+
+static uint8_t last[MAX_IC][MAX_RX_SIZE]; // register data of the last read
+static cell_asic ic[MAX_IC];
+static uint8_t replay[MAX_IC * MAX_RX_SIZE];
+
+static void random_fill(uint8_t cic, const uint8_t *cmd, uint8_t *data, uint8_t len)
+{
+    (void)cmd;
+    for (uint8_t i = 0; i < len; i++)
+    {
+        data[i] = (uint8_t)rand();
+    }
+    memcpy(last[cic], data, len);
+}
+
+static void replay_respond(const uint8_t *tx, uint16_t tx_size, uint8_t *rx, uint16_t rx_size)
+{
+    (void)tx;
+    (void)tx_size;
+    if (rx != NULL)
+    {
+        memcpy(rx, replay, rx_size);
+    }
+}
+
+static int16_t code(uint8_t cic, int byte)
+{
+    return (int16_t)(last[cic][byte] | (last[cic][byte + 1] << 8));
+}
+
+static void check_codes(const int16_t *codes, uint8_t cic, int offset, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        CHECK(codes[i] == code(cic, offset + 2 * i));
+    }
+}
+
+// us per read and bus bytes per us of the driver alone, the responder only
+// copies a frame sealed once up front
+static void bench(const cmd_desc_ *cmd, const char *name)
+{
+    uint8_t size = cmd->rx_size;
+
+    for (uint8_t cic = 0; cic < MAX_IC; cic++)
+    {
+        uint8_t *frame = &replay[cic * size];
+        for (uint8_t i = 0; i < size - 2; i++)
+        {
+            frame[i] = (uint8_t)rand();
+        }
+        uint16_t pec = sim_pec10(frame, size - 2, true, 0);
+        frame[size - 2] = (uint8_t)(pec >> 8);
+        frame[size - 1] = (uint8_t)pec;
+    }
+    spiMockSetResponder(replay_respond);
+    uint64_t start = test_now_ns();
+    for (int i = 0; i < BENCH_READS; i++)
+    {
+        adBmsReadData(MAX_IC, ic, cmd);
+    }
+    double us = (double)(test_now_ns() - start) / 1000.0 / BENCH_READS;
+    uint32_t bytes = 4 + (uint32_t)size * MAX_IC;
+    printf("%-8s %2u ics, %4lu bytes: %.2f us per read, %.0f bytes/us (host)\n", name, MAX_IC, (unsigned long)bytes,
+           us, bytes / us);
+    for (uint8_t cic = 0; cic < MAX_IC; cic++)
+    {
+        CHECK(ic[cic].cccrc.cell_pec == 0);
+        CHECK(ic[cic].cccrc.aux_pec == 0);
+    }
+}
+
+int main(void)
+{
+    srand(7);
+    sim_chain_init(MAX_IC);
+    sim.fill = random_fill;
+    adBmsSetPackStore(NULL);
+
+    // move the counters off 0 so a counter parsed from the wrong byte shows
+    for (int i = 0; i < 5; i++)
+    {
+        adBmsWriteData(MAX_IC, ic, &WRCFGA);
+    }
+
+    adBmsReadData(MAX_IC, ic, &RDCVALL);
+    for (uint8_t cic = 0; cic < MAX_IC; cic++)
+    {
+        check_codes(ic[cic].cell.c_codes, cic, 0, CELL);
+        CHECK(ic[cic].cccrc.cell_pec == 0);
+        CHECK(ic[cic].cccrc.cmd_cntr == sim.cmd_cntr[cic]);
+    }
+
+    adBmsReadData(MAX_IC, ic, &RDCSALL);
+    for (uint8_t cic = 0; cic < MAX_IC; cic++)
+    {
+        check_codes(ic[cic].cell.c_codes, cic, 0, CELL);
+        check_codes(ic[cic].scell.sc_codes, cic, 32, CELL);
+        CHECK((ic[cic].cccrc.cell_pec == 0) && (ic[cic].cccrc.scell_pec == 0));
+    }
+
+    adBmsReadData(MAX_IC, ic, &RDASALL);
+    for (uint8_t cic = 0; cic < MAX_IC; cic++)
+    {
+        check_codes(ic[cic].aux.a_codes, cic, 0, 12);
+        check_codes(ic[cic].raux.ra_codes, cic, 24, 10);
+        CHECK((ic[cic].cccrc.aux_pec == 0) && (ic[cic].cccrc.raux_pec == 0) && (ic[cic].cccrc.stat_pec == 0));
+    }
+
+    // a bad pec flags every segment of that ic and no other ic
+    sim.corrupt_once = 1u << 3;
+    adBmsReadData(MAX_IC, ic, &RDCSALL);
+    for (uint8_t cic = 0; cic < MAX_IC; cic++)
+    {
+        CHECK(ic[cic].cccrc.cell_pec == (cic == 3));
+        CHECK(ic[cic].cccrc.scell_pec == (cic == 3));
+    }
+
+    bench(&RDCVALL, "RDCVALL");
+    bench(&RDCSALL, "RDCSALL");
+    bench(&RDASALL, "RDASALL");
+    return test_result("test_read_all");
+}
@@ -0,0 +1,204 @@
+// read retry of the pec failing ics only: pec errors are injected per ic
+// through the simulated chain and the retry mask, the retried reads, the
+// codes kept and marked stale in the pack store, the fault after
+// RETRY_FAULT_DEFAULT failed reads in a row and the per tick budget checked,
+// with the first read blocking and by dma
+#include "adBms6830CmdList.h"
+#include "adBms6830Retry.h"
+#include "sim_chain.h"
+#include "test_util.h"
+
+static cell_asic ic[MAX_IC];
+static pack_store_ pack;
+static uint32_t seq; // read number, every read returns new codes
+
+static int16_t cell_code(uint32_t read, uint8_t cic, int cell)
+{
+    return (int16_t)((read * 7 + cic * 100 + cell) & 0x3FFF);
+}
+
+static bool is_cmd(const uint8_t *tx, const cmd_desc_ *cmd)
+{
+    return (tx[0] == cmd->frame[0]) && (tx[1] == cmd->frame[1]);
+}
+
+static void seq_fill(uint8_t cic, const uint8_t *cmd, uint8_t *data, uint8_t len)
+{
+    int first = is_cmd(cmd, &RDCVB) ? 3 : 0;
+
+    if (cic == 0)
+    {
+        seq++;
+    }
+    for (uint8_t i = 0; i + 1 < len; i += 2)
+    {
+        int16_t code = cell_code(seq, cic, first + i / 2);
+        data[i] = (uint8_t)code;
+        data[i + 1] = (uint8_t)(code >> 8);
+    }
+}
+
+// codes of ic cic in the pack store and in cell_asic are those of read
+static bool holds(uint8_t cic, uint32_t read)
+{
+    for (int c = 0; c < CELL; c++)
+    {
+        if ((pack.cell[cic * CELL + c] != cell_code(read, cic, c)) || (ic[cic].cell.c_codes[c] != cell_code(read, cic, c)))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void test_clean(void)
+{
+    uint32_t reads = sim.reads;
+
+    adBmsRetryTick();
+    CHECK(adBmsReadRetry(MAX_IC, ic, &RDCVALL) == 0);
+    CHECK(sim.reads == reads + 1);
+    for (uint8_t cic = 0; cic < MAX_IC; cic++)
+    {
+        CHECK(holds(cic, seq));
+        CHECK(pack.cell_stale[cic] == 0);
+    }
+}
+
+// ics 6 and 11 fail the first read: one retry, parsed for those two only,
+// the others keep the codes of the first read
+static void test_partial(void)
+{
+    const retry_stats_ *stats = adBmsRetryStats();
+    uint32_t reads = sim.reads;
+    uint32_t recovered = stats->recovered_count;
+    uint32_t first;
+
+    adBmsRetryTick();
+    sim.corrupt_once = (1u << 6) | (1u << 11);
+    first = seq + 1;
+    CHECK(adBmsReadRetry(MAX_IC, ic, &RDCVALL) == 0);
+    CHECK(sim.reads == reads + 2);
+    CHECK(stats->recovered_count == recovered + 2);
+    for (uint8_t cic = 0; cic < MAX_IC; cic++)
+    {
+        CHECK(holds(cic, ((cic == 6) || (cic == 11)) ? first + 1 : first));
+        CHECK((pack.cell_stale[cic] == 0) && ((pack.pec_err[cic] & PACK_PEC_CELL) == 0));
+    }
+}
+
+// ic 5 fails every read: max_retry retries, last good codes kept and marked
+// stale, fault on the RETRY_FAULT_DEFAULT-th read in a row, not before
+static void test_stale_fault(void)
+{
+    const retry_stats_ *stats = adBmsRetryStats();
+    uint32_t faults = stats->fault_count;
+    int16_t good[CELL];
+
+    memcpy(good, &pack.cell[5 * CELL], sizeof(good));
+    sim.corrupt_always = 1u << 5;
+    for (int run = 1; run <= RETRY_FAULT_DEFAULT; run++)
+    {
+        uint32_t reads = sim.reads;
+
+        adBmsRetryTick();
+        CHECK(adBmsReadRetry(MAX_IC, ic, &RDCVALL) == (1u << 5));
+        CHECK(sim.reads == reads + 1 + RETRY_MAX_DEFAULT);
+        CHECK(adBmsRetryFaults() == ((run < RETRY_FAULT_DEFAULT) ? 0 : (1u << 5)));
+    }
+    CHECK(stats->fault_count == faults + 1);
+    CHECK(memcmp(good, &pack.cell[5 * CELL], sizeof(good)) == 0);
+    CHECK(memcmp(good, ic[5].cell.c_codes, sizeof(good)) == 0);
+    CHECK(pack.cell_stale[5] == 0xFFFF);
+    CHECK(pack.pec_err[5] & PACK_PEC_CELL);
+    CHECK(holds(4, seq - RETRY_MAX_DEFAULT) && (pack.cell_stale[4] == 0));
+}
+
+// RETRY_BUDGET_DEFAULT retries per tick over all reads: the reads after the
+// budget is used up get none and count it
+static void test_budget(void)
+{
+    const retry_stats_ *stats = adBmsRetryStats();
+    uint32_t reads = sim.reads;
+    uint32_t budget = stats->budget_count;
+    int read_count = RETRY_BUDGET_DEFAULT / RETRY_MAX_DEFAULT + 1;
+
+    adBmsRetryTick();
+    for (int i = 0; i < read_count; i++)
+    {
+        CHECK(adBmsReadRetry(MAX_IC, ic, &RDCVALL) == (1u << 5));
+    }
+    CHECK(sim.reads == reads + read_count + RETRY_BUDGET_DEFAULT);
+    CHECK(stats->budget_count == budget + 1);
+
+    // the next tick has its budget back
+    reads = sim.reads;
+    adBmsRetryTick();
+    adBmsReadRetry(MAX_IC, ic, &RDCVALL);
+    CHECK(sim.reads == reads + 1 + RETRY_MAX_DEFAULT);
+}
+
+// a good read ends the run: fault and stale bits clear
+static void test_recover(void)
+{
+    sim.corrupt_always = 0;
+    adBmsRetryTick();
+    CHECK(adBmsReadRetry(MAX_IC, ic, &RDCVALL) == 0);
+    CHECK(adBmsRetryFaults() == 0);
+    CHECK(holds(5, seq) && (pack.cell_stale[5] == 0) && ((pack.pec_err[5] & PACK_PEC_CELL) == 0));
+}
+
+// a group read failing only marks the cells of that group
+static void test_group(void)
+{
+    sim.corrupt_always = 1u << 2;
+    adBmsRetryTick();
+    CHECK(adBmsReadRetry(MAX_IC, ic, &RDCVB) == (1u << 2));
+    CHECK(pack.cell_stale[2] == 0x0038);
+    sim.corrupt_always = 0;
+    adBmsRetryTick();
+    CHECK(adBmsReadRetry(MAX_IC, ic, &RDCVB) == 0);
+    CHECK(pack.cell_stale[2] == 0);
+}
+
+// first read by dma, the failing ic retried blocking
+static void test_dma_first(void)
+{
+    uint32_t reads = sim.reads;
+    uint32_t first = seq + 1;
+
+    adBmsRetryTick();
+    sim.corrupt_once = 1u << 3;
+    CHECK(adBmsReadDataStart(MAX_IC, ic, &RDCVALL, NULL));
+    while (spiDmaBusy())
+    {
+        spiMockCompleteDma(false);
+    }
+    CHECK(adBmsReadDataFinish());
+    CHECK(adBmsRetryFailing(MAX_IC, ic, &RDCVALL) == 0);
+    CHECK(sim.reads == reads + 2);
+    CHECK(holds(3, first + 1) && holds(4, first));
+}
+
+int main(void)
+{
+    sim_chain_init(MAX_IC);
+    sim.fill = seq_fill;
+    adBmsSetPackStore(&pack);
+    adBmsRetryReset();
+
+    test_clean();
+    test_partial();
+    test_stale_fault();
+    test_budget();
+    test_recover();
+    test_group();
+    test_dma_first();
+
+    const retry_stats_ *stats = adBmsRetryStats();
+    printf("%lu reads, %lu failed, %lu retries, %lu recovered, %lu over budget, %lu faults\n",
+           (unsigned long)stats->read_count, (unsigned long)stats->fail_count, (unsigned long)stats->retry_count,
+           (unsigned long)stats->recovered_count, (unsigned long)stats->budget_count,
+           (unsigned long)stats->fault_count);
+    return test_result("test_retry");
+}
@@ -0,0 +1,182 @@
+// rate group scheduler on a simulated clock: the test calls the tick the
+// timer interrupt would call and the tasks move a fake us clock. phase plan
+// checks, release and run counts, overruns on a release still pending or
+// running, lag, budget overruns and the main loop deadline escalation
+#include "adbms_sched.h"
+#include "test_util.h"
+
+enum
+{
+    G_FAULT,
+    G_ACQ,
+    G_DRIVE,
+    G_DATA,
+    G_DIAG,
+    G_COUNT
+};
+
+static uint32_t runs[G_COUNT];
+static uint32_t clock_us;         // fake free running clock
+static uint32_t exec_us[G_COUNT]; // run time each task adds to the clock
+static uint32_t slow_ticks;       // next data run takes this many 1 ms ticks
+static uint32_t escalations;
+
+static void run_task(int group)
+{
+    runs[group]++;
+    clock_us += exec_us[group];
+    if ((group == G_DATA) && (slow_ticks != 0))
+    {
+        // the timer keeps ticking while the task runs
+        for (uint32_t t = 0; t < slow_ticks; t++)
+        {
+            clock_us += 1000;
+            ADBMS_SchedTick();
+        }
+        slow_ticks = 0;
+    }
+}
+
+static void fault_task(void) { run_task(G_FAULT); }
+static void acq_task(void) { run_task(G_ACQ); }
+static void drive_task(void) { run_task(G_DRIVE); }
+static void data_task(void) { run_task(G_DATA); }
+static void diag_task(void) { run_task(G_DIAG); }
+
+static uint32_t now_us(void) { return clock_us; }
+static uint32_t tag(void) { return 0xC0DE; }
+static void escalate(void) { escalations++; }
+
+// the plan of adbms_mainboard.c
+static sched_group_ groups[G_COUNT] = {
+    {"fault", fault_task, 1, 0, 200},
+    {"acq", acq_task, 10, 1, 3000},
+    {"drive", drive_task, 10, 6, 200},
+    {"data", data_task, 100, 3, 500},
+    {"diag", diag_task, 1000, 8, 2000},
+};
+
+static void run_ticks(uint32_t ticks)
+{
+    for (uint32_t t = 0; t < ticks; t++)
+    {
+        ADBMS_SchedTick();
+        while (ADBMS_SchedRunNext())
+        {
+        }
+    }
+}
+
+static void test_phases(void)
+{
+    sched_group_ collide[] = {{"a", acq_task, 10, 1, 0}, {"b", data_task, 100, 11, 0}};
+    sched_group_ bad_phase[] = {{"a", acq_task, 10, 10, 0}};
+
+    // 11 and 1 are the same tick modulo gcd(10, 100)
+    CHECK(!ADBMS_SchedPhasesOk(collide, 2));
+    CHECK(!ADBMS_SchedInit(collide, 2));
+    CHECK(!ADBMS_SchedPhasesOk(bad_phase, 1));
+    CHECK(ADBMS_SchedPhasesOk(groups, G_COUNT));
+}
+
+// 10 s of ticks: every group runs exactly at its rate, on its phase, never
+// two slow groups released on one tick, no lag and no overrun
+static void test_rates(void)
+{
+    CHECK(ADBMS_SchedInit(groups, G_COUNT));
+    for (uint32_t t = 0; t < 10000; t++)
+    {
+        int released = 0;
+
+        ADBMS_SchedTick();
+        for (int i = G_ACQ; i < G_COUNT; i++)
+        {
+            released += groups[i].pending;
+            if (groups[i].pending)
+            {
+                CHECK((ADBMS_SchedNow() % groups[i].period) == groups[i].phase);
+            }
+        }
+        CHECK(released <= 1);
+        while (ADBMS_SchedRunNext())
+        {
+        }
+    }
+    CHECK((runs[G_FAULT] == 10000) && (runs[G_ACQ] == 1000) && (runs[G_DRIVE] == 1000));
+    CHECK((runs[G_DATA] == 100) && (runs[G_DIAG] == 10));
+    for (int i = 0; i < G_COUNT; i++)
+    {
+        CHECK(groups[i].run_count == runs[i]);
+        CHECK((groups[i].overrun_count == 0) && (groups[i].max_lag == 0));
+    }
+}
+
+// a release still pending when the group is due again is dropped and counted,
+// the group stays on its phase
+static void test_pending_overrun(void)
+{
+    CHECK(ADBMS_SchedInit(groups, G_COUNT));
+    for (uint32_t t = 0; t < 25; t++)
+    {
+        ADBMS_SchedTick();
+    }
+    // acq released on ticks 1, 11 and 21: the first one is still pending
+    CHECK(groups[G_ACQ].overrun_count == 2);
+    CHECK(groups[G_ACQ].release_tick == 1);
+    CHECK(groups[G_FAULT].overrun_count == 24);
+    while (ADBMS_SchedRunNext())
+    {
+    }
+    CHECK(groups[G_FAULT].max_lag == 24);
+    CHECK(groups[G_ACQ].max_lag == 24);
+    run_ticks(10);
+    CHECK((groups[G_ACQ].release_tick % 10) == 1);
+    CHECK(groups[G_ACQ].overrun_count == 2);
+}
+
+// the data task runs for 250 ticks: its own next release and the fast groups
+// overrun, group 0 lags, the deadline monitor escalates once from the tick
+// and takes the budget overrun with the monitor tag
+static void test_running_overrun(void)
+{
+    const sched_monitor_ monitor = {now_us, tag, 20, escalate};
+
+    CHECK(ADBMS_SchedInit(groups, G_COUNT));
+    ADBMS_SchedMonitor(&monitor);
+    for (int i = 0; i < G_COUNT; i++)
+    {
+        exec_us[i] = 10;
+    }
+    run_ticks(200);
+    CHECK(escalations == 0);
+    CHECK(ADBMS_SchedWorst()->exec_us == 0);
+
+    slow_ticks = 250;
+    run_ticks(100);
+    CHECK(groups[G_DATA].overrun_count == 2);
+    CHECK(groups[G_FAULT].overrun_count == 249);
+    CHECK(groups[G_FAULT].max_lag == 249);
+    CHECK(escalations == 1);
+    CHECK(ADBMS_SchedEscalations() == 1);
+    CHECK(groups[G_DATA].budget_overrun_count == 1);
+    CHECK(ADBMS_SchedWorst()->group == G_DATA);
+    CHECK(ADBMS_SchedWorst()->exec_us == 250010);
+    CHECK(ADBMS_SchedWorst()->tag == 0xC0DE);
+
+    // back on time: group 0 starts again, nothing more escalates
+    run_ticks(500);
+    CHECK(escalations == 1);
+    ADBMS_SchedMonitor(NULL);
+}
+
+int main(void)
+{
+    test_phases();
+    test_rates();
+    test_pending_overrun();
+    test_running_overrun();
+    printf("fault overruns %lu, max lag %lu ticks, data overruns %lu, escalations %lu\n",
+           (unsigned long)groups[G_FAULT].overrun_count, (unsigned long)groups[G_FAULT].max_lag,
+           (unsigned long)groups[G_DATA].overrun_count, (unsigned long)escalations);
+    return test_result("test_sched");
+}
@@ -0,0 +1,129 @@
+// the packed statistics kernel against the scalar reference on random runs of
+// codes (all lengths up to STATS_MAX_COUNT, narrow, saturated and full range
+// values), the merge of split runs against one pass, then both kernels timed
+#include "adBms6830Stats.h"
+#include "test_util.h"
+
+#define FUZZ_RUNS 100000
+#define BENCH_CODES 256
+#define BENCH_RUNS 200000
+
+static int16_t codes[STATS_MAX_COUNT];
+
+static bool same(const code_stats_ *a, const code_stats_ *b)
+{
+    return (a->sum == b->sum) && (a->min == b->min) && (a->max == b->max) && (a->argmin == b->argmin) &&
+           (a->argmax == b->argmax);
+}
+
+static uint16_t fuzz_count(int run)
+{
+    // every short length first, an occasional full size run after that
+    if (run < 1000)
+    {
+        return (uint16_t)(run % 40);
+    }
+    return (uint16_t)((run % 50 == 0) ? (rand() % (STATS_MAX_COUNT + 1)) : (rand() % 300));
+}
+
+static void fuzz_fill(uint16_t count)
+{
+    int range = rand() % 4;
+
+    for (uint16_t i = 0; i < count; i++)
+    {
+        switch (range)
+        {
+        case 0: // ties everywhere, argmin / argmax must pick the first
+            codes[i] = (int16_t)(rand() % 3 - 1);
+            break;
+        case 1: // saturated codes, the sum must not wrap
+            codes[i] = (rand() & 1) ? INT16_MAX : INT16_MIN;
+            break;
+        default:
+            codes[i] = (int16_t)rand();
+            break;
+        }
+    }
+}
+
+static void test_fuzz(void)
+{
+    code_stats_ packed, scalar;
+    int bad = 0;
+
+    for (int run = 0; run < FUZZ_RUNS; run++)
+    {
+        uint16_t count = fuzz_count(run);
+
+        fuzz_fill(count);
+        adBmsCodeStats(codes, count, &packed);
+        adBmsCodeStatsScalar(codes, count, &scalar);
+        if (!same(&packed, &scalar))
+        {
+            if (bad++ < 5)
+            {
+                printf("count %u: sum %ld/%ld min %d@%u/%d@%u max %d@%u/%d@%u\n", count, (long)packed.sum,
+                       (long)scalar.sum, packed.min, packed.argmin, scalar.min, scalar.argmin, packed.max,
+                       packed.argmax, scalar.max, scalar.argmax);
+            }
+        }
+    }
+    CHECK(bad == 0);
+}
+
+// a run cut in two and merged equals the run in one pass, ties included
+static void test_merge(void)
+{
+    code_stats_ whole, merged, part;
+
+    for (int run = 0; run < 10000; run++)
+    {
+        uint16_t count = (uint16_t)(2 + rand() % 200);
+        uint16_t cut = (uint16_t)(1 + rand() % (count - 1));
+
+        fuzz_fill(count);
+        adBmsCodeStatsScalar(codes, count, &whole);
+        adBmsCodeStats(codes, cut, &merged);
+        adBmsCodeStats(&codes[cut], (uint16_t)(count - cut), &part);
+        adBmsCodeStatsMerge(&merged, &part, cut);
+        CHECK(same(&merged, &whole));
+    }
+}
+
+static void bench(void)
+{
+    code_stats_ stats;
+    volatile int32_t sink = 0;
+    uint64_t start;
+    double packed_ns, scalar_ns;
+
+    for (int i = 0; i < BENCH_CODES; i++)
+    {
+        codes[i] = (int16_t)(rand() % 20000);
+    }
+    start = test_now_ns();
+    for (int run = 0; run < BENCH_RUNS; run++)
+    {
+        adBmsCodeStats(codes, BENCH_CODES, &stats);
+        sink += stats.sum;
+    }
+    packed_ns = (double)(test_now_ns() - start) / BENCH_RUNS;
+    start = test_now_ns();
+    for (int run = 0; run < BENCH_RUNS; run++)
+    {
+        adBmsCodeStatsScalar(codes, BENCH_CODES, &stats);
+        sink += stats.sum;
+    }
+    scalar_ns = (double)(test_now_ns() - start) / BENCH_RUNS;
+    printf("%u codes: packed %.1f ns, scalar %.1f ns per call (host)\n", BENCH_CODES, packed_ns, scalar_ns);
+}
+
+int main(void)
+{
+    srand(1);
+    test_fuzz();
+    test_merge();
+    bench();
+    return test_result("test_stats");
+}
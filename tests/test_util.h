@@ -0,0 +1,37 @@
+#ifndef TEST_UTIL_H
+#define TEST_UTIL_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+// one static counter per test program, CHECK prints and counts a failed
+// condition and keeps going so one run shows every failure
+static int test_failures;
+
+#define CHECK(cond)                                                          \
+    do                                                                       \
+    {                                                                        \
+        if (!(cond))                                                         \
+        {                                                                    \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            test_failures++;                                                 \
+        }                                                                    \
+    } while (0)
+
+// exit code for main, ctest treats non-zero as a failed test
+static inline int test_result(const char *name)
+{
+    printf("%s: %s\n", name, (test_failures == 0) ? "pass" : "FAIL");
+    return (test_failures == 0) ? 0 : 1;
+}
+
+// monotonic clock for the host benchmarks, ns
+static inline uint64_t test_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+#endif
@@ -0,0 +1,158 @@
+#!/usr/bin/env python3
+"""Memory placement report for the ADI_BMS_Mainboard elf.
+
+Prints how much of FLASH, CCMRAM and RAM each output section uses, where the
+hot path objects ended up, and the largest symbols of each region. Fails the
+build when an object sits in the wrong memory: a dma buffer in CCMRAM (the
+dma controller cannot reach it) or a RAMFUNC kernel left in flash.
+
+Run as a STM32CubeIDE post-build step from the build directory:
+    python3 ${ProjDirPath}/tools/map_report.py ${ProjName}.elf
+The step is skipped when python3 is not on the path and the report when nm
+cannot be run or fails on the elf, only a placement error fails the build.
+"""
+
+import argparse
+import subprocess
+import sys
+
+# STM32F405RGTX_FLASH.ld
+REGIONS = [
+    ("FLASH", 0x08000000, 1024 * 1024),
+    ("CCMRAM", 0x10000000, 64 * 1024),
+    ("RAM", 0x20000000, 128 * 1024),
+]
+
+# output sections, by their start / end linker symbols
+SECTIONS = [
+    ("CCMRAM", ".ccmram", "_sccmram", "_eccmram"),
+    ("CCMRAM", ".ccmbss", "_sccmbss", "_eccmbss"),
+    ("RAM", ".data", "_sdata", "_edata"),
+    ("RAM", ".bss", "_sbss", "_ebss"),
+]
+
+# symbol -> memory it must be in, see CCMRAM / RAMFUNC in common.h
+PLACEMENT = [
+    # pack data store
+    ("adbms", "CCMRAM"),
+    ("ic_pool", "CCMRAM"),
+    ("pack_pool", "CCMRAM"),
+    # scheduler state
+    ("groups", "CCMRAM"),
+    ("sched_groups", "CCMRAM"),
+    ("sched_tick", "CCMRAM"),
+    ("sched_worst", "CCMRAM"),
+    # blocking spi frame buffers and pec tables
+    ("spi_rx_buffer", "CCMRAM"),
+    ("spi_tx_buffer", "CCMRAM"),
+    ("read_buffer", "CCMRAM"),
+    ("write_buffer", "CCMRAM"),
+    ("Crc15Table", "CCMRAM"),
+    ("Crc10Table", "CCMRAM"),
+    # kernels run from ram
+    ("Pec15_Calc", "RAM"),
+    ("pec10_calc", "RAM"),
+    ("pec10_calc_slice4", "RAM"),
+    ("adBmsCodeStats", "RAM"),
+    # dma buffers, must stay dma reachable
+    ("spi_dma_tx", "RAM"),
+    ("spi_dma_rx", "RAM"),
+]
+
+TOP = 8
+
+
+def region_of(addr):
+    for name, origin, length in REGIONS:
+        if origin <= addr < origin + length:
+            return name
+    return None
+
+
+def read_symbols(nm, elf):
+    out = subprocess.run([nm, "-S", elf], check=True, capture_output=True, text=True).stdout
+    symbols = {}
+    sized = []
+    for line in out.splitlines():
+        fields = line.split()
+        if len(fields) == 4:
+            addr, size, kind, name = fields
+            size = int(size, 16)
+        elif len(fields) == 3:
+            addr, kind, name = fields
+            size = 0
+        else:
+            continue
+        addr = int(addr, 16)
+        # thumb functions have bit 0 set in some tools, the code is at the even address
+        if kind in "tT":
+            addr &= ~1
+        # statics of the same name in two files are all kept and all checked
+        symbols.setdefault(name, []).append((addr, size, kind))
+        if size:
+            sized.append((name, addr, size))
+    return symbols, sized
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("elf")
+    parser.add_argument("--nm", default="arm-none-eabi-nm")
+    args = parser.parse_args()
+
+    try:
+        symbols, sized = read_symbols(args.nm, args.elf)
+    except (OSError, subprocess.CalledProcessError) as e:
+        print("map report skipped, %s: %s" % (args.nm, e))
+        return 0
+
+    def addr(name):
+        return symbols[name][0][0] if name in symbols else None
+
+    print("Memory regions")
+    used = {name: 0 for name, _, _ in REGIONS}
+    for name, sym_addr, size in sized:
+        region = region_of(sym_addr)
+        if region:
+            used[region] += size
+    for name, origin, length in REGIONS:
+        print("  %-7s %7d / %7d bytes in symbols (%5.1f %%)"
+              % (name, used[name], length, 100.0 * used[name] / length))
+
+    print("Sections")
+    for region, section, start, end in SECTIONS:
+        if addr(start) is None or addr(end) is None:
+            print("  %-8s missing (%s / %s not in the elf)" % (section, start, end))
+            continue
+        print("  %-8s %-7s 0x%08x %6d bytes" % (section, region, addr(start), addr(end) - addr(start)))
+    if addr("_estack") is not None:
+        print("  %-8s %-7s top 0x%08x" % ("stack", region_of(addr("_estack") - 1), addr("_estack")))
+
+    print("Placement")
+    errors = 0
+    for name, want in PLACEMENT:
+        if name not in symbols:
+            # inlined, or built out by the configuration
+            print("  %-20s %-7s not found" % (name, want))
+            continue
+        for sym_addr, size, _ in symbols[name]:
+            got = region_of(sym_addr)
+            ok = got == want
+            errors += not ok
+            print("  %-20s %-7s 0x%08x %6d bytes%s"
+                  % (name, got, sym_addr, size, "" if ok else "  ERROR: expected " + want))
+
+    for region, _, _ in REGIONS:
+        top = sorted((s for s in sized if region_of(s[1]) == region), key=lambda s: -s[2])[:TOP]
+        print("Largest in %s" % region)
+        for name, sym_addr, size in top:
+            print("  %-32s 0x%08x %6d bytes" % (name, sym_addr, size))
+
+    if errors:
+        print("%d object(s) in the wrong memory" % errors, file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())